@@ -6,6 +6,8 @@
 #include "xmldoc.h"
 
 #include <core/debug.h>
+#include <core/memtrack.h>
+#include <core/numparse.h>
 #include <core/strutil.h>
 
 using namespace aux;
@@ -16,49 +18,19 @@ using namespace aux;
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-//--------------------------------------------------------------------------------------------------------------------------------
-XmlObjectPool::~XmlObjectPool()
-{
-	Release();
-}
-
-//--------------------------------------------------------------------------------------------------------------------------------
-void XmlObjectPool::Release()
-{
-	m_NodeBlock = nullptr;
-	m_Remains = 0;
-
-	for (Block* block = m_Blocks; block;)
-	{
-		auto nodes = reinterpret_cast<XmlNode*>(block->data);
-		for (size_t i = 0; i < block->nodeCount; ++i)
-			nodes[i].~XmlNode();
-
-		auto p = reinterpret_cast<uint8_t*>(block);
-		m_Blocks = block = block->next;
-		delete[] p;
-	}
-}
-
 //--------------------------------------------------------------------------------------------------------------------------------
 XmlStringView XmlObjectPool::MakeString(std::wstring_view str)
 {
-	const size_t size = GetSize<wchar_t>(str.size());
-	auto out = static_cast<wchar_t*>(Allocate(size));
-	memcpy(out, str.data(), size);
-
-	return XmlStringView(out, str.size());
+	return XmlStringView(m_Arena.CopyArray(str.data(), str.size()), str.size());
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 XmlNode* XmlObjectPool::MakeNode(XmlNode* parent)
 {
-	const size_t maxCount = BLOCK_DATA_SIZE / sizeof(XmlNode);
-	if (!m_NodeBlock || m_NodeBlock->nodeCount >= maxCount)
-		m_NodeBlock = Allocate(BlockType::Nodes, maxCount);
+	// Арена не вызывает деструкторы объектов
+	static_assert(std::is_trivially_destructible_v<XmlNode>, "XmlNode must be trivially destructible");
 
-	XmlNode* nodes = reinterpret_cast<XmlNode*>(m_NodeBlock->data);
-	return new(nodes + m_NodeBlock->nodeCount++) XmlNode(parent);
+	return m_Arena.New<XmlNode>(this, parent);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -68,7 +40,7 @@ auto XmlObjectPool::MakeArray(Iter first, size_t count)
 	using T = typename Iter::value_type;
 	static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types are allowed");
 
-	auto items = static_cast<T*>(Allocate(GetSize<T>(count)));
+	auto items = m_Arena.AllocateArray<T>(count);
 
 	auto it = first;
 	for (size_t i = 0; i < count; ++i, ++it)
@@ -77,79 +49,6 @@ auto XmlObjectPool::MakeArray(Iter first, size_t count)
 	return XmlArrayView<T>(items, count);
 }
 
-//--------------------------------------------------------------------------------------------------------------------------------
-template<class T>
-constexpr size_t XmlObjectPool::GetSize(size_t itemCount)
-{
-	return (itemCount <= size_t(-1) / sizeof(T)) ?
-		itemCount * sizeof(T) : size_t(-1);
-}
-
-//--------------------------------------------------------------------------------------------------------------------------------
-XmlObjectPool::Block* XmlObjectPool::Allocate(BlockType itemType, size_t itemCount)
-{
-	constexpr size_t mask = sizeof(size_t) - 1;
-	constexpr size_t headerSize = offsetof(Block, data);
-	constexpr size_t maxSize = ~mask - headerSize;
-
-	switch (itemType)
-	{
-		case BlockType::Bytes:
-			if (itemCount > maxSize)
-				throw std::bad_alloc();
-			itemCount = (itemCount + mask) & ~mask;
-			break;
-		case BlockType::Nodes:
-			if (itemCount > maxSize / sizeof(XmlNode))
-				throw std::bad_alloc();
-			itemCount *= sizeof(XmlNode);
-			break;
-	};
-	auto p = new uint8_t[headerSize + itemCount];
-	auto block = reinterpret_cast<Block*>(p);
-
-	block->next = m_Blocks;
-	block->nodeCount = 0;
-	m_Blocks = block;
-
-	return block;
-}
-
-//--------------------------------------------------------------------------------------------------------------------------------
-void* XmlObjectPool::Allocate(size_t sizeInBytes)
-{
-	void* out = nullptr;
-	if (sizeInBytes)
-	{
-		constexpr size_t mask = sizeof(size_t) - 1;
-		constexpr size_t headerSize = offsetof(Block, data);
-		static_assert(!(BLOCK_DATA_SIZE & mask), "BLOCK_DATA_SIZE must be a multiple of 8");
-		static_assert(!(headerSize & mask), "Block::data must be aligned at 8 bytes");
-
-		const size_t alignedSize = (sizeInBytes + mask) & ~mask;
-
-		if (sizeInBytes <= m_Remains)
-		{
-			out = m_Data;
-			m_Data += alignedSize;
-			m_Remains -= alignedSize;
-		}
-		else if (sizeInBytes < BLOCK_DATA_SIZE / 16)
-		{
-			auto block = Allocate(BlockType::Bytes, BLOCK_DATA_SIZE);
-			out = block->data;
-			m_Data = block->data + alignedSize;
-			m_Remains = BLOCK_DATA_SIZE - alignedSize;
-		} else
-		{
-			auto block = Allocate(BlockType::Bytes, sizeInBytes);
-			out = block->data;
-		}
-	}
-
-	return out;
-}
-
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //   XmlNode
@@ -157,8 +56,9 @@ void* XmlObjectPool::Allocate(size_t sizeInBytes)
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 //--------------------------------------------------------------------------------------------------------------------------------
-XmlNode::XmlNode(XmlNode* parent)
-	: m_Parent(parent)
+XmlNode::XmlNode(const XmlObjectPool* pool, XmlNode* parent)
+	: m_Pool(pool)
+	, m_Parent(parent)
 {
 }
 
@@ -196,19 +96,43 @@ std::wstring_view XmlNode::Attr(std::wstring_view name) const
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-int XmlNode::Attr(std::wstring_view name, int def) const
+template<class T>
+T XmlNode::NumAttr(std::wstring_view name, T def) const
 {
 	if (auto i = FindAttr(name); i != NPOS)
 	{
-		int result;
-		const XmlStringView& v = m_Attributes[i].value;
-		if (NumDecoder::Decode(v.data, v.data + v.size, result))
+		T result;
+		if (util::ParseNumber(m_Attributes[i].value, result) == util::NumParse::Ok)
 			return result;
 	}
 
 	return def;
 }
 
+//--------------------------------------------------------------------------------------------------------------------------------
+int XmlNode::Attr(std::wstring_view name, int def) const
+{
+	return NumAttr(name, def);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+int64_t XmlNode::Attr(std::wstring_view name, int64_t def) const
+{
+	return NumAttr(name, def);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+double XmlNode::Attr(std::wstring_view name, double def) const
+{
+	return NumAttr(name, def);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+float XmlNode::Attr(std::wstring_view name, float def) const
+{
+	return NumAttr(name, def);
+}
+
 //--------------------------------------------------------------------------------------------------------------------------------
 bool XmlNode::Attr(std::wstring_view name, bool def) const
 {
@@ -239,7 +163,7 @@ void XmlNode::ForEachAttr(const std::function<void(std::wstring_view, std::wstri
 		for (size_t i = 0, count = m_Attributes.size(); i < count; ++i)
 		{
 			const auto& attr = m_Attributes[i];
-			cb(attr.name, attr.value);
+			cb(m_Pool->GetName(attr.name), attr.value);
 		}
 	}
 }
@@ -247,14 +171,14 @@ void XmlNode::ForEachAttr(const std::function<void(std::wstring_view, std::wstri
 //--------------------------------------------------------------------------------------------------------------------------------
 size_t XmlNode::FindAttr(std::wstring_view name) const
 {
-	if (!name.empty())
+	// Имя ищется в таблице имён один раз, дальше сравниваются атомы. Если имени в таблице нет (в том числе если оно
+	// пустое), то и атрибута с таким именем нет. Среднее количество атрибутов среди всех узлов с атрибутами обычно
+	// небольшое (в среднем не превышает 4), поэтому линейный поиск здесь не хуже бинарного
+	if (const util::Atom atom = m_Pool->FindName(name); !atom.IsEmpty())
 	{
-		// Сейчас используется линейный поиск со сравнением строк. Это не плохо. Среднее количество атрибутов среди
-		// всех узлов с атрибутами обычно небольшое (в среднем не превышает 4). Поэтому бинарный поиск не даст эффекта.
-		// Также, тест показал, что добавление хеша имени снижает и скорость загрузки, и скорость работы с атрибутами
 		for (size_t i = 0, count = m_Attributes.size(); i < count; ++i)
 		{
-			if (m_Attributes[i].name == name)
+			if (m_Attributes[i].name == atom)
 				return i;
 		}
 	}
@@ -265,16 +189,15 @@ size_t XmlNode::FindAttr(std::wstring_view name) const
 //--------------------------------------------------------------------------------------------------------------------------------
 size_t XmlNode::FindNode(std::wstring_view name) const
 {
-	if (!name.empty())
+	// TODO: сейчас используется линейный поиск со сравнением атомов имён. Возможно, стоит завести массив отсортированных
+	// индексов (так как сам массив нод сортировать нельзя) и использовать бинарный поиск по атому. Но обычно количество
+	// вложенных узлов небольшое. А для тех узлов, которые имеют много вложенных, мы обычно используем доступ через индекс,
+	// а не поиск по имени. Поэтому бинарный поиск пока не реализован
+	if (const util::Atom atom = m_Pool->FindName(name); !atom.IsEmpty())
 	{
-		// TODO: сейчас используется линейный поиск со сравнением строк. Возможно, стоит завести массив отсортированных
-		// индексов (так как сам массив нод сортировать нельзя) и использовать бинарный поиск (и, возможно, стоит также
-		// использовать хеш имени в качестве ключа, чтобы было меньше сравнений строк). Но обычно количество вложенных
-		// узлов небольшое. А для тех узлов, которые имеют много вложенных, мы обычно используем доступ через индекс,
-		// а не поиск по имени. Поэтому бинарный поиск с хешем имени пока не реализованы
 		for (size_t i = 0, count = m_Nodes.size(); i < count; ++i)
 		{
-			if (m_Nodes[i]->m_Name == name)
+			if (m_Nodes[i]->m_Name == atom)
 				return i;
 		}
 	}
@@ -289,8 +212,10 @@ size_t XmlNode::FindNode(std::wstring_view name) const
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 //--------------------------------------------------------------------------------------------------------------------------------
-XmlDocument::XmlDocument()
+XmlDocument::XmlDocument(std::pmr::memory_resource* resource)
+	: m_Pool(resource)
 {
+	util::MemTag tag("XmlDocument");
 	m_Root = m_Pool.MakeNode();
 }
 
@@ -319,6 +244,7 @@ bool XmlDocument::Load(util::File& file)
 //--------------------------------------------------------------------------------------------------------------------------------
 template<class T> bool XmlDocument::LoadFrom(T& source)
 {
+	util::MemTag tag("XmlDocument");
 	Clear();
 
 	Info info;
@@ -384,7 +310,7 @@ void XmlDocument::OnTagOpened(void* infoPtr, std::wstring_view name)
 
 			auto& pool = info->self->m_Pool;
 			auto node = pool.MakeNode(info->node);
-			node->m_Name = pool.MakeString(name);
+			node->m_Name = pool.MakeName(name);
 
 			info->bufferedNodes.push_back(node);
 			info->nodeStack.push_back(info->bufferedNodes.size());
@@ -410,7 +336,7 @@ void XmlDocument::OnTagClosed(void* infoPtr, std::wstring_view name)
 			if (info->node == info->self->m_Root)
 				return;
 		}
-		else if (info->node->m_Name != name)
+		else if (info->node->Name() != name)
 		{
 			OnError(*info, L"Unpaired closing tag encountered");
 			return;
@@ -434,7 +360,7 @@ void XmlDocument::OnAttr(void* infoPtr, std::wstring_view name, std::wstring_vie
 		if (info->node != info->self->m_Root && Verify(!name.empty()))
 		{
 			auto& pool = info->self->m_Pool;
-			info->attributes.emplace_back(pool.MakeString(name), pool.MakeString(value));
+			info->attributes.emplace_back(pool.MakeName(name), pool.MakeString(value));
 		}
 	}
 }
@@ -6,7 +6,9 @@
 
 #include "xmlreader.h"
 
+#include <core/arena.h>
 #include <core/forward.h>
+#include <core/intern.h>
 #include <core/platform.h>
 #include <core/strcommon.h>
 #include <core/util.h>
@@ -59,23 +61,41 @@ protected:
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Класс XmlObjectPool выделяет память под объекты документа в арене (см. util::Arena), блоки которой выделяются через
+// источник памяти resource. Все объекты, которые создаются в пуле, должны иметь тривиальные деструкторы (в том числе XmlNode).
+// Имена элементов и атрибутов, которые в документе обычно многократно повторяются, хранятся в таблице уникальных строк,
+// а узлы хранят их атомы (см. util::Atom), поэтому при поиске по имени сравниваются не строки, а атомы
+
 //--------------------------------------------------------------------------------------------------------------------------------
 class XmlObjectPool
 {
 	AML_NONCOPYABLE(XmlObjectPool)
 
 public:
-	XmlObjectPool() = default;
-	~XmlObjectPool();
+	explicit XmlObjectPool(std::pmr::memory_resource* resource = nullptr) noexcept
+		: m_Arena(util::Arena::DEFAULT_BLOCK_SIZE, resource)
+		, m_Names(NAMES_BLOCK_SIZE, resource)
+	{
+	}
 
-	// Вызывает деструкторы всех созданных объектов
-	// XmlNode и освобождает всю выделенную память
-	void Release();
+	// Освобождает всю выделенную память
+	void Release() noexcept
+	{
+		m_Names.Clear();
+		m_Arena.Release();
+	}
 
 	// Выделяет в пуле пространство для указанной строки,
 	// копирует её в пул и возвращает вью на неё в пуле
 	XmlStringView MakeString(std::wstring_view str);
 
+	// Добавляет имя name в таблицу имён пула (одинаковые имена хранятся один раз) и возвращает его атом
+	util::Atom MakeName(std::wstring_view name) { return m_Names.Intern(name); }
+	// Возвращает атом имени name или пустой атом, если такого имени в таблице нет
+	util::Atom FindName(std::wstring_view name) const noexcept { return m_Names.Find(name); }
+	// Возвращает имя, соответствующее атому name
+	std::wstring_view GetName(util::Atom name) const noexcept { return m_Names.GetString(name); }
+
 	// Выделяет в пуле память под объект XmlNode, вызывает его конструктор
 	// и возвращает указатель на объект (владельцем объекта является пул)
 	XmlNode* MakeNode(XmlNode* parent = nullptr);
@@ -86,36 +106,11 @@ public:
 	template<class Iter> auto MakeArray(Iter first, size_t count);
 
 protected:
-	// Стандартный размер массива Block::data (в байтах)
-	static constexpr size_t BLOCK_DATA_SIZE = 32 * 1024;
+	// Размер блоков арены таблицы имён (имён в документе обычно немного)
+	static constexpr size_t NAMES_BLOCK_SIZE = 4096;
 
-	enum class BlockType {
-		Bytes,	// Универсальный массив (uint8_t)
-		Nodes	// Массив узлов XML (XmlNode)
-	};
-
-	struct Block {
-		Block* next;			// Указатель на следующий блок в списке
-		size_t nodeCount;		// Количество созданных объектов XmlNode в data
-		uint8_t data[1024];		// Данные (реальный размер массива будет другим)
-	};
-
-	// Возвращает размер в байтах массива из itemCount элементов типа T. Если результат
-	// выходит за пределы диапазона типа size_t, то функция вернёт значение size_t(-1)
-	template<class T> static constexpr size_t GetSize(size_t itemCount);
-
-	// Выделяет в куче новый блок, добавляет его в список m_Blocks и возвращает указатель на
-	// блок. Параметр itemType задаёт тип, а itemCount - количество элементов в массиве data
-	Block* Allocate(BlockType itemType, size_t itemCount);
-	// Выделяет в текущем общем блоке массив размера sizeInBytes байт и возвращает указатель на начало
-	// выделенной области. Если в текущем блоке недостаточно места, то будет выделен новый общий блок
-	void* Allocate(size_t sizeInBytes);
-
-protected:
-	Block* m_Blocks = nullptr;		// Односвязный список блоков пула
-	Block* m_NodeBlock = nullptr;	// Текущий блок для выделения памяти под узлы
-	uint8_t* m_Data = nullptr;		// Указатель на начало свободной области текущего общего блока
-	size_t m_Remains = 0;			// Размер свободной области текущего общего блока в байтах
+	util::Arena m_Arena;
+	util::BasicInternTable<wchar_t, 1, false> m_Names;	// Таблица имён (используется только одним потоком)
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -131,9 +126,9 @@ class XmlNode
 	AML_NONCOPYABLE(XmlNode)
 
 public:
-	explicit XmlNode(XmlNode* parent);
+	XmlNode(const XmlObjectPool* pool, XmlNode* parent);
 
-	std::wstring_view Name() const { return m_Name; }
+	std::wstring_view Name() const { return m_Pool->GetName(m_Name); }
 	std::wstring_view Data() const { return m_Data; }
 
 	// Возвращает указатель на родительский узел
@@ -158,9 +153,13 @@ public:
 	// Возвращает строковое значение атрибута с именем name. Если
 	// атрибута с этим именем нет, то функция вернёт пустую строку
 	std::wstring_view Attr(std::wstring_view name) const;
-	// Возвращает значение атрибута name типа int. Если атрибута с этим именем нет или его
-	// значение не может быть корректно преобразовано в int, функция вернёт значение def
+	// Возвращают значение атрибута name типа int, int64_t, double или float. Если атрибута с этим именем нет, его
+	// значение не является числом этого типа или выходит за пределы диапазона типа, то функция вернёт значение def.
+	// Значение разбирается функцией util::ParseNumber (разделителем дробной части всегда является точка)
 	int Attr(std::wstring_view name, int def) const;
+	int64_t Attr(std::wstring_view name, int64_t def) const;
+	double Attr(std::wstring_view name, double def) const;
+	float Attr(std::wstring_view name, float def) const;
 	// Возвращает значение атрибута name как bool. Строковое значение атрибута "true" (без учёта
 	// регистра) соответствует значению true, а "false" - false. Если атрибута с этим именем нет
 	// или его строковое значение не равно "true" или "false", то функция вернёт значение def
@@ -174,24 +173,28 @@ protected:
 
 	struct Attribute
 	{
-		XmlStringView name;		// Имя атрибута
+		util::Atom name;		// Атом имени атрибута (в таблице имён пула)
 		XmlStringView value;	// Значение атрибута
 
-		Attribute(XmlStringView n, XmlStringView v)
+		Attribute(util::Atom n, XmlStringView v)
 			: name(n), value(v) {}
 	};
 
 	// Находит индекс в массиве m_Attributes для атрибута с именем name.
 	// Если атрибута с этим именем нет, то функция вернёт значение NPOS
 	size_t FindAttr(std::wstring_view name) const;
+	// Возвращает значение атрибута name как число типа T или def (см. Attr)
+	template<class T>
+	T NumAttr(std::wstring_view name, T def) const;
 	// Находит индекс в массиве m_Nodes для узла с именем name. Если
 	// узла с этим именем нет, то функция вернёт значение NPOS
 	size_t FindNode(std::wstring_view name) const;
 
 protected:
+	const XmlObjectPool* m_Pool;	// Пул документа (в нём хранятся имена узлов и атрибутов)
 	XmlNode* m_Parent = nullptr;
 
-	XmlStringView m_Name;
+	util::Atom m_Name;
 	XmlStringView m_Data;
 	XmlArrayView<XmlNode*> m_Nodes;
 	XmlArrayView<Attribute> m_Attributes;
@@ -209,7 +212,9 @@ class XmlDocument
 	AML_NONCOPYABLE(XmlDocument)
 
 public:
-	XmlDocument();
+	// Память для узлов и строк документа выделяется через источник памяти resource
+	// (если он равен nullptr, то через источник по умолчанию, см. util::GetDefaultResource)
+	explicit XmlDocument(std::pmr::memory_resource* resource = nullptr);
 
 	void Clear();
 
@@ -7,6 +7,7 @@
 
 #include <core/debug.h>
 #include <core/file.h>
+#include <core/numparse.h>
 #include <core/strutil.h>
 
 namespace aux {
@@ -17,92 +18,16 @@ namespace aux {
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// TODO: сейчас в классе NumDecoder всего 2 функции: для декодирования десятичного числа в тип int и шестнадцатеричного
-// числа в тип unsigned. В будущем мы захотим читать значения атрибутов XML других типов (например, [u]int64_t). Поэтому
-// функцию Decode лучше сделать шаблонной, чтобы она умела работать с любым целочисленным типом. Также в C++17 появилась
-// функция from_chars: она работает только с типом char* (что неудобно), зато её можно использовать для типа float
-
 //--------------------------------------------------------------------------------------------------------------------------------
 bool NumDecoder::Decode(const wchar_t* from, const wchar_t* to, int& value)
 {
-	if (from >= to)
-		return false;
-
-	bool negative = false;
-	if (*from == '-')
-	{
-		negative = true;
-		if (++from == to)
-			return false;
-	}
-
-	for (size_t remains = to - from; remains >= 10; --remains)
-	{
-		if (*from == '0')
-			++from;
-		else if (remains > 10 || IsGreater(from, negative ? "2147483648" : "2147483647"))
-			return false;
-		else
-			break;
-	}
-
-	for (unsigned v, result = 0;;)
-	{
-		if (v = static_cast<unsigned>(*from) - '0'; v > 9)
-			return false;
-
-		result = 10 * result + v;
-
-		if (++from == to)
-		{
-			value = negative ? 0 - result : result;
-			return true;
-		}
-	}
+	return from < to && util::ParseInteger(from, to, value, 10) == util::NumParse::Ok;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 bool NumDecoder::DecodeHex(const wchar_t* from, const wchar_t* to, unsigned& value)
 {
-	if (from >= to)
-		return false;
-
-	for (size_t remains = to - from; remains > 8; --remains)
-	{
-		if (*from++ != '0')
-			return false;
-	}
-
-	unsigned result = 0;
-	for (unsigned v; from < to; ++from)
-	{
-		if (v = static_cast<unsigned>(*from) - '0'; v <= 9)
-			result = (result << 4) + v;
-		else if (v -= (v < 49) ? 17 : 49; v <= 5)
-			result = (result << 4) + v + 10;
-		else
-			return false;
-	}
-
-	value = result;
-	return true;
-}
-
-//--------------------------------------------------------------------------------------------------------------------------------
-inline bool NumDecoder::IsGreater(const wchar_t* lhs, const char* rhs)
-{
-	for (; *rhs; ++lhs, ++rhs)
-	{
-		auto l = static_cast<unsigned>(*lhs);
-		auto r = static_cast<unsigned char>(*rhs);
-
-		if (l != r)
-		{
-			return l > r;
-		}
-	}
-
-	return false;
+	return from < to && util::ParseInteger(from, to, value, 16) == util::NumParse::Ok;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -31,11 +31,6 @@ struct NumDecoder
 	// Декодирует строку, содержащую целое шестнадцатеричное число, и сохраняет его в value. Функция
 	// вернёт true, если строка содержит корректное число и оно умещается в переменной типа unsigned
 	static bool DecodeHex(const wchar_t* from, const wchar_t* to, unsigned& value);
-
-protected:
-	// Возвращает true, если число во from больше числа в num. Строка num
-	// должна быть null-терминированной, а длины строк from и num - равны
-	static bool IsGreater(const wchar_t* from, const char* num);
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
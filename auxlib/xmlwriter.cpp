@@ -8,6 +8,7 @@
 #include <core/debug.h>
 #include <core/file.h>
 #include <core/strutil.h>
+#include <core/utf.h>
 
 using namespace aux;
 
@@ -246,16 +247,15 @@ void XmlWriter::InitEscapeTable()
 //--------------------------------------------------------------------------------------------------------------------------------
 std::string_view XmlWriter::ToUtf8(std::wstring_view str, EscapeSet escapeSet)
 {
-	if (str.size() > m_Array.GetSize() / 4)
+	if (str.size() > m_Array.GetSize() / util::MAX_UTF8_PER_WIDE)
 	{
-		// Вычисляем точный необходимый размер буфера, только если размер строки больше 1/4 размера массива.
-		// Мы можем это делать, потому что 1 символ исходной строки становится 1-4 байтами в результирующей
-		if (int requiredSize = util::ToUtf8(nullptr, 0, str); requiredSize > 0)
-			m_Array.Grow(requiredSize);
+		// Вычисляем точный необходимый размер буфера, только если массива может не хватить. Каждый
+		// символ исходной строки становится не более чем MAX_UTF8_PER_WIDE байтами в результирующей
+		m_Array.Grow(util::Utf8LengthOf(str));
 	}
 
 	// Конвертируем строку в UTF-8
-	int size = util::ToUtf8(m_Array, m_Array.GetSize(), str);
+	int size = static_cast<int>(util::WideToUtf8(m_Array, m_Array.GetSize(), str.data(), str.size()));
 
 	// Экранируем строку, если нужно
 	if (escapeSet > EscapeSet::Empty)
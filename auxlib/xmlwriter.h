@@ -14,7 +14,6 @@
 #include <string_view>
 #include <type_traits>
 #include <utility>
-#include <vector>
 
 namespace aux {
 
@@ -86,6 +85,7 @@ protected:
 
 	using Array = util::FlexibleArray<char>;
 	using Buffer = util::Formatter<char, 8>;
+	using TagStack = util::SmallVector<TagInfo, 16>;
 
 	bool WriteDeclaration();
 	void WritePadding(bool newLine, int offset = 0);
@@ -104,7 +104,7 @@ protected:
 
 protected:
 	util::File* m_Output = nullptr;		// Связанный файл
-	std::vector<TagInfo> m_NestedTags;	// Иерархия элементов
+	TagStack m_NestedTags;				// Иерархия элементов
 
 	Array m_Array;						// Буфер для конвертации в UTF-8
 	Buffer m_Buffer;					// Буфер вывода (для формирования строк)
@@ -0,0 +1,124 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "arena.h"
+
+using namespace util;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Arena
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Arena::Arena(size_t blockSize, std::pmr::memory_resource* resource) noexcept
+	// Слишком маленькие блоки не имеют смысла: почти все запросы будут "большими"
+	: m_BlockSize((std::max<size_t>)(blockSize, 1024))
+	, m_Resource(GetResource(resource))
+{
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Arena::~Arena()
+{
+	Release();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Arena::Rewind(const Checkpoint& checkpoint) noexcept
+{
+	while (m_LargeBlocks != checkpoint.largeBlocks)
+	{
+		Block* block = m_LargeBlocks;
+		m_LargeBlocks = block->next;
+		DeleteBlock(block);
+	}
+
+	SetCurrent(checkpoint.block, checkpoint.pos);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Arena::Reset() noexcept
+{
+	Rewind({ nullptr, nullptr, nullptr });
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Arena::Release() noexcept
+{
+	Reset();
+
+	while (m_Blocks)
+	{
+		Block* block = m_Blocks;
+		m_Blocks = block->next;
+		DeleteBlock(block);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void* Arena::AllocateSlow(size_t size, size_t alignment)
+{
+	const size_t maxSmallSize = m_BlockSize / 4;
+	if (size > maxSmallSize || alignment > maxSmallSize)
+	{
+		// Данные блока выровнены по границе alignof(std::max_align_t). Для большего
+		// выравнивания нам потребуется дополнительное место в начале блока
+		const size_t padding = (alignment > alignof(std::max_align_t)) ? alignment : 0;
+		if (size > size_t(-1) - sizeof(Block) - padding)
+			throw std::bad_alloc();
+
+		Block* block = NewBlock(size + padding);
+		block->next = m_LargeBlocks;
+		m_LargeBlocks = block;
+
+		const uintptr_t pos = reinterpret_cast<uintptr_t>(block->GetData());
+		return reinterpret_cast<void*>((pos + alignment - 1) & ~(alignment - 1));
+	}
+
+	// Блоки, следующие за текущим, остались после вызова функций
+	// Reset или Rewind. Если такой блок есть, используем его повторно
+	Block* block = m_Current ? m_Current->next : m_Blocks;
+	if (!block)
+	{
+		block = NewBlock(m_BlockSize);
+		block->next = nullptr;
+		if (m_Current)
+			m_Current->next = block;
+		else
+			m_Blocks = block;
+	}
+
+	// Запрос не больше четверти блока, поэтому в новом
+	// (пустом) текущем блоке для него всегда хватит места
+	SetCurrent(block, block->GetData());
+	return Allocate(size, alignment);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Arena::Block* Arena::NewBlock(size_t size)
+{
+	auto block = static_cast<Block*>(m_Resource->allocate(sizeof(Block) + size, alignof(Block)));
+	block->size = size;
+
+	m_AllocatedSize += sizeof(Block) + size;
+	return block;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Arena::DeleteBlock(Block* block) noexcept
+{
+	m_AllocatedSize -= sizeof(Block) + block->size;
+	m_Resource->deallocate(block, sizeof(Block) + block->size, alignof(Block));
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Arena::SetCurrent(Block* block, uint8_t* pos) noexcept
+{
+	m_Current = block;
+	m_Pos = pos;
+	m_End = block ? block->GetData() + block->size : nullptr;
+}
@@ -0,0 +1,222 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "memory.h"
+#include "platform.h"
+#include "util.h"
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <string.h>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Arena - монотонный (линейный) распределитель памяти
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс Arena выделяет память из больших блоков простым смещением указателя на начало свободной области. Освободить
+// отдельный участок памяти нельзя: вся память освобождается разом (функции Reset, Release), либо до ранее сохранённой
+// контрольной точки (функция Rewind). Функция Reset не возвращает блоки в кучу, а оставляет их для повторного
+// использования, поэтому при многократной обработке однотипных запросов память в куче выделяется только в начале.
+// Деструкторы объектов, созданных в арене, не вызываются, поэтому в ней можно создавать только объекты
+// тривиально разрушаемых типов. Класс не является потокобезопасным
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class Arena final
+{
+	AML_NONCOPYABLE(Arena)
+
+	struct Block;
+
+public:
+	// Стандартный размер блока (в байтах)
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 32 * 1024;
+
+	// Контрольная точка (состояние арены на момент вызова функции GetCheckpoint)
+	struct Checkpoint {
+		Block* block;		// Текущий блок
+		uint8_t* pos;		// Начало свободной области текущего блока
+		Block* largeBlocks;	// Начало списка больших блоков
+	};
+
+	// Параметр blockSize задаёт размер блоков (в байтах), выделяемых в куче. Запросы, размер которых
+	// больше четверти размера блока, удовлетворяются выделением в куче отдельного блока нужного размера.
+	// Блоки выделяются через источник памяти resource (если он равен nullptr, то через источник памяти
+	// по умолчанию, см. GetDefaultResource)
+	explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE, std::pmr::memory_resource* resource = nullptr) noexcept;
+	~Arena();
+
+	// Выделяет участок памяти размером size байт, выровненный по границе alignment
+	// (должно быть степенью 2). Если память выделить невозможно, выбрасывает std::bad_alloc
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+	{
+		const uintptr_t pos = (reinterpret_cast<uintptr_t>(m_Pos) + alignment - 1) & ~(alignment - 1);
+		if (pos <= reinterpret_cast<uintptr_t>(m_End) && size <= reinterpret_cast<uintptr_t>(m_End) - pos)
+		{
+			m_Pos = reinterpret_cast<uint8_t*>(pos + size);
+			return reinterpret_cast<void*>(pos);
+		}
+
+		return AllocateSlow(size, alignment);
+	}
+
+	// Выделяет память под массив из count элементов типа T (элементы не инициализируются)
+	template<class T> T* AllocateArray(size_t count)
+	{
+		if (count > size_t(-1) / sizeof(T))
+			throw std::bad_alloc();
+		return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	// Выделяет память под массив из count элементов типа T и копирует в него count элементов из items
+	template<class T> T* CopyArray(const T* items, size_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types are allowed");
+
+		T* out = AllocateArray<T>(count);
+		if (count)
+			memcpy(out, items, count * sizeof(T));
+		return out;
+	}
+
+	// Копирует строку str в арену и возвращает вью на неё (в конец строки добавляется нулевой символ)
+	template<class T> std::basic_string_view<T> CopyString(std::basic_string_view<T> str)
+	{
+		T* out = AllocateArray<T>(str.size() + 1);
+		memcpy(out, str.data(), str.size() * sizeof(T));
+		out[str.size()] = 0;
+		return std::basic_string_view<T>(out, str.size());
+	}
+
+	// Выделяет память под объект типа T и вызывает его конструктор с аргументами args
+	template<class T, class... Args> T* New(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Only trivially destructible types are allowed");
+		return new(Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	// Возвращает текущее состояние арены для последующего вызова функции Rewind
+	Checkpoint GetCheckpoint() const noexcept { return { m_Current, m_Pos, m_LargeBlocks }; }
+	// Возвращает арену в состояние, сохранённое функцией GetCheckpoint. Вся память, выделенная после
+	// этого, становится свободной (блоки стандартного размера остаются в арене для повторного использования)
+	void Rewind(const Checkpoint& checkpoint) noexcept;
+
+	// Делает свободной всю выделенную память. Блоки стандартного размера
+	// не освобождаются, а будут использованы повторно для новых запросов
+	void Reset() noexcept;
+	// Освобождает все блоки памяти
+	void Release() noexcept;
+
+	// Возвращает общий размер блоков в куче, принадлежащих арене (в байтах)
+	size_t GetAllocatedSize() const noexcept { return m_AllocatedSize; }
+
+private:
+	struct alignas(std::max_align_t) Block {
+		Block* next;	// Указатель на следующий блок в списке
+		size_t size;	// Размер данных блока в байтах (данные следуют сразу за заголовком)
+
+		uint8_t* GetData() noexcept { return reinterpret_cast<uint8_t*>(this + 1); }
+	};
+
+	AML_NOINLINE void* AllocateSlow(size_t size, size_t alignment);
+
+	Block* NewBlock(size_t size);
+	void DeleteBlock(Block* block) noexcept;
+
+	// Делает блок block текущим (свободная область начинается с позиции pos)
+	void SetCurrent(Block* block, uint8_t* pos) noexcept;
+
+private:
+	Block* m_Blocks = nullptr;			// Список блоков стандартного размера (в порядке их использования)
+	Block* m_Current = nullptr;			// Текущий блок из списка m_Blocks
+	Block* m_LargeBlocks = nullptr;		// Список больших блоков (новые блоки добавляются в начало)
+	uint8_t* m_Pos = nullptr;			// Указатель на начало свободной области текущего блока
+	uint8_t* m_End = nullptr;			// Указатель на конец текущего блока
+	size_t m_BlockSize;					// Размер данных блока стандартного размера
+	size_t m_AllocatedSize = 0;			// Общий размер всех блоков (включая заголовки)
+	std::pmr::memory_resource* m_Resource;	// Источник памяти для блоков
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   ArenaScope - восстановление состояния арены при выходе из области видимости
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Объект ArenaScope сохраняет состояние арены при создании и восстанавливает его в деструкторе, освобождая всю
+// память, выделенную за время своего существования. Пример: { util::ArenaScope scope(arena); ProcessRequest(arena); }
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class ArenaScope final
+{
+	AML_NONCOPYABLE(ArenaScope)
+
+public:
+	explicit ArenaScope(Arena& arena) noexcept
+		: m_Arena(arena)
+		, m_Checkpoint(arena.GetCheckpoint())
+	{
+	}
+
+	~ArenaScope()
+	{
+		m_Arena.Rewind(m_Checkpoint);
+	}
+
+private:
+	Arena& m_Arena;
+	Arena::Checkpoint m_Checkpoint;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   ArenaResource - адаптер арены для полиморфных аллокаторов STL
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс ArenaResource позволяет контейнерам STL выделять память в арене, например:
+// util::ArenaResource resource(arena); std::pmr::vector<int> v(&resource);
+// Освобождение памяти контейнером ничего не делает: память вернётся в арену при её очистке
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class ArenaResource final : public std::pmr::memory_resource
+{
+public:
+	explicit ArenaResource(Arena& arena) noexcept
+		: m_Arena(arena)
+	{
+	}
+
+	Arena& GetArena() const noexcept { return m_Arena; }
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		// Для запроса нулевого размера нужно вернуть указатель, отличный от nullptr
+		return m_Arena.Allocate(bytes ? bytes : 1, alignment);
+	}
+
+	void do_deallocate(void*, size_t, size_t) override
+	{
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+private:
+	Arena& m_Arena;
+};
+
+} // namespace util
@@ -4,11 +4,15 @@
 
 #pragma once
 
+#include "memory.h"
 #include "platform.h"
 #include "util.h"
 
+#include <initializer_list>
+#include <new>
 #include <string.h>
 #include <type_traits>
+#include <utility>
 
 namespace util {
 
@@ -18,47 +22,74 @@ namespace util {
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Класс DynamicArray - простейший контейнер, представляет собой массив элементов одного
-// типа. Массив заданного размера выделяется в куче при создании объекта. Контейнер может
-// быть использован только для простых типов без инициализатора (POD-types)
+// Класс DynamicArray - простейший контейнер, представляет собой массив элементов одного типа. Массив заданного размера
+// выделяется при создании объекта в куче (с выравниванием alignment, по умолчанию по границе строки кеша CPU) или, если
+// это задано параметром конструктора, страницами ОС (см. AllocPolicy). Память в куче выделяется через источник памяти
+// resource (по умолчанию - через источник памяти AML по умолчанию, см. GetDefaultResource). Контейнер может быть
+// использован только для простых типов без инициализатора (POD-types)
 
 //--------------------------------------------------------------------------------------------------------------------------------
-template<class T>
+template<class T, size_t alignment = AML_CACHE_LINE_SIZE>
 class DynamicArray final
 {
 	AML_NONCOPYABLE(DynamicArray)
 	static_assert(std::is_pod_v<T>, "Only POD-types are allowed");
+	static_assert(alignment <= 4096, "Alignment must not exceed the page size");
 
 public:
 	// Параметр size задаёт желаемый размер контейнера (количество элементов). Если параметр
-	// data задан, то элементы контейнера будут проинициализированы значениями из массива data
-	explicit DynamicArray(size_t size, const T* data = nullptr)
-		: m_Items(size ? new Item[size] : nullptr)
+	// data задан, то элементы контейнера будут проинициализированы значениями из массива data.
+	// Параметр policy задаёт способ выделения памяти. Страницы всегда выровнены по границе 4 КБ
+	explicit DynamicArray(size_t size, const T* data = nullptr, AllocPolicy policy = AllocPolicy::Heap,
+		std::pmr::memory_resource* resource = nullptr)
+		: m_Size(size)
+		, m_Resource(GetResource(resource))
+		, m_Policy(policy)
 	{
-		if (data)
-			memcpy(m_Items, data, size * sizeof(T));
+		if (size)
+		{
+			if (policy == AllocPolicy::Heap)
+				m_Items = AllocArray<T, alignment>(size, m_Resource);
+			else if (size <= size_t(-1) / sizeof(T))
+				m_Items = static_cast<T*>(AllocPages(size * sizeof(T), policy == AllocPolicy::LargePages, &m_IsLargePages));
+			else
+				throw std::bad_alloc();
+
+			if (data)
+				memcpy(m_Items, data, size * sizeof(T));
+		}
 	}
 
 	~DynamicArray() noexcept
 	{
-		if (m_Items)
-			delete[] m_Items;
+		if (m_Policy == AllocPolicy::Heap)
+			FreeArray<T, alignment>(m_Items, m_Size, m_Resource);
+		else
+			FreePages(m_Items);
+	}
+
+	// Возвращает true, если массив размещён в больших страницах памяти
+	bool IsLargePages() const noexcept
+	{
+		return m_IsLargePages;
 	}
 
 	operator T*() noexcept
 	{
-		return reinterpret_cast<T*>(m_Items);
+		return m_Items;
 	}
 
 	operator const T*() const noexcept
 	{
-		return reinterpret_cast<T*>(m_Items);
+		return m_Items;
 	}
 
 private:
-	using Item = uint8_t[sizeof(T)];
-
-	Item* m_Items;
+	T* m_Items = nullptr;
+	size_t m_Size;
+	std::pmr::memory_resource* m_Resource;
+	AllocPolicy m_Policy;
+	bool m_IsLargePages = false;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -122,10 +153,11 @@ private:
 // Класс FlexibleArray - это контейнер, представляющий собой массив элементов одного типа. От DynamicArray и
 // SmartArray этот контейнер отличает то, что он может быть проинициализирован пользовательским массивом заданного
 // размера. Также, он может менять свой размер в сторону увеличения: в этом случае новый массив большего размера
-// всегда выделяется в куче. Контейнер может быть использован только для простых типов без инициализатора
+// всегда выделяется в куче (с выравниванием alignment) через источник памяти resource, заданный в конструкторе (см.
+// GetDefaultResource). Контейнер может быть использован только для простых типов без инициализатора
 
 //--------------------------------------------------------------------------------------------------------------------------------
-template<class T>
+template<class T, size_t alignment = AML_CACHE_LINE_SIZE>
 class FlexibleArray final
 {
 	AML_NONCOPYABLE(FlexibleArray)
@@ -134,43 +166,44 @@ class FlexibleArray final
 public:
 	// Инициализирует контейнер размером size элементов. Если значение параметра
 	// size больше 0, то массив соответствующего размера сразу выделяется в куче
-	explicit FlexibleArray(size_t size = 0)
-		: m_Buffer(size ? new Item[size] : nullptr)
-		, m_Size(size)
+	explicit FlexibleArray(size_t size = 0, std::pmr::memory_resource* resource = nullptr)
+		: m_Resource(GetResource(resource))
 	{
+		m_Buffer = size ? AllocArray<T, alignment>(size, m_Resource) : nullptr;
 		m_Items = m_Buffer;
+		m_Size = size;
 	}
 
 	// Инициализирует контейнер пользовательским массивом userBuffer размером userSize
 	// элементов. Этот массив будет использован для хранения элементов контейнера
-	FlexibleArray(T* userBuffer, size_t userSize) noexcept
-		: m_Items(reinterpret_cast<Item*>(userBuffer))
+	FlexibleArray(T* userBuffer, size_t userSize, std::pmr::memory_resource* resource = nullptr) noexcept
+		: m_Items(userBuffer)
 		, m_Buffer(nullptr)
 		, m_Size(userBuffer ? userSize : 0)
+		, m_Resource(GetResource(resource))
 	{
 	}
 
 	template<size_t userSize>
-	explicit FlexibleArray(T (&userBuffer)[userSize]) noexcept
-		: m_Items(reinterpret_cast<Item*>(userBuffer))
+	explicit FlexibleArray(T (&userBuffer)[userSize], std::pmr::memory_resource* resource = nullptr) noexcept
+		: m_Items(userBuffer)
 		, m_Buffer(nullptr)
 		, m_Size(userBuffer ? userSize : 0)
+		, m_Resource(GetResource(resource))
 	{
 	}
 
 	~FlexibleArray() noexcept
 	{
-		if (m_Buffer)
-			delete[] m_Buffer;
+		FreeArray<T, alignment>(m_Buffer, m_Size, m_Resource);
 	}
 
 	// Реинициализирует контейнер новым пользовательским
 	// массивом userBuffer размером userSize элементов
 	void Set(T* userBuffer, size_t userSize) noexcept
 	{
-		if (m_Buffer)
-			delete[] m_Buffer;
-		m_Items = reinterpret_cast<Item*>(userBuffer);
+		FreeArray<T, alignment>(m_Buffer, m_Size, m_Resource);
+		m_Items = userBuffer;
 		m_Buffer = nullptr;
 		m_Size = userBuffer ? userSize : 0;
 	}
@@ -202,37 +235,33 @@ public:
 
 	operator T*() noexcept
 	{
-		return reinterpret_cast<T*>(m_Items);
+		return m_Items;
 	}
 
 	operator const T*() const noexcept
 	{
-		return reinterpret_cast<T*>(m_Items);
+		return m_Items;
 	}
 
 private:
-	using Item = uint8_t[sizeof(T)];
-
 	AML_NOINLINE void Reallocate(size_t newSize)
 	{
-		if (m_Buffer)
-			delete[] m_Buffer;
+		FreeArray<T, alignment>(m_Buffer, m_Size, m_Resource);
 		m_Items = m_Buffer = nullptr;
 		m_Size = 0;
 
-		m_Buffer = new Item[newSize];
+		m_Buffer = AllocArray<T, alignment>(newSize, m_Resource);
 		m_Items = m_Buffer;
 		m_Size = newSize;
 	}
 
 	AML_NOINLINE void Resize(size_t newSize)
 	{
-		Item* newBuffer = new Item[newSize];
+		T* newBuffer = AllocArray<T, alignment>(newSize, m_Resource);
 		if (m_Size)
 		{
 			memcpy(newBuffer, m_Items, m_Size * sizeof(T));
-			if (m_Buffer)
-				delete[] m_Buffer;
+			FreeArray<T, alignment>(m_Buffer, m_Size, m_Resource);
 		}
 		m_Buffer = newBuffer;
 		m_Items = m_Buffer;
@@ -240,9 +269,375 @@ private:
 	}
 
 private:
-	Item* m_Items;
-	Item* m_Buffer;
+	T* m_Items;
+	T* m_Buffer;
 	size_t m_Size;
+	std::pmr::memory_resource* m_Resource;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SmallVector
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Шаблон IsTriviallyRelocatable определяет, можно ли переместить объект типа T в другое место памяти простым копированием
+// его байтов (без вызова конструктора перемещения и деструктора). По умолчанию это допустимо для тривиально копируемых
+// типов. Для других типов, которые не хранят указатели на самих себя, шаблон можно специализировать самостоятельно
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+template<class T>
+inline constexpr bool IS_TRIVIALLY_RELOCATABLE = IsTriviallyRelocatable<T>::value;
+
+// Класс SmallVector - это контейнер с интерфейсом, похожим на std::vector, который имеет внутренний буфер на capacity
+// элементов. Пока количество элементов не превышает capacity, они хранятся во внутреннем буфере, и контейнер не
+// выделяет память в куче. В отличие от других контейнеров этого файла, SmallVector может хранить элементы любых
+// типов. При увеличении размера массива элементы перемещаются в новый буфер (если тип элементов тривиально
+// перемещаемый, то с помощью memcpy). Как и для std::vector, изменение размера делает итераторы недействительными
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T, size_t capacity = 8>
+class SmallVector final
+{
+	static_assert(capacity > 0, "Capacity must be greater than 0");
+
+public:
+	using value_type = T;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	SmallVector() noexcept = default;
+
+	SmallVector(std::initializer_list<T> items)
+	{
+		Append(items.begin(), items.size());
+	}
+
+	SmallVector(const SmallVector& other)
+	{
+		Append(other.m_Items, other.m_Size);
+	}
+
+	SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		MoveFrom(other);
+	}
+
+	~SmallVector() noexcept
+	{
+		DestroyItems(m_Items, m_Size);
+		FreeItems();
+	}
+
+	SmallVector& operator =(const SmallVector& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			Append(other.m_Items, other.m_Size);
+		}
+		return *this;
+	}
+
+	SmallVector& operator =(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		if (this != &other)
+		{
+			clear();
+			FreeItems();
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	size_t size() const noexcept { return m_Size; }
+	bool empty() const noexcept { return !m_Size; }
+
+	// Возвращает количество элементов, которое может хранить контейнер без выделения памяти
+	size_t GetCapacity() const noexcept { return m_Capacity; }
+	// Возвращает true, если элементы хранятся во внутреннем буфере
+	bool IsInline() const noexcept { return m_Items == GetBuffer(); }
+
+	T* data() noexcept { return m_Items; }
+	const T* data() const noexcept { return m_Items; }
+
+	iterator begin() noexcept { return m_Items; }
+	iterator end() noexcept { return m_Items + m_Size; }
+	const_iterator begin() const noexcept { return m_Items; }
+	const_iterator end() const noexcept { return m_Items + m_Size; }
+
+	T& operator [](size_t index) noexcept { return m_Items[index]; }
+	const T& operator [](size_t index) const noexcept { return m_Items[index]; }
+
+	T& front() noexcept { return m_Items[0]; }
+	const T& front() const noexcept { return m_Items[0]; }
+	T& back() noexcept { return m_Items[m_Size - 1]; }
+	const T& back() const noexcept { return m_Items[m_Size - 1]; }
+
+	// Увеличивает (при необходимости) ёмкость контейнера до newCapacity элементов
+	void reserve(size_t newCapacity)
+	{
+		if (newCapacity > m_Capacity)
+			Reallocate(newCapacity);
+	}
+
+	// Изменяет размер контейнера. Новые элементы создаются конструктором по умолчанию
+	void resize(size_t newSize)
+	{
+		if (newSize > m_Size)
+		{
+			reserve(newSize);
+			for (; m_Size < newSize; ++m_Size)
+				new(m_Items + m_Size) T();
+		} else
+		{
+			DestroyItems(m_Items + newSize, m_Size - newSize);
+			m_Size = newSize;
+		}
+	}
+
+	// Удаляет все элементы. Память, выделенная в куче, не освобождается
+	void clear() noexcept
+	{
+		DestroyItems(m_Items, m_Size);
+		m_Size = 0;
+	}
+
+	void push_back(const T& value) { emplace_back(value); }
+	void push_back(T&& value) { emplace_back(std::move(value)); }
+
+	template<class... Args> T& emplace_back(Args&&... args)
+	{
+		if (m_Size < m_Capacity)
+		{
+			T* item = new(m_Items + m_Size) T(std::forward<Args>(args)...);
+			++m_Size;
+			return *item;
+		}
+
+		return GrowAndEmplace(std::forward<Args>(args)...);
+	}
+
+	void pop_back() noexcept
+	{
+		m_Items[--m_Size].~T();
+	}
+
+	iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+	iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+	// Вставляет новый элемент перед позицией pos и возвращает итератор на него
+	template<class... Args> iterator emplace(const_iterator pos, Args&&... args)
+	{
+		const size_t index = pos - m_Items;
+		if (index == m_Size)
+		{
+			emplace_back(std::forward<Args>(args)...);
+			return m_Items + index;
+		}
+
+		// Аргументы могут ссылаться на элементы самого контейнера,
+		// поэтому новый элемент создаём до перемещения элементов
+		T value(std::forward<Args>(args)...);
+		if (m_Size == m_Capacity)
+			Reallocate(GetGrownCapacity(m_Size + 1));
+
+		T* item = m_Items + index;
+		if constexpr (IS_TRIVIALLY_RELOCATABLE<T>)
+		{
+			memmove(static_cast<void*>(item + 1), item, (m_Size - index) * sizeof(T));
+			new(item) T(std::move(value));
+		} else
+		{
+			new(m_Items + m_Size) T(std::move(m_Items[m_Size - 1]));
+			for (T* p = m_Items + m_Size - 1; p != item; --p)
+				*p = std::move(p[-1]);
+			*item = std::move(value);
+		}
+		++m_Size;
+		return item;
+	}
+
+	// Удаляет элемент в позиции pos и возвращает итератор на следующий за ним элемент
+	iterator erase(const_iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	// Удаляет элементы в диапазоне [first, last) и возвращает итератор на следующий за ним элемент
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		T* from = m_Items + (first - m_Items);
+		const size_t count = last - first;
+		if (count)
+		{
+			if constexpr (IS_TRIVIALLY_RELOCATABLE<T>)
+			{
+				DestroyItems(from, count);
+				memmove(static_cast<void*>(from), from + count, (end() - from - count) * sizeof(T));
+			} else
+			{
+				T* to = from;
+				for (T* p = from + count; p != end(); ++p, ++to)
+					*to = std::move(*p);
+				DestroyItems(to, count);
+			}
+			m_Size -= count;
+		}
+		return from;
+	}
+
+private:
+	T* GetBuffer() noexcept { return reinterpret_cast<T*>(m_Buffer); }
+	const T* GetBuffer() const noexcept { return reinterpret_cast<const T*>(m_Buffer); }
+
+	size_t GetGrownCapacity(size_t minCapacity) const noexcept
+	{
+		return (std::max)(m_Capacity * 2, minCapacity);
+	}
+
+	static T* AllocateItems(size_t count)
+	{
+		if (count > size_t(-1) / sizeof(T))
+			throw std::bad_alloc();
+
+		if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+		else
+			return static_cast<T*>(::operator new(count * sizeof(T)));
+	}
+
+	static void DeallocateItems(T* items) noexcept
+	{
+		if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			::operator delete(items, std::align_val_t(alignof(T)));
+		else
+			::operator delete(items);
+	}
+
+	// Освобождает массив в куче (если он есть) и переключает контейнер на внутренний буфер
+	void FreeItems() noexcept
+	{
+		if (!IsInline())
+			DeallocateItems(m_Items);
+
+		m_Items = GetBuffer();
+		m_Capacity = capacity;
+	}
+
+	static void DestroyItems(T* items, size_t count) noexcept
+	{
+		if constexpr (!std::is_trivially_destructible_v<T>)
+		{
+			for (size_t i = 0; i < count; ++i)
+				items[i].~T();
+		}
+	}
+
+	// Перемещает count элементов из массива from в неинициализированный массив to. Если конструктор перемещения может
+	// выбросить исключение, то элементы копируются, а в случае исключения массив from остаётся без изменений
+	static void RelocateItems(T* from, size_t count, T* to)
+	{
+		if constexpr (IS_TRIVIALLY_RELOCATABLE<T>)
+		{
+			if (count)
+				memcpy(static_cast<void*>(to), from, count * sizeof(T));
+		} else
+		{
+			size_t i = 0;
+			try {
+				for (; i < count; ++i)
+					new(to + i) T(std::move_if_noexcept(from[i]));
+			}
+			catch (...)
+			{
+				DestroyItems(to, i);
+				throw;
+			}
+
+			DestroyItems(from, count);
+		}
+	}
+
+	// Копирует count элементов из массива items в конец контейнера
+	void Append(const T* items, size_t count)
+	{
+		reserve(m_Size + count);
+		for (size_t i = 0; i < count; ++i, ++m_Size)
+			new(m_Items + m_Size) T(items[i]);
+	}
+
+	// Забирает элементы у контейнера other (наш контейнер должен быть пустым и не иметь буфера в куче)
+	void MoveFrom(SmallVector& other)
+	{
+		if (other.IsInline())
+		{
+			RelocateItems(other.m_Items, other.m_Size, m_Items);
+			m_Size = other.m_Size;
+			other.m_Size = 0;
+		} else
+		{
+			m_Items = other.m_Items;
+			m_Size = other.m_Size;
+			m_Capacity = other.m_Capacity;
+			other.m_Items = other.GetBuffer();
+			other.m_Size = 0;
+			other.m_Capacity = capacity;
+		}
+	}
+
+	AML_NOINLINE void Reallocate(size_t newCapacity)
+	{
+		T* newItems = AllocateItems(newCapacity);
+		try {
+			RelocateItems(m_Items, m_Size, newItems);
+		}
+		catch (...)
+		{
+			DeallocateItems(newItems);
+			throw;
+		}
+
+		FreeItems();
+		m_Items = newItems;
+		m_Capacity = newCapacity;
+	}
+
+	template<class... Args> AML_NOINLINE T& GrowAndEmplace(Args&&... args)
+	{
+		// Аргументы могут ссылаться на элементы самого контейнера, поэтому
+		// новый элемент создаём в новом буфере до перемещения элементов
+		const size_t newCapacity = GetGrownCapacity(m_Size + 1);
+		T* newItems = AllocateItems(newCapacity);
+		T* item = nullptr;
+		try {
+			item = new(newItems + m_Size) T(std::forward<Args>(args)...);
+			RelocateItems(m_Items, m_Size, newItems);
+		}
+		catch (...)
+		{
+			if (item)
+				item->~T();
+			DeallocateItems(newItems);
+			throw;
+		}
+
+		FreeItems();
+		m_Items = newItems;
+		m_Capacity = newCapacity;
+		++m_Size;
+		return *item;
+	}
+
+private:
+	T* m_Items = GetBuffer();		// Указатель на массив элементов (внутренний буфер или массив в куче)
+	size_t m_Size = 0;				// Количество элементов в контейнере
+	size_t m_Capacity = capacity;	// Ёмкость массива m_Items (в элементах)
+
+	alignas(T) uint8_t m_Buffer[capacity * sizeof(T)];
 };
 
 } // namespace util
@@ -0,0 +1,407 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "bitset.h"
+
+#include "debug.h"
+
+#include <iterator>
+
+using namespace util;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Bitmap
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap::Bitmap(std::pmr::memory_resource* resource) noexcept
+	: m_Resource(GetResource(resource))
+{
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap::Bitmap(size_t size, bool value, std::pmr::memory_resource* resource)
+	: m_Resource(GetResource(resource))
+{
+	resize(size, value);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap::Bitmap(const Bitmap& other)
+	: m_Resource(other.m_Resource)
+{
+	*this = other;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap::Bitmap(Bitmap&& other) noexcept
+	: m_Words(other.m_Words)
+	, m_Size(other.m_Size)
+	, m_Capacity(other.m_Capacity)
+	, m_Resource(other.m_Resource)
+{
+	other.m_Words = nullptr;
+	other.m_Size = other.m_Capacity = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap::~Bitmap() noexcept
+{
+	FreeArray(m_Words, m_Capacity, m_Resource);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap& Bitmap::operator =(const Bitmap& other)
+{
+	if (this != &other)
+	{
+		const size_t wordCount = other.GetWordCount();
+		if (wordCount > m_Capacity)
+		{
+			uint64_t* words = AllocArray<uint64_t>(wordCount, m_Resource);
+			FreeArray(m_Words, m_Capacity, m_Resource);
+			m_Words = words;
+			m_Capacity = wordCount;
+		}
+
+		if (wordCount)
+			memcpy(m_Words, other.m_Words, wordCount * sizeof(uint64_t));
+		m_Size = other.m_Size;
+	}
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap& Bitmap::operator =(Bitmap&& other) noexcept
+{
+	if (this != &other)
+	{
+		FreeArray(m_Words, m_Capacity, m_Resource);
+		m_Words = other.m_Words;
+		m_Size = other.m_Size;
+		m_Capacity = other.m_Capacity;
+		m_Resource = other.m_Resource;
+
+		other.m_Words = nullptr;
+		other.m_Size = other.m_Capacity = 0;
+	}
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Bitmap::resize(size_t size, bool value)
+{
+	const size_t oldWordCount = GetWordCount();
+	const size_t wordCount = (size + 63) / 64;
+	if (wordCount > m_Capacity)
+	{
+		// Увеличиваем массив не менее чем в 1,5 раза, чтобы
+		// последовательное увеличение размера не было квадратичным
+		const size_t capacity = (std::max)(wordCount, m_Capacity + m_Capacity / 2);
+		uint64_t* words = AllocArray<uint64_t>(capacity, m_Resource);
+		if (oldWordCount)
+			memcpy(words, m_Words, oldWordCount * sizeof(uint64_t));
+
+		FreeArray(m_Words, m_Capacity, m_Resource);
+		m_Words = words;
+		m_Capacity = capacity;
+	}
+
+	if (size > m_Size)
+	{
+		const uint64_t fill = value ? ~uint64_t(0) : 0;
+		if (value && (m_Size % 64))
+			m_Words[oldWordCount - 1] |= ~uint64_t(0) << (m_Size % 64);
+		for (size_t i = oldWordCount; i < wordCount; ++i)
+			m_Words[i] = fill;
+	}
+
+	m_Size = size;
+	ClearTail();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Bitmap::clear() noexcept
+{
+	FreeArray(m_Words, m_Capacity, m_Resource);
+	m_Words = nullptr;
+	m_Size = m_Capacity = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Bitmap::SetAll() noexcept
+{
+	const size_t wordCount = GetWordCount();
+	for (size_t i = 0; i < wordCount; ++i)
+		m_Words[i] = ~uint64_t(0);
+	ClearTail();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Bitmap::ResetAll() noexcept
+{
+	if (const size_t wordCount = GetWordCount())
+		memset(m_Words, 0, wordCount * sizeof(uint64_t));
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap& Bitmap::operator &=(const Bitmap& other) noexcept
+{
+	Assert(m_Size == other.m_Size);
+	BitWords::And(m_Words, other.m_Words, GetWordCount());
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap& Bitmap::operator |=(const Bitmap& other) noexcept
+{
+	Assert(m_Size == other.m_Size);
+	BitWords::Or(m_Words, other.m_Words, GetWordCount());
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap& Bitmap::operator ^=(const Bitmap& other) noexcept
+{
+	Assert(m_Size == other.m_Size);
+	BitWords::Xor(m_Words, other.m_Words, GetWordCount());
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Bitmap& Bitmap::AndNot(const Bitmap& other) noexcept
+{
+	Assert(m_Size == other.m_Size);
+	BitWords::AndNot(m_Words, other.m_Words, GetWordCount());
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool Bitmap::operator ==(const Bitmap& other) const noexcept
+{
+	return m_Size == other.m_Size && BitWords::Equal(m_Words, other.m_Words, GetWordCount());
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Bitmap::ClearTail() noexcept
+{
+	if (m_Size % 64)
+		m_Words[m_Size / 64] &= (uint64_t(1) << (m_Size % 64)) - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SparseBitmap
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SparseBitmap::clear() noexcept
+{
+	m_Chunks.clear();
+	m_Count = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool SparseBitmap::Test(uint32_t value) const noexcept
+{
+	const Chunk* chunk = m_Chunks.Find(static_cast<uint16_t>(value >> 16));
+	return chunk && chunk->Test(static_cast<uint16_t>(value));
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool SparseBitmap::Set(uint32_t value)
+{
+	Chunk& chunk = m_Chunks[static_cast<uint16_t>(value >> 16)];
+	const uint16_t low = static_cast<uint16_t>(value);
+
+	if (chunk.IsBitmap())
+	{
+		uint64_t& word = chunk.bits[low / 64];
+		const uint64_t bit = uint64_t(1) << (low % 64);
+		if (word & bit)
+			return false;
+		word |= bit;
+	} else
+	{
+		auto it = std::lower_bound(chunk.values.begin(), chunk.values.end(), low);
+		if (it != chunk.values.end() && *it == low)
+			return false;
+
+		if (chunk.count < MAX_ARRAY_SIZE)
+		{
+			chunk.values.insert(it, low);
+		} else
+		{
+			chunk.ToBitmap();
+			chunk.bits[low / 64] |= uint64_t(1) << (low % 64);
+		}
+	}
+
+	++chunk.count;
+	++m_Count;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool SparseBitmap::Reset(uint32_t value)
+{
+	const uint16_t high = static_cast<uint16_t>(value >> 16);
+	Chunk* chunk = m_Chunks.Find(high);
+	const uint16_t low = static_cast<uint16_t>(value);
+	if (!chunk || !chunk->Test(low))
+		return false;
+
+	if (chunk->IsBitmap())
+	{
+		chunk->bits[low / 64] &= ~(uint64_t(1) << (low % 64));
+		if (--chunk->count <= MAX_ARRAY_SIZE)
+			chunk->ToArray();
+	} else
+	{
+		chunk->values.erase(std::lower_bound(chunk->values.begin(), chunk->values.end(), low));
+		--chunk->count;
+	}
+
+	if (!chunk->count)
+		m_Chunks.Erase(high);
+	--m_Count;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SparseBitmap& SparseBitmap::operator |=(const SparseBitmap& other)
+{
+	for (size_t i = 0; i < other.m_Chunks.size(); ++i)
+	{
+		const Chunk& src = other.m_Chunks.ValueAt(i);
+		Chunk& dst = m_Chunks[other.m_Chunks.KeyAt(i)];
+		m_Count -= dst.count;
+
+		if (!dst.IsBitmap() && !src.IsBitmap() && dst.count + src.count <= MAX_ARRAY_SIZE)
+		{
+			std::vector<uint16_t> values;
+			values.reserve(dst.count + src.count);
+			std::set_union(dst.values.begin(), dst.values.end(), src.values.begin(),
+				src.values.end(), std::back_inserter(values));
+			dst.values.swap(values);
+			dst.count = dst.values.size();
+		} else
+		{
+			dst.ToBitmap();
+			if (src.IsBitmap())
+			{
+				BitWords::Or(dst.bits.data(), src.bits.data(), CHUNK_WORDS);
+			} else
+			{
+				for (uint16_t low : src.values)
+					dst.bits[low / 64] |= uint64_t(1) << (low % 64);
+			}
+			dst.count = BitWords::Count(dst.bits.data(), CHUNK_WORDS);
+		}
+
+		m_Count += dst.count;
+	}
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SparseBitmap& SparseBitmap::operator &=(const SparseBitmap& other)
+{
+	// Участки, которые остались непустыми, переносим в новый контейнер. Они
+	// добавляются в порядке возрастания ключей, то есть всегда в его конец
+	FlatMap<uint16_t, Chunk> chunks;
+	m_Count = 0;
+
+	for (size_t i = 0; i < m_Chunks.size(); ++i)
+	{
+		const Chunk* src = other.m_Chunks.Find(m_Chunks.KeyAt(i));
+		if (!src)
+			continue;
+
+		Chunk& dst = m_Chunks.ValueAt(i);
+		if (dst.IsBitmap() && src->IsBitmap())
+		{
+			BitWords::And(dst.bits.data(), src->bits.data(), CHUNK_WORDS);
+			dst.count = BitWords::Count(dst.bits.data(), CHUNK_WORDS);
+			if (dst.count <= MAX_ARRAY_SIZE)
+				dst.ToArray();
+		} else
+		{
+			// Хотя бы один из участков - массив, поэтому результат не больше MAX_ARRAY_SIZE
+			const Chunk& array = dst.IsBitmap() ? *src : dst;
+			const Chunk& test = dst.IsBitmap() ? dst : *src;
+
+			std::vector<uint16_t> values;
+			values.reserve(array.count);
+			for (uint16_t low : array.values)
+			{
+				if (test.Test(low))
+					values.push_back(low);
+			}
+
+			dst.values.swap(values);
+			dst.bits = std::vector<uint64_t>();
+			dst.count = dst.values.size();
+		}
+
+		if (dst.count)
+		{
+			m_Count += dst.count;
+			chunks.TryEmplace(m_Chunks.KeyAt(i), std::move(dst));
+		}
+	}
+
+	m_Chunks = std::move(chunks);
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t SparseBitmap::GetMemoryUsage() const noexcept
+{
+	size_t result = sizeof(*this) + m_Chunks.size() * (sizeof(uint16_t) + sizeof(Chunk));
+	for (size_t i = 0; i < m_Chunks.size(); ++i)
+	{
+		const Chunk& chunk = m_Chunks.ValueAt(i);
+		result += chunk.values.capacity() * sizeof(uint16_t) + chunk.bits.capacity() * sizeof(uint64_t);
+	}
+	return result;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool SparseBitmap::Chunk::Test(uint16_t low) const noexcept
+{
+	if (IsBitmap())
+		return (bits[low / 64] >> (low % 64)) & 1;
+
+	return std::binary_search(values.begin(), values.end(), low);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SparseBitmap::Chunk::ToBitmap()
+{
+	if (IsBitmap())
+		return;
+
+	bits.assign(CHUNK_WORDS, 0);
+	for (uint16_t low : values)
+		bits[low / 64] |= uint64_t(1) << (low % 64);
+
+	values = std::vector<uint16_t>();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SparseBitmap::Chunk::ToArray()
+{
+	values.clear();
+	values.reserve(count);
+	BitWords::ForEach(bits.data(), CHUNK_WORDS, [this](size_t bit) {
+		values.push_back(static_cast<uint16_t>(bit));
+	});
+
+	bits = std::vector<uint64_t>();
+}
@@ -0,0 +1,420 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "flatmap.h"
+#include "memory.h"
+#include "platform.h"
+#include "util.h"
+
+#include <stdint.h>
+#include <vector>
+
+#if AML_AVX2
+	#include <immintrin.h>
+#endif
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   BitWords - операции над массивами 64-битных слов
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс BitWords содержит общие для битовых множеств операции над массивами слов. Массовые операции обрабатывают
+// по 4 слова за итерацию инструкциями AVX2 (если они разрешены ключом компилятора), остаток - по одному слову
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class BitWords final
+{
+public:
+	// Значение, возвращаемое функциями поиска, если установленный бит не найден
+	static constexpr size_t NOT_FOUND = size_t(-1);
+
+	static void And(uint64_t* dst, const uint64_t* src, size_t count) noexcept
+	{
+		size_t i = 0;
+		#if AML_AVX2
+			for (; i + 4 <= count; i += 4)
+				Store(dst + i, _mm256_and_si256(Load(dst + i), Load(src + i)));
+		#endif
+		for (; i < count; ++i)
+			dst[i] &= src[i];
+	}
+
+	static void Or(uint64_t* dst, const uint64_t* src, size_t count) noexcept
+	{
+		size_t i = 0;
+		#if AML_AVX2
+			for (; i + 4 <= count; i += 4)
+				Store(dst + i, _mm256_or_si256(Load(dst + i), Load(src + i)));
+		#endif
+		for (; i < count; ++i)
+			dst[i] |= src[i];
+	}
+
+	static void Xor(uint64_t* dst, const uint64_t* src, size_t count) noexcept
+	{
+		size_t i = 0;
+		#if AML_AVX2
+			for (; i + 4 <= count; i += 4)
+				Store(dst + i, _mm256_xor_si256(Load(dst + i), Load(src + i)));
+		#endif
+		for (; i < count; ++i)
+			dst[i] ^= src[i];
+	}
+
+	// Сбрасывает в массиве dst биты, установленные в массиве src
+	static void AndNot(uint64_t* dst, const uint64_t* src, size_t count) noexcept
+	{
+		size_t i = 0;
+		#if AML_AVX2
+			for (; i + 4 <= count; i += 4)
+				Store(dst + i, _mm256_andnot_si256(Load(src + i), Load(dst + i)));
+		#endif
+		for (; i < count; ++i)
+			dst[i] &= ~src[i];
+	}
+
+	// Возвращает количество установленных битов
+	static size_t Count(const uint64_t* words, size_t count) noexcept
+	{
+		size_t result = 0, i = 0;
+		#if AML_AVX2
+			// Подсчёт битов в каждом полубайте по таблице (инструкция pshufb), затем
+			// суммирование байтов в 64-битные счётчики (инструкция psadbw)
+			const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+			const __m256i lowMask = _mm256_set1_epi8(0x0f);
+			__m256i sum = _mm256_setzero_si256();
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m256i v = Load(words + i);
+				const __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, lowMask));
+				const __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask));
+				sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+			}
+			uint64_t sums[4];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), sum);
+			result = static_cast<size_t>(sums[0] + sums[1] + sums[2] + sums[3]);
+		#endif
+		for (; i < count; ++i)
+			result += PopCount(words[i]);
+		return result;
+	}
+
+	// Возвращает true, если установлен хотя бы один бит
+	static bool Any(const uint64_t* words, size_t count) noexcept
+	{
+		return FindNonZero(words, count, 0) < count;
+	}
+
+	// Возвращает true, если массивы совпадают
+	static bool Equal(const uint64_t* a, const uint64_t* b, size_t count) noexcept
+	{
+		size_t i = 0;
+		#if AML_AVX2
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m256i diff = _mm256_xor_si256(Load(a + i), Load(b + i));
+				if (!_mm256_testz_si256(diff, diff))
+					return false;
+			}
+		#endif
+		for (; i < count; ++i)
+		{
+			if (a[i] != b[i])
+				return false;
+		}
+		return true;
+	}
+
+	// Возвращает номер первого установленного бита, начиная с бита from, или NOT_FOUND
+	static size_t FindNext(const uint64_t* words, size_t count, size_t from) noexcept
+	{
+		size_t w = from / 64;
+		if (w >= count)
+			return NOT_FOUND;
+
+		if (const uint64_t bits = words[w] & (~uint64_t(0) << (from % 64)))
+			return w * 64 + CountTrailingZeros(bits);
+
+		w = FindNonZero(words, count, w + 1);
+		return (w < count) ? w * 64 + CountTrailingZeros(words[w]) : NOT_FOUND;
+	}
+
+	// Вызывает функцию fn(index) для каждого установленного бита в порядке возрастания номеров
+	template<class Fn> static void ForEach(const uint64_t* words, size_t count, Fn&& fn)
+	{
+		for (size_t w = 0; w < count; ++w)
+		{
+			for (uint64_t bits = words[w]; bits; bits &= bits - 1)
+				fn(w * 64 + CountTrailingZeros(bits));
+		}
+	}
+
+private:
+	// Возвращает индекс первого ненулевого слова, начиная со слова from, или count
+	static size_t FindNonZero(const uint64_t* words, size_t count, size_t from) noexcept
+	{
+		size_t i = from;
+		#if AML_AVX2
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m256i v = Load(words + i);
+				if (!_mm256_testz_si256(v, v))
+					break;
+			}
+		#endif
+		while (i < count && !words[i])
+			++i;
+		return i;
+	}
+
+	#if AML_AVX2
+		static __m256i Load(const uint64_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+		static void Store(uint64_t* p, __m256i v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+	#endif
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Bitset - битовое множество фиксированного размера
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс Bitset хранит N битов во внутреннем массиве 64-битных слов. В отличие от std::bitset, он умеет быстро искать
+// установленные биты (FindFirst, FindNext) и перебирать их (ForEach), а массовые операции выполняются над целыми словами
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<size_t N>
+class Bitset final
+{
+	static_assert(N > 0, "Size must be greater than 0");
+	static constexpr size_t WORD_COUNT = (N + 63) / 64;
+
+public:
+	static constexpr size_t NOT_FOUND = BitWords::NOT_FOUND;
+
+	static constexpr size_t size() noexcept { return N; }
+
+	bool Test(size_t index) const noexcept { return (m_Words[index / 64] >> (index % 64)) & 1; }
+	bool operator [](size_t index) const noexcept { return Test(index); }
+
+	void Set(size_t index) noexcept { m_Words[index / 64] |= uint64_t(1) << (index % 64); }
+	void Set(size_t index, bool value) noexcept { value ? Set(index) : Reset(index); }
+	void Reset(size_t index) noexcept { m_Words[index / 64] &= ~(uint64_t(1) << (index % 64)); }
+	void Flip(size_t index) noexcept { m_Words[index / 64] ^= uint64_t(1) << (index % 64); }
+
+	// Устанавливает все биты
+	void SetAll() noexcept
+	{
+		for (auto& word : m_Words)
+			word = ~uint64_t(0);
+		if constexpr (N % 64 != 0)
+			m_Words[WORD_COUNT - 1] = (uint64_t(1) << (N % 64)) - 1;
+	}
+
+	// Сбрасывает все биты
+	void ResetAll() noexcept
+	{
+		for (auto& word : m_Words)
+			word = 0;
+	}
+
+	// Возвращает количество установленных битов
+	size_t Count() const noexcept { return BitWords::Count(m_Words, WORD_COUNT); }
+
+	bool Any() const noexcept { return BitWords::Any(m_Words, WORD_COUNT); }
+	bool None() const noexcept { return !Any(); }
+
+	// Возвращают номер первого установленного бита (начиная с бита from) или NOT_FOUND
+	size_t FindFirst() const noexcept { return BitWords::FindNext(m_Words, WORD_COUNT, 0); }
+	size_t FindNext(size_t from) const noexcept { return BitWords::FindNext(m_Words, WORD_COUNT, from); }
+
+	// Вызывает функцию fn(index) для каждого установленного бита в порядке возрастания номеров
+	template<class Fn> void ForEach(Fn&& fn) const { BitWords::ForEach(m_Words, WORD_COUNT, fn); }
+
+	Bitset& operator &=(const Bitset& other) noexcept { BitWords::And(m_Words, other.m_Words, WORD_COUNT); return *this; }
+	Bitset& operator |=(const Bitset& other) noexcept { BitWords::Or(m_Words, other.m_Words, WORD_COUNT); return *this; }
+	Bitset& operator ^=(const Bitset& other) noexcept { BitWords::Xor(m_Words, other.m_Words, WORD_COUNT); return *this; }
+	// Сбрасывает биты, установленные в other
+	Bitset& AndNot(const Bitset& other) noexcept { BitWords::AndNot(m_Words, other.m_Words, WORD_COUNT); return *this; }
+
+	bool operator ==(const Bitset& other) const noexcept { return BitWords::Equal(m_Words, other.m_Words, WORD_COUNT); }
+	bool operator !=(const Bitset& other) const noexcept { return !(*this == other); }
+
+	const uint64_t* GetWords() const noexcept { return m_Words; }
+	static constexpr size_t GetWordCount() noexcept { return WORD_COUNT; }
+
+private:
+	// Неиспользуемые биты последнего слова всегда сброшены
+	uint64_t m_Words[WORD_COUNT] = {};
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Bitmap - битовое множество изменяемого размера
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс Bitmap - замена std::vector<bool> для больших битовых множеств (наборы изменённых блоков, фильтры
+// идентификаторов). Слова хранятся в массиве, выровненном по границе строки кеша, который выделяется через источник
+// памяти resource (см. GetDefaultResource). Бинарные операции (&=, |=, ^=, AndNot, ==) допустимы только для множеств
+// одинакового размера
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class Bitmap final
+{
+public:
+	static constexpr size_t NOT_FOUND = BitWords::NOT_FOUND;
+
+	explicit Bitmap(std::pmr::memory_resource* resource = nullptr) noexcept;
+	explicit Bitmap(size_t size, bool value = false, std::pmr::memory_resource* resource = nullptr);
+	Bitmap(const Bitmap& other);
+	Bitmap(Bitmap&& other) noexcept;
+	~Bitmap() noexcept;
+
+	Bitmap& operator =(const Bitmap& other);
+	Bitmap& operator =(Bitmap&& other) noexcept;
+
+	size_t size() const noexcept { return m_Size; }
+	bool empty() const noexcept { return !m_Size; }
+
+	// Изменяет размер множества. Добавленные биты получают значение value
+	void resize(size_t size, bool value = false);
+	// Освобождает память и делает размер множества нулевым
+	void clear() noexcept;
+
+	bool Test(size_t index) const noexcept { return (m_Words[index / 64] >> (index % 64)) & 1; }
+	bool operator [](size_t index) const noexcept { return Test(index); }
+
+	void Set(size_t index) noexcept { m_Words[index / 64] |= uint64_t(1) << (index % 64); }
+	void Set(size_t index, bool value) noexcept { value ? Set(index) : Reset(index); }
+	void Reset(size_t index) noexcept { m_Words[index / 64] &= ~(uint64_t(1) << (index % 64)); }
+	void Flip(size_t index) noexcept { m_Words[index / 64] ^= uint64_t(1) << (index % 64); }
+
+	// Устанавливает все биты
+	void SetAll() noexcept;
+	// Сбрасывает все биты
+	void ResetAll() noexcept;
+
+	// Возвращает количество установленных битов
+	size_t Count() const noexcept { return BitWords::Count(m_Words, GetWordCount()); }
+
+	bool Any() const noexcept { return BitWords::Any(m_Words, GetWordCount()); }
+	bool None() const noexcept { return !Any(); }
+
+	// Возвращают номер первого установленного бита (начиная с бита from) или NOT_FOUND
+	size_t FindFirst() const noexcept { return BitWords::FindNext(m_Words, GetWordCount(), 0); }
+	size_t FindNext(size_t from) const noexcept { return BitWords::FindNext(m_Words, GetWordCount(), from); }
+
+	// Вызывает функцию fn(index) для каждого установленного бита в порядке возрастания номеров
+	template<class Fn> void ForEach(Fn&& fn) const { BitWords::ForEach(m_Words, GetWordCount(), fn); }
+
+	Bitmap& operator &=(const Bitmap& other) noexcept;
+	Bitmap& operator |=(const Bitmap& other) noexcept;
+	Bitmap& operator ^=(const Bitmap& other) noexcept;
+	// Сбрасывает биты, установленные в other
+	Bitmap& AndNot(const Bitmap& other) noexcept;
+
+	bool operator ==(const Bitmap& other) const noexcept;
+	bool operator !=(const Bitmap& other) const noexcept { return !(*this == other); }
+
+	const uint64_t* GetWords() const noexcept { return m_Words; }
+	size_t GetWordCount() const noexcept { return (m_Size + 63) / 64; }
+
+private:
+	// Сбрасывает неиспользуемые биты последнего слова
+	void ClearTail() noexcept;
+
+private:
+	uint64_t* m_Words = nullptr;	// Массив слов (неиспользуемые биты последнего слова всегда сброшены)
+	size_t m_Size = 0;				// Размер множества в битах
+	size_t m_Capacity = 0;			// Размер массива m_Words в словах
+	std::pmr::memory_resource* m_Resource;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SparseBitmap - сжатое битовое множество 32-битных значений
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс SparseBitmap хранит множество 32-битных значений по схеме Roaring: диапазон значений делится на участки
+// по 65536 значений (по старшим 16 битам), и для каждого непустого участка хранится либо отсортированный массив
+// младших 16 бит значений (пока их не больше 4096), либо битовая карта участка размером 8 КБ. Поэтому разреженное
+// множество занимает около 2 байт на значение, а плотное - не более 1 бита на значение
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class SparseBitmap final
+{
+public:
+	size_t Count() const noexcept { return m_Count; }
+	bool empty() const noexcept { return !m_Count; }
+	void clear() noexcept;
+
+	// Возвращает true, если значение value есть в множестве
+	bool Test(uint32_t value) const noexcept;
+	// Добавляет значение value. Возвращает false, если оно уже было в множестве
+	bool Set(uint32_t value);
+	// Удаляет значение value. Возвращает false, если его не было в множестве
+	bool Reset(uint32_t value);
+
+	// Вызывает функцию fn(value) для каждого значения множества в порядке возрастания
+	template<class Fn> void ForEach(Fn&& fn) const
+	{
+		for (size_t i = 0; i < m_Chunks.size(); ++i)
+		{
+			const uint32_t base = uint32_t(m_Chunks.KeyAt(i)) << 16;
+			const Chunk& chunk = m_Chunks.ValueAt(i);
+			if (chunk.IsBitmap())
+			{
+				BitWords::ForEach(chunk.bits.data(), CHUNK_WORDS, [&](size_t bit) {
+					fn(base | static_cast<uint32_t>(bit));
+				});
+			} else
+			{
+				for (uint16_t low : chunk.values)
+					fn(base | low);
+			}
+		}
+	}
+
+	// Объединение множеств
+	SparseBitmap& operator |=(const SparseBitmap& other);
+	// Пересечение множеств
+	SparseBitmap& operator &=(const SparseBitmap& other);
+
+	// Возвращает примерный размер памяти, занимаемой множеством (в байтах)
+	size_t GetMemoryUsage() const noexcept;
+
+private:
+	// Максимальное количество значений участка, хранимых массивом
+	static constexpr size_t MAX_ARRAY_SIZE = 4096;
+	// Количество слов битовой карты участка
+	static constexpr size_t CHUNK_WORDS = 65536 / 64;
+
+	// Участок из 65536 значений: массив values или битовая карта bits (если она не пустая)
+	struct Chunk {
+		std::vector<uint16_t> values;	// Отсортированный массив младших 16 бит значений
+		std::vector<uint64_t> bits;		// Битовая карта участка
+		size_t count = 0;				// Количество значений в участке
+
+		bool IsBitmap() const noexcept { return !bits.empty(); }
+		bool Test(uint16_t low) const noexcept;
+
+		// Преобразует массив в битовую карту и обратно
+		void ToBitmap();
+		void ToArray();
+	};
+
+private:
+	FlatMap<uint16_t, Chunk> m_Chunks;	// Непустые участки (ключ - старшие 16 бит значений)
+	size_t m_Count = 0;					// Общее количество значений
+};
+
+} // namespace util
@@ -0,0 +1,216 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "platform.h"
+#include "util.h"
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if AML_SSE2
+	#include <emmintrin.h>
+#endif
+#if AML_AVX2
+	#include <immintrin.h>
+#endif
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   BasicCharClass - множество символов для быстрого поиска
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс BasicCharClass хранит множество символов (например, набор разделителей) в виде, подготовленном для поиска: битовая
+// таблица для символов с кодами меньше 256 и список остальных символов (только для wchar_t). Если в множестве не больше
+// MAX_BLOCK_CHARS символов и макрос AML_SSE2 равен 1, то функции Find и Count проверяют строку блоками по 16 байт (или
+// по 32 байта, если макрос AML_AVX2 равен 1), сравнивая каждый блок со всеми символами множества. Остаток строки, а также
+// строки для больших множеств проверяются посимвольно по таблице. Объект стоит создать один раз и использовать много раз
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+class BasicCharClass
+{
+public:
+	using view_type = std::basic_string_view<CharT>;
+
+	// Максимальное количество символов в множестве, при котором строка проверяется блоками
+	static constexpr size_t MAX_BLOCK_CHARS = 8;
+
+	// Создаёт пустое множество
+	BasicCharClass() noexcept = default;
+
+	// Создаёт множество из символов строки chars (повторы символов допускаются)
+	explicit BasicCharClass(view_type chars)
+	{
+		for (const CharT c : chars)
+			Add(c);
+	}
+
+	// Добавляет в множество символ c
+	void Add(CharT c)
+	{
+		if (Contains(c))
+			return;
+
+		const CodeT code = static_cast<CodeT>(c);
+		if (code < 256)
+			m_Bitmap[code >> 5] |= 1u << (code & 31);
+		else
+			m_WideChars.push_back(c);
+
+		if (m_Count < MAX_BLOCK_CHARS)
+			m_Chars[m_Count] = c;
+		++m_Count;
+	}
+
+	// Возвращает true, если символ c входит в множество
+	bool Contains(CharT c) const noexcept
+	{
+		const CodeT code = static_cast<CodeT>(c);
+		if (code < 256)
+			return (m_Bitmap[code >> 5] >> (code & 31)) & 1;
+
+		return m_WideChars.find(c) != m_WideChars.npos;
+	}
+
+	// Возвращает количество символов в множестве
+	size_t GetCount() const noexcept { return m_Count; }
+
+	// Возвращает указатель на первый символ диапазона [str, end), который входит в множество, или end, если таких символов нет
+	const CharT* Find(const CharT* str, const CharT* end) const noexcept
+	{
+		#if AML_SSE2
+			if (m_Count && m_Count <= MAX_BLOCK_CHARS)
+				str = FindInBlocks(str, end);
+		#endif
+
+		for (; str != end; ++str)
+		{
+			if (Contains(*str))
+				return str;
+		}
+
+		return end;
+	}
+
+	// Возвращает количество символов диапазона [str, end), которые входят в множество
+	size_t Count(const CharT* str, const CharT* end) const noexcept
+	{
+		size_t count = 0;
+		for (str = Find(str, end); str != end; str = Find(str + 1, end))
+			++count;
+		return count;
+	}
+
+	// Возвращает позицию первого символа строки str (начиная с позиции from), который входит в множество, или npos
+	size_t Find(view_type str, size_t from = 0) const noexcept
+	{
+		if (from >= str.size())
+			return view_type::npos;
+
+		const CharT* const end = str.data() + str.size();
+		const CharT* const p = Find(str.data() + from, end);
+		return (p != end) ? p - str.data() : view_type::npos;
+	}
+
+private:
+	using CodeT = std::make_unsigned_t<CharT>;
+
+	#if AML_SSE2
+		// Возвращает указатель на первый найденный символ или на начало остатка строки, который короче 16 байт
+		// и проверяется посимвольно. Если макрос AML_AVX2 равен 1, то строка сначала проверяется блоками по 32
+		// байта, а её остаток длиной не меньше 16 байт - одним блоком из 16 байт
+		const CharT* FindInBlocks(const CharT* str, const CharT* end) const noexcept
+		{
+			#if AML_AVX2
+				constexpr size_t BLOCK32 = 32 / sizeof(CharT);
+				if (static_cast<size_t>(end - str) >= BLOCK32)
+				{
+					__m256i chars[MAX_BLOCK_CHARS];
+					for (size_t i = 0; i < m_Count; ++i)
+						chars[i] = _mm256_broadcastsi128_si256(Broadcast(m_Chars[i]));
+
+					for (; static_cast<size_t>(end - str) >= BLOCK32; str += BLOCK32)
+					{
+						const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str));
+						__m256i eq = CmpEq(v, chars[0]);
+						for (size_t i = 1; i < m_Count; ++i)
+							eq = _mm256_or_si256(eq, CmpEq(v, chars[i]));
+
+						if (const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq)))
+							return str + CountTrailingZeros(mask) / sizeof(CharT);
+					}
+				}
+			#endif
+
+			constexpr size_t BLOCK16 = 16 / sizeof(CharT);
+			if (static_cast<size_t>(end - str) >= BLOCK16)
+			{
+				__m128i chars[MAX_BLOCK_CHARS];
+				for (size_t i = 0; i < m_Count; ++i)
+					chars[i] = Broadcast(m_Chars[i]);
+
+				for (; static_cast<size_t>(end - str) >= BLOCK16; str += BLOCK16)
+				{
+					const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+					__m128i eq = CmpEq(v, chars[0]);
+					for (size_t i = 1; i < m_Count; ++i)
+						eq = _mm_or_si128(eq, CmpEq(v, chars[i]));
+
+					if (const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq)))
+						return str + CountTrailingZeros(mask) / sizeof(CharT);
+				}
+			}
+
+			return str;
+		}
+
+		static __m128i Broadcast(CharT c) noexcept
+		{
+			if constexpr (sizeof(CharT) == 1)
+				return _mm_set1_epi8(static_cast<char>(c));
+			else if constexpr (sizeof(CharT) == 2)
+				return _mm_set1_epi16(static_cast<short>(c));
+			else
+				return _mm_set1_epi32(static_cast<int>(c));
+		}
+
+		static __m128i CmpEq(__m128i a, __m128i b) noexcept
+		{
+			if constexpr (sizeof(CharT) == 1)
+				return _mm_cmpeq_epi8(a, b);
+			else if constexpr (sizeof(CharT) == 2)
+				return _mm_cmpeq_epi16(a, b);
+			else
+				return _mm_cmpeq_epi32(a, b);
+		}
+
+		#if AML_AVX2
+			static __m256i CmpEq(__m256i a, __m256i b) noexcept
+			{
+				if constexpr (sizeof(CharT) == 1)
+					return _mm256_cmpeq_epi8(a, b);
+				else if constexpr (sizeof(CharT) == 2)
+					return _mm256_cmpeq_epi16(a, b);
+				else
+					return _mm256_cmpeq_epi32(a, b);
+			}
+		#endif
+	#endif
+
+	uint32_t m_Bitmap[8] = {};				// Битовая таблица символов с кодами меньше 256
+	CharT m_Chars[MAX_BLOCK_CHARS] = {};	// Первые MAX_BLOCK_CHARS символов множества
+	size_t m_Count = 0;						// Количество символов в множестве
+	std::basic_string<CharT> m_WideChars;	// Символы с кодами 256 и больше (только для wchar_t)
+};
+
+using CharClass = BasicCharClass<char>;
+using WCharClass = BasicCharClass<wchar_t>;
+
+} // namespace util
@@ -313,14 +313,7 @@ bool Console::GetInputEvent(KeyEvent& event)
 	thrd::Lock lock(s_IOLocks->input);
 
 	PollInput(false);
-	if (!m_InputEvents.empty())
-	{
-		event = m_InputEvents.front();
-		m_InputEvents.pop_front();
-		return true;
-	}
-
-	return false;
+	return m_InputEvents.TryPop(event);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -414,8 +407,8 @@ void Console::PollInput(bool forcePoll)
 							m_IsCtrlCPressed = true;
 
 						// При заполнении буфера игнорируем новые события
-						if (e.vkey && m_InputEvents.size() < MAX_KEY_EVENTS)
-							m_InputEvents.push_back(e);
+						if (e.vkey)
+							m_InputEvents.TryPush(e);
 					}
 				}
 			}
@@ -5,13 +5,13 @@
 #pragma once
 
 #include "platform.h"
+#include "ringbuffer.h"
 #include "singleton.h"
 #include "strcommon.h"
 #include "threadsync.h"
 #include "util.h"
 #include "vkey.h"
 
-#include <deque>
 #include <string_view>
 
 namespace util {
@@ -67,6 +67,7 @@ public:
 
 protected:
 	static constexpr size_t MAX_KEY_EVENTS = 64;
+	using InputEvents = FixedRingBuffer<KeyEvent, MAX_KEY_EVENTS>;
 
 	struct CtrlHandler;
 
@@ -94,7 +95,7 @@ protected:
 protected:
 	ConsoleInfo m_Info;
 	uint8_t m_KeyTT[256];						// Таблица трансляции кодов виртуальных клавиш
-	std::deque<KeyEvent> m_InputEvents;			// Буфер событий ввода
+	InputEvents m_InputEvents;					// Буфер событий ввода
 
 	int m_TextColor = -1;						// Текущий цвет текста
 	unsigned m_LastPollTime = 0;				// Время последней обработки событий ввода
@@ -5,6 +5,8 @@
 #include "pch.h"
 #include "exception.h"
 
+#include "memory.h"
+
 using namespace util;
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -48,7 +50,7 @@ void EGeneric::Tidy() noexcept
 {
 	if (m_What)
 	{
-		free(const_cast<char*>(m_What));
+		FreeBlock(const_cast<char*>(m_What));
 		m_What = nullptr;
 	}
 }
@@ -58,13 +60,21 @@ AML_NOINLINE const char* EGeneric::CopyString(const char* str, size_t size)
 {
 	if (size && size < ~size_t(0))
 	{
-		if (char* buffer = static_cast<char*>(malloc(size + 1)))
+		// Если выделить память не удалось, то исключение просто останется без сообщения
+		// (функция вызывается из конструкторов noexcept, поэтому перехватываем всё)
+		char* buffer;
+		try {
+			buffer = static_cast<char*>(AllocBlock(size + 1));
+		}
+		catch (...)
 		{
-			memcpy(buffer, str, size);
-			buffer[size] = 0;
-
-			return buffer;
+			return nullptr;
 		}
+
+		memcpy(buffer, str, size);
+		buffer[size] = 0;
+
+		return buffer;
 	}
 
 	return nullptr;
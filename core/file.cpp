@@ -8,8 +8,12 @@
 #include "array.h"
 #include "crc32.h"
 #include "filesystem.h"
+#include "memtrack.h"
+#include "pool.h"
 #include "winapi.h"
 
+#include <atomic>
+
 using namespace util;
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -355,6 +359,22 @@ bool BinaryFile::Truncate()
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SlabPool& GetBlockPool(size_t blockSize, size_t alignment)
+{
+	// Пул не удаляется при завершении программы, так как файлы могут закрываться в деструкторах
+	// статических объектов уже после уничтожения локальных статических переменных этой функции
+	static SlabPool* pool = new SlabPool(blockSize, alignment, GetHeapResource());
+	return *pool;
+}
+
+// Количество блоков общего пула, принадлежащих файлам (остальные блоки пула свободны)
+std::atomic<size_t> s_UsedBlockCount = 0;
+
+} // namespace
+
 //--------------------------------------------------------------------------------------------------------------------------------
 MemoryFile::~MemoryFile()
 {
@@ -367,7 +387,7 @@ bool MemoryFile::Open(unsigned flags)
 	if (m_OpenFlags)
 		return false;
 
-	m_Block = m_First = new Block;
+	m_Block = m_First = NewBlock();
 	m_First->header.prev = nullptr;
 	m_First->header.next = nullptr;
 
@@ -386,10 +406,25 @@ void MemoryFile::Close()
 	{
 		Block* p = block;
 		block = block->header.next;
-		delete p;
+		DeleteBlock(p);
 	}
 	m_Block = m_First = nullptr;
 	m_OpenFlags = 0;
+
+	// Пул удерживает свободные блоки для повторного использования, но не больше MAX_POOLED_SIZE байт
+	if (m_Resource == GetHeapResource())
+	{
+		SlabPool& pool = GetBlockPool(sizeof(Block), alignof(Block));
+		const size_t usedSize = s_UsedBlockCount.load(std::memory_order_relaxed) * sizeof(Block);
+		if (pool.GetAllocatedSize() > usedSize + MAX_POOLED_SIZE)
+			pool.Trim();
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void MemoryFile::TrimBlockPool()
+{
+	GetBlockPool(sizeof(Block), alignof(Block)).Trim();
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -492,7 +527,7 @@ bool MemoryFile::Truncate()
 	{
 		Block* p = block;
 		block = block->header.next;
-		delete p;
+		DeleteBlock(p);
 	}
 	m_Block->header.next = nullptr;
 	m_Size = m_Position;
@@ -537,6 +572,8 @@ MemoryFile& MemoryFile::operator =(MemoryFile&& that)
 	{
 		Close();
 
+		// Блоки файла that выделены из его источника памяти, поэтому вместе с ними забираем и источник
+		m_Resource = that.m_Resource;
 		m_First = that.m_First;
 		m_Block = that.m_Block;
 		m_BlockPos = that.m_BlockPos;
@@ -600,6 +637,32 @@ bool MemoryFile::GetCRC32Custom(uint32_t& crc, long long size)
 	}
 }
 
+//--------------------------------------------------------------------------------------------------------------------------------
+MemoryFile::Block* MemoryFile::NewBlock()
+{
+	MemTag tag("MemoryFile");
+	void* p;
+	if (m_Resource == GetHeapResource())
+	{
+		p = GetBlockPool(sizeof(Block), alignof(Block)).Allocate();
+		s_UsedBlockCount.fetch_add(1, std::memory_order_relaxed);
+	} else
+		p = m_Resource->allocate(sizeof(Block), alignof(Block));
+
+	return new(p) Block;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void MemoryFile::DeleteBlock(Block* block) noexcept
+{
+	if (m_Resource == GetHeapResource())
+	{
+		GetBlockPool(sizeof(Block), alignof(Block)).Deallocate(block);
+		s_UsedBlockCount.fetch_sub(1, std::memory_order_relaxed);
+	} else
+		m_Resource->deallocate(block, sizeof(Block), alignof(Block));
+}
+
 //--------------------------------------------------------------------------------------------------------------------------------
 inline void MemoryFile::Grow()
 {
@@ -607,7 +670,7 @@ inline void MemoryFile::Grow()
 		m_Block = m_Block->header.next;
 	else
 	{
-		Block* newBlock = new Block;
+		Block* newBlock = NewBlock();
 		newBlock->header.prev = m_Block;
 		newBlock->header.next = nullptr;
 		m_Block->header.next = newBlock;
@@ -4,10 +4,12 @@
 
 #pragma once
 
+#include "memory.h"
 #include "platform.h"
 #include "strcommon.h"
 #include "util.h"
 
+#include <memory_resource>
 #include <utility>
 
 namespace util {
@@ -133,7 +135,13 @@ protected:
 class MemoryFile : public File
 {
 public:
-	MemoryFile() = default;
+	// Блоки файла выделяются через источник памяти resource. Если он равен nullptr, то используется источник
+	// по умолчанию (см. GetDefaultResource). Если это куча (GetHeapResource), то блоки выделяются в общем пуле
+	explicit MemoryFile(std::pmr::memory_resource* resource = nullptr) noexcept
+		: m_Resource(GetResource(resource))
+	{
+	}
+
 	virtual ~MemoryFile() override;
 
 	bool Open(unsigned flags = FILE_OPEN_MEMORY);
@@ -155,6 +163,14 @@ public:
 
 	MemoryFile& operator =(MemoryFile&& that);
 
+	// Возвращает в кучу память всех свободных блоков общего пула (см. NewBlock). Функция Close делает это сама,
+	// если размер свободных блоков пула превышает MAX_POOLED_SIZE байт. До этого память свободных блоков остаётся
+	// выделенной и учитывается за меткой "MemoryFile" (см. MemTag)
+	static void TrimBlockPool();
+
+	// Максимальный размер свободных блоков, которые общий пул удерживает после закрытия файлов
+	static constexpr size_t MAX_POOLED_SIZE = 4 * 1024 * 1024;
+
 protected:
 	static constexpr unsigned FILE_OPEN_MEMORY = FILE_OPEN_READWRITE | FILE_CREATE_ALWAYS;
 	static constexpr size_t BLOCK_SIZE = 64 * 1024; // Размер блока (должен быть степенью 2)
@@ -166,12 +182,17 @@ protected:
 	};
 	struct Block {
 		BlockHeader header;
-		uint8_t data[BLOCK_SIZE];
+		alignas(AML_CACHE_LINE_SIZE) uint8_t data[BLOCK_SIZE];
 	};
 
 	virtual bool SaveToCustom(File& file) override;
 	virtual bool GetCRC32Custom(uint32_t& crc, long long size) override;
 
+	// Выделяет память под блок и удаляет блок. Если источник памяти файла - куча, то блоки выделяются в
+	// общем для всех файлов пуле (см. SlabPool), поэтому повторное открытие и запись файлов не обращаются к куче
+	Block* NewBlock();
+	void DeleteBlock(Block* block) noexcept;
+
 	void Grow();
 	void ApplyPosition();
 	void DoRead(void* buffer, size_t bytesToRead);
@@ -184,6 +205,8 @@ protected:
 
 	size_t m_Size = 0;			// Размер файла в байтах
 	size_t m_Position = 0;		// Текущая позиция файла
+
+	std::pmr::memory_resource* m_Resource;	// Источник памяти для блоков
 };
 
 } // namespace util
@@ -0,0 +1,424 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "array.h"
+#include "fasthash.h"
+#include "platform.h"
+#include "util.h"
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if AML_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   MapHash - функция хеширования ключей по умолчанию
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функтор MapHash вычисляет 32-битный хеш строк (std::string, std::string_view и строковых литералов дают одинаковый хеш,
+// поэтому их можно использовать для поиска в одном контейнере), а также чисел и перечислений. Числа хешируются по их
+// байтовому представлению, поэтому равные числа разных типов дают разные хеши (SmallMap приводит такие ключи к своему
+// типу ключа). Указатели не хешируются намеренно: иначе указатель на строку char* хешировался бы как адрес, а не как строка
+
+//--------------------------------------------------------------------------------------------------------------------------------
+struct MapHash
+{
+	unsigned operator ()(std::string_view key) const noexcept { return hash::GetFastHash(key); }
+	unsigned operator ()(std::wstring_view key) const noexcept { return hash::GetFastHash(key); }
+
+	template<class T, class = std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>>
+	unsigned operator ()(T key) const noexcept
+	{
+		// Значения -0.0 и 0.0 равны, но различаются байтовым представлением
+		if constexpr (std::is_floating_point_v<T>)
+			key = (key == 0) ? T(0) : key;
+		return hash::GetFastHash(&key, sizeof(T));
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   FlatMap - ассоциативный массив на основе отсортированного массива ключей
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс FlatMap хранит ключи в отсортированном массиве, а значения - в отдельном массиве в том же порядке. Поиск ключа
+// выполняется двоичным поиском и затрагивает только массив ключей, поэтому он быстрее поиска в std::map и не требует
+// выделения памяти под каждый элемент. Вставка и удаление сдвигают элементы, поэтому контейнер подходит для таблиц,
+// которые заполняются один раз (например, в конструкторе со списком инициализации), а затем только читаются. Если
+// функция сравнения прозрачная (как std::less<> по умолчанию), то искать можно по ключу любого сравнимого типа, например,
+// в FlatMap<std::string, int> по std::string_view без создания временной строки
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class K, class V, class Compare = std::less<>>
+class FlatMap final
+{
+public:
+	FlatMap() = default;
+
+	// Создаёт контейнер из списка пар. Если ключ в списке повторяется, то используется его первое значение
+	FlatMap(std::initializer_list<std::pair<K, V>> items)
+	{
+		std::vector<std::pair<K, V>> sorted(items);
+		std::stable_sort(sorted.begin(), sorted.end(), [this](const auto& a, const auto& b) {
+			return m_Compare(a.first, b.first);
+		});
+
+		m_Keys.reserve(sorted.size());
+		m_Values.reserve(sorted.size());
+		for (auto& item : sorted)
+		{
+			if (m_Keys.empty() || m_Compare(m_Keys.back(), item.first))
+			{
+				m_Keys.push_back(std::move(item.first));
+				m_Values.push_back(std::move(item.second));
+			}
+		}
+	}
+
+	size_t size() const noexcept { return m_Keys.size(); }
+	bool empty() const noexcept { return m_Keys.empty(); }
+
+	void clear() noexcept
+	{
+		m_Keys.clear();
+		m_Values.clear();
+	}
+
+	void reserve(size_t capacity)
+	{
+		m_Keys.reserve(capacity);
+		m_Values.reserve(capacity);
+	}
+
+	// Ищет элемент с ключом key. Возвращает указатель на его значение или nullptr, если ключ не найден
+	template<class Q> V* Find(const Q& key) noexcept
+	{
+		const size_t index = LowerBound(key);
+		return (index < m_Keys.size() && !m_Compare(key, m_Keys[index])) ? &m_Values[index] : nullptr;
+	}
+
+	template<class Q> const V* Find(const Q& key) const noexcept
+	{
+		return const_cast<FlatMap*>(this)->Find(key);
+	}
+
+	template<class Q> bool Contains(const Q& key) const noexcept
+	{
+		return Find(key) != nullptr;
+	}
+
+	// Добавляет элемент с ключом key, создавая его значение из аргументов args, если такого ключа ещё нет. Возвращает
+	// указатель на значение элемента с ключом key и true, если элемент был добавлен (false, если ключ уже был в контейнере)
+	template<class Q, class... Args> std::pair<V*, bool> TryEmplace(Q&& key, Args&&... args)
+	{
+		const size_t index = LowerBound(key);
+		if (index < m_Keys.size() && !m_Compare(key, m_Keys[index]))
+			return { &m_Values[index], false };
+
+		m_Keys.emplace(m_Keys.begin() + index, std::forward<Q>(key));
+		try {
+			m_Values.emplace(m_Values.begin() + index, std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			m_Keys.erase(m_Keys.begin() + index);
+			throw;
+		}
+		return { &m_Values[index], true };
+	}
+
+	// Добавляет элемент или заменяет значение существующего элемента с ключом key
+	template<class Q, class T> V& Insert(Q&& key, T&& value)
+	{
+		auto result = TryEmplace(std::forward<Q>(key), std::forward<T>(value));
+		if (!result.second)
+			*result.first = std::forward<T>(value);
+		return *result.first;
+	}
+
+	// Возвращает значение элемента с ключом key. Если такого ключа нет, то добавляет элемент со значением по умолчанию
+	template<class Q> V& operator [](Q&& key)
+	{
+		return *TryEmplace(std::forward<Q>(key)).first;
+	}
+
+	// Удаляет элемент с ключом key. Возвращает false, если такого ключа нет
+	template<class Q> bool Erase(const Q& key)
+	{
+		const size_t index = LowerBound(key);
+		if (index >= m_Keys.size() || m_Compare(key, m_Keys[index]))
+			return false;
+
+		m_Keys.erase(m_Keys.begin() + index);
+		m_Values.erase(m_Values.begin() + index);
+		return true;
+	}
+
+	// Доступ к элементам по индексу (элементы упорядочены по возрастанию ключей)
+	const K& KeyAt(size_t index) const noexcept { return m_Keys[index]; }
+	V& ValueAt(size_t index) noexcept { return m_Values[index]; }
+	const V& ValueAt(size_t index) const noexcept { return m_Values[index]; }
+
+	const std::vector<K>& GetKeys() const noexcept { return m_Keys; }
+	const std::vector<V>& GetValues() const noexcept { return m_Values; }
+
+private:
+	// Возвращает индекс первого ключа, не меньшего key
+	template<class Q> size_t LowerBound(const Q& key) const noexcept
+	{
+		return std::lower_bound(m_Keys.begin(), m_Keys.end(), key, m_Compare) - m_Keys.begin();
+	}
+
+private:
+	std::vector<K> m_Keys;		// Отсортированный массив ключей
+	std::vector<V> m_Values;	// Массив значений (в порядке ключей)
+	Compare m_Compare;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SmallMap - ассоциативный массив для малого количества элементов
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс SmallMap рассчитан на контейнеры из нескольких элементов (например, атрибуты тега или параметры запроса), где
+// хеш-таблица проигрывает простому перебору. Ключи, значения и 32-битные хеши ключей хранятся в отдельных массивах
+// (первые N элементов - внутри объекта, без выделения памяти в куче). Пока элементов не больше N, поиск перебирает
+// массив хешей (по 4 хеша за одно сравнение SSE2) и сравнивает ключи только при совпадении хеша. Когда элементов
+// становится больше N, контейнер строит индекс - хеш-таблицу с открытой адресацией, хранящую индексы элементов.
+// Порядок элементов совпадает с порядком их добавления, пока не удалён какой-либо элемент (удалённый элемент
+// заменяется последним). Для поиска можно использовать ключ любого типа, для которого функтор Hash даёт тот же
+// хеш, что и для исходного ключа, а функтор Equal умеет сравнивать его с ключами контейнера. Если ключи контейнера -
+// числа или перечисления, то ключ поиска сначала приводится к типу K (как при поиске в std::unordered_map)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class K, class V, size_t N = 8, class Hash = MapHash, class Equal = std::equal_to<>>
+class SmallMap final
+{
+	static constexpr size_t NOT_FOUND = size_t(-1);
+
+public:
+	SmallMap() = default;
+
+	size_t size() const noexcept { return m_Keys.size(); }
+	bool empty() const noexcept { return m_Keys.empty(); }
+
+	void clear() noexcept
+	{
+		m_Keys.clear();
+		m_Values.clear();
+		m_Hashes.clear();
+		m_Index.clear();
+	}
+
+	// Ищет элемент с ключом key. Возвращает указатель на его значение или nullptr, если ключ не найден
+	template<class Q> V* Find(const Q& key) noexcept
+	{
+		const auto& lookupKey = ToLookupKey(key);
+		const size_t index = FindIndex(lookupKey, m_Hash(lookupKey));
+		return (index != NOT_FOUND) ? &m_Values[index] : nullptr;
+	}
+
+	template<class Q> const V* Find(const Q& key) const noexcept
+	{
+		return const_cast<SmallMap*>(this)->Find(key);
+	}
+
+	template<class Q> bool Contains(const Q& key) const noexcept
+	{
+		return Find(key) != nullptr;
+	}
+
+	// Добавляет элемент с ключом key, создавая его значение из аргументов args, если такого ключа ещё нет. Возвращает
+	// указатель на значение элемента с ключом key и true, если элемент был добавлен (false, если ключ уже был в контейнере)
+	template<class Q, class... Args> std::pair<V*, bool> TryEmplace(Q&& key, Args&&... args)
+	{
+		const auto& lookupKey = ToLookupKey(key);
+		const uint32_t hash = m_Hash(lookupKey);
+		const size_t found = FindIndex(lookupKey, hash);
+		if (found != NOT_FOUND)
+			return { &m_Values[found], false };
+
+		// Индекс перестраиваем до добавления элемента: если выделить память
+		// не удастся, то контейнер останется в исходном состоянии
+		const size_t index = m_Keys.size();
+		if (index >= N && (index + 1) * 2 > m_Index.size())
+			RebuildIndex(index + 1);
+
+		m_Hashes.push_back(hash);
+		try {
+			m_Keys.emplace_back(std::forward<Q>(key));
+			try {
+				m_Values.emplace_back(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				m_Keys.pop_back();
+				throw;
+			}
+		}
+		catch (...)
+		{
+			m_Hashes.pop_back();
+			throw;
+		}
+
+		if (!m_Index.empty())
+			AddToIndex(index);
+		return { &m_Values[index], true };
+	}
+
+	// Добавляет элемент или заменяет значение существующего элемента с ключом key
+	template<class Q, class T> V& Insert(Q&& key, T&& value)
+	{
+		auto result = TryEmplace(std::forward<Q>(key), std::forward<T>(value));
+		if (!result.second)
+			*result.first = std::forward<T>(value);
+		return *result.first;
+	}
+
+	// Возвращает значение элемента с ключом key. Если такого ключа нет, то добавляет элемент со значением по умолчанию
+	template<class Q> V& operator [](Q&& key)
+	{
+		return *TryEmplace(std::forward<Q>(key)).first;
+	}
+
+	// Удаляет элемент с ключом key (его место занимает последний элемент). Возвращает false, если такого ключа нет.
+	// Если построен индекс, то он перестраивается заново, поэтому время удаления пропорционально размеру контейнера
+	template<class Q> bool Erase(const Q& key)
+	{
+		const auto& lookupKey = ToLookupKey(key);
+		const size_t index = FindIndex(lookupKey, m_Hash(lookupKey));
+		if (index == NOT_FOUND)
+			return false;
+
+		const size_t last = m_Keys.size() - 1;
+		if (index != last)
+		{
+			m_Keys[index] = std::move(m_Keys[last]);
+			m_Values[index] = std::move(m_Values[last]);
+			m_Hashes[index] = m_Hashes[last];
+		}
+
+		m_Keys.pop_back();
+		m_Values.pop_back();
+		m_Hashes.pop_back();
+
+		if (last <= N)
+			m_Index.clear();
+		else if (!m_Index.empty())
+			RebuildIndex(last);
+		return true;
+	}
+
+	// Доступ к элементам по индексу (от 0 до size() - 1)
+	const K& KeyAt(size_t index) const noexcept { return m_Keys[index]; }
+	V& ValueAt(size_t index) noexcept { return m_Values[index]; }
+	const V& ValueAt(size_t index) const noexcept { return m_Values[index]; }
+
+	// Возвращает true, если поиск выполняется по индексу (элементов больше N)
+	bool HasIndex() const noexcept { return !m_Index.empty(); }
+
+private:
+	// Возвращает ключ поиска: числа и перечисления приводятся к типу K, так как функтор MapHash хеширует их байтовое
+	// представление (иначе, например, поиск по int в контейнере с ключами int64_t не находил бы элемент)
+	template<class Q> static decltype(auto) ToLookupKey(const Q& key) noexcept
+	{
+		if constexpr (std::is_arithmetic_v<K> || std::is_enum_v<K>)
+			return static_cast<K>(key);
+		else
+			return key;
+	}
+
+	// Возвращает индекс элемента с ключом key (хеш ключа равен hash) или NOT_FOUND
+	template<class Q> size_t FindIndex(const Q& key, uint32_t hash) const noexcept
+	{
+		if (!m_Index.empty())
+		{
+			const size_t mask = m_Index.size() - 1;
+			for (size_t pos = hash & mask; m_Index[pos]; pos = (pos + 1) & mask)
+			{
+				const size_t index = m_Index[pos] - 1;
+				if (m_Hashes[index] == hash && m_Equal(m_Keys[index], key))
+					return index;
+			}
+			return NOT_FOUND;
+		}
+
+		const uint32_t* hashes = m_Hashes.data();
+		const size_t count = m_Hashes.size();
+		size_t i = 0;
+
+		#if AML_SSE2
+			const __m128i pattern = _mm_set1_epi32(static_cast<int>(hash));
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hashes + i));
+				unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, pattern)));
+				for (; mask; mask &= mask - 1)
+				{
+					const size_t index = i + CountTrailingZeros(static_cast<uint32_t>(mask));
+					if (m_Equal(m_Keys[index], key))
+						return index;
+				}
+			}
+		#endif
+
+		for (; i < count; ++i)
+		{
+			if (hashes[i] == hash && m_Equal(m_Keys[i], key))
+				return i;
+		}
+		return NOT_FOUND;
+	}
+
+	// Строит индекс заново так, чтобы в нём поместилось не менее count элементов
+	AML_NOINLINE void RebuildIndex(size_t count)
+	{
+		// Таблица заполнена не более чем наполовину, поэтому цепочки при линейном пробировании короткие
+		size_t tableSize = 16;
+		while (tableSize < count * 2)
+			tableSize <<= 1;
+
+		std::vector<uint32_t> table(tableSize);
+		m_Index.swap(table);
+		for (size_t i = 0, size = m_Keys.size(); i < size; ++i)
+			AddToIndex(i);
+	}
+
+	// Добавляет в индекс элемент с индексом index
+	void AddToIndex(size_t index) noexcept
+	{
+		const size_t mask = m_Index.size() - 1;
+		size_t pos = m_Hashes[index] & mask;
+		while (m_Index[pos])
+			pos = (pos + 1) & mask;
+
+		m_Index[pos] = static_cast<uint32_t>(index + 1);
+	}
+
+private:
+	SmallVector<K, N> m_Keys;			// Массив ключей
+	SmallVector<V, N> m_Values;			// Массив значений
+	SmallVector<uint32_t, N> m_Hashes;	// Массив хешей ключей
+	std::vector<uint32_t> m_Index;		// Хеш-таблица индексов элементов плюс 1 (0 - пустая ячейка)
+	Hash m_Hash;
+	Equal m_Equal;
+};
+
+} // namespace util
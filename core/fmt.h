@@ -0,0 +1,643 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "platform.h"
+#include "strformat.h"
+#include "strutil.h"
+
+#include <array>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Форматирование строк по шаблону с заполнителями {}
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функции FormatTo и Format этого раздела форматируют строку по шаблону, заданному макросом AML_FMT. Шаблон разбирается во
+// время компиляции: несоответствие количества или типов аргументов шаблону, а также ошибки в самом шаблоне приводят к
+// ошибке компиляции. Каждый аргумент выводится кодом, выбранным по его типу (без va_list и без повторного разбора
+// шаблона), прямо в объект StringWriter (или Formatter) без промежуточных буферов. Пример использования:
+//
+//   Formatter<char> out;
+//   FormatTo(out, AML_FMT("{} + {:#06x} = {:.2f}"), name, value, 1.5);
+//   std::wstring str = Format(AML_FMT(L"[{:>8}]"), L"text");
+//
+// Заполнитель имеет вид {[индекс][:[[заполнитель]выравнивание][знак][#][0][ширина][.точность][тип]]} (подмножество
+// синтаксиса std::format). Индексы аргументов либо указываются во всех заполнителях, либо не указываются ни в одном.
+// Символы { и } в тексте записываются как {{ и }}. Выравнивание: '<' (по умолчанию для строк), '>' (по умолчанию для
+// чисел) или '^'. Ширина и точность измеряются в символах типа CharT. Допустимые типы:
+//
+//   bool                        - без типа или 's': "true" или "false"
+//   символы CharT               - без типа или 'c'; символы char выводятся и в строки wchar_t (символы выше 0x7F
+//                                 заменяются на U+FFFD), а символы wchar_t в строки char не выводятся
+//   целые числа и перечисления  - 'd' (по умолчанию), 'x', 'X', 'b', 'B', 'o'; флаг '#' добавляет префикс (0x, 0b, 0)
+//   числа с плавающей запятой   - без типа: кратчайшая запись, при чтении которой получается то же значение (с точностью -
+//                                 как у типа 'g'), 'f', 'F', 'e', 'E', 'g', 'G' (точность по умолчанию 6, не больше 100)
+//   строки CharT                - без типа или 's', точность ограничивает количество выводимых символов
+//   указатели                   - без типа или 'p': адрес в шестнадцатеричном виде с префиксом 0x
+//   объекты с функцией ToString - выводится результат функции ToString с тем же заполнителем
+//
+// Разделителем целой и дробной частей чисел независимо от локали всегда является точка. Строки с символами
+// другого типа (например, std::string при выводе в строку Wide) не поддерживаются
+
+// Макрос AML_FMT создаёт объект шаблона форматирования из строкового литерала STRING (char или wchar_t)
+#define AML_FMT(STRING) ([] { \
+	struct FormatStringType : util::FormatStringBase { \
+		static constexpr auto Get() noexcept { return std::basic_string_view(STRING); } \
+	}; \
+	return FormatStringType(); }())
+
+// Базовый класс для объектов, создаваемых макросом AML_FMT
+struct FormatStringBase {};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class FormatEngine
+{
+public:
+	static constexpr size_t NO_ARG = ~size_t(0);
+	static constexpr int MAX_FLOAT_PRECISION = 100;
+
+	enum class Error : uint8_t
+	{
+		None,
+		UnmatchedBrace,		// Непарный символ { или }
+		InvalidSpec,		// Ошибка в описании формата заполнителя
+		MixedIndexing,		// Индексы указаны не во всех заполнителях
+		BadIndex,			// Индекс больше или равен количеству аргументов
+		UnusedArgument,		// Аргумент не используется ни в одном заполнителе
+		TypeMismatch,		// Формат заполнителя не подходит для типа аргумента
+		UnsupportedType		// Тип аргумента не поддерживается
+	};
+
+	enum class ArgKind : uint8_t
+	{
+		Unsupported, Bool, Char, Int, Float, String, Pointer
+	};
+
+	// Описание формата заполнителя
+	struct Spec
+	{
+		char32_t fill = ' ';		// Символ-заполнитель
+		char align = 0;				// Выравнивание: '<', '>', '^' или 0 (по умолчанию)
+		char sign = 0;				// Знак: '+', ' ', '-' или 0 (по умолчанию)
+		bool alternate = false;		// Флаг '#' (вывод префикса)
+		bool zeroPad = false;		// Флаг '0' (дополнение числа нолями после знака и префикса)
+		int width = 0;				// Минимальная ширина поля
+		int precision = -1;			// Точность или -1, если она не задана
+		char type = 0;				// Тип или 0, если он не задан
+	};
+
+	// Элемент шаблона: текст длиной textSize символов с позиции textPos, за которым следует заполнитель
+	// для аргумента arg (или ничего, если arg равен NO_ARG) с форматом spec
+	struct Item
+	{
+		size_t textPos = 0;
+		size_t textSize = 0;
+		size_t arg = NO_ARG;
+		Spec spec;
+	};
+
+	struct ParseResult
+	{
+		size_t count = 0;			// Количество элементов шаблона
+		Error error = Error::None;
+	};
+
+	// Разбирает шаблон str. Если items не равен nullptr, то сохраняет в этот массив элементы шаблона
+	template<class CharT>
+	static constexpr ParseResult Parse(std::basic_string_view<CharT> str, Item* items) noexcept
+	{
+		ParseResult result;
+		size_t textPos = 0, nextArg = 0;
+		bool autoIndex = false, manualIndex = false;
+
+		auto add = [&](size_t textEnd, size_t arg, const Spec& spec) {
+			if (items)
+				items[result.count] = Item { textPos, textEnd - textPos, arg, spec };
+			++result.count;
+		};
+
+		const size_t size = str.size();
+		for (size_t i = 0; i < size;)
+		{
+			const CharT c = str[i];
+			if (c != '{' && c != '}')
+			{
+				++i;
+				continue;
+			}
+
+			// Символы {{ и }} выводятся как { и }: текст до первого из них включительно добавляется отдельным элементом
+			if (i + 1 < size && str[i + 1] == c)
+			{
+				add(i + 1, NO_ARG, Spec());
+				textPos = i += 2;
+				continue;
+			}
+			if (c == '}')
+				return { result.count, Error::UnmatchedBrace };
+
+			const size_t textEnd = i++;
+			size_t arg = 0;
+			if (i < size && IsDigit(str[i]))
+			{
+				for (; i < size && IsDigit(str[i]); ++i)
+					arg = arg * 10 + (str[i] - '0');
+				manualIndex = true;
+			} else
+			{
+				arg = nextArg++;
+				autoIndex = true;
+			}
+
+			if (autoIndex && manualIndex)
+				return { result.count, Error::MixedIndexing };
+
+			Spec spec;
+			if (i < size && str[i] == ':')
+			{
+				if (!ParseSpec(str, ++i, spec))
+					return { result.count, Error::InvalidSpec };
+			}
+
+			if (i >= size)
+				return { result.count, Error::UnmatchedBrace };
+			if (str[i] != '}')
+				return { result.count, Error::InvalidSpec };
+
+			add(textEnd, arg, spec);
+			textPos = ++i;
+		}
+
+		if (textPos < size)
+			add(size, NO_ARG, Spec());
+
+		return result;
+	}
+
+	// Возвращает вид аргумента типа T при выводе в строку с символами CharT. Если параметр useToString равен
+	// true, то для объектов с функцией ToString возвращается вид результата этой функции
+	template<class CharT, class T, bool useToString = true>
+	static constexpr ArgKind GetArgKind() noexcept
+	{
+		using U = std::decay_t<T>;
+		if constexpr (std::is_same_v<U, bool>)
+			return ArgKind::Bool;
+		else if constexpr (std::is_same_v<U, CharT> || (std::is_same_v<U, char> && std::is_same_v<CharT, wchar_t>))
+			return ArgKind::Char;
+		else if constexpr (std::is_same_v<U, wchar_t> || std::is_same_v<U, char16_t> || std::is_same_v<U, char32_t>)
+			return ArgKind::Unsupported;
+		else if constexpr (std::is_integral_v<U> || std::is_enum_v<U>)
+			return ArgKind::Int;
+		else if constexpr (std::is_floating_point_v<U>)
+			return ArgKind::Float;
+		else if constexpr (std::is_null_pointer_v<U>)
+			return ArgKind::Pointer;
+		else if constexpr (std::is_convertible_v<const U&, std::basic_string_view<CharT>>)
+			return ArgKind::String;
+		else if constexpr (std::is_pointer_v<U>)
+		{
+			// Строки с символами другого типа не выводятся как указатели
+			using V = std::remove_cv_t<std::remove_pointer_t<U>>;
+			if constexpr (std::is_same_v<V, char> || std::is_same_v<V, wchar_t>)
+				return ArgKind::Unsupported;
+			else
+				return ArgKind::Pointer;
+		}
+		else if constexpr (useToString && HasToString<U>::value)
+			return GetArgKind<CharT, decltype(std::declval<const U&>().ToString())>();
+		else
+			return ArgKind::Unsupported;
+	}
+
+	// Проверяет шаблон S для аргументов типов Args и возвращает код ошибки
+	template<class S, class... Args>
+	static constexpr Error Check() noexcept
+	{
+		using CharT = typename decltype(S::Get())::value_type;
+		constexpr auto str = S::Get();
+		constexpr size_t count = Parse(str, static_cast<Item*>(nullptr)).count;
+
+		if constexpr (constexpr Error error = Parse(str, static_cast<Item*>(nullptr)).error; error != Error::None)
+			return error;
+		else
+		{
+			constexpr size_t ARG_COUNT = sizeof...(Args);
+			constexpr ArgKind kinds[ARG_COUNT + 1] = { GetArgKind<CharT, Args>()..., ArgKind::Unsupported };
+			bool used[ARG_COUNT + 1] = {};
+
+			Item items[count + 1] = {};
+			Parse(str, items);
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (const size_t arg = items[i].arg; arg != NO_ARG)
+				{
+					if (arg >= ARG_COUNT)
+						return Error::BadIndex;
+					if (kinds[arg] == ArgKind::Unsupported)
+						return Error::UnsupportedType;
+					if (!IsSpecValid(items[i].spec, kinds[arg]))
+						return Error::TypeMismatch;
+					used[arg] = true;
+				}
+			}
+
+			for (size_t i = 0; i < ARG_COUNT; ++i)
+			{
+				if (!used[i])
+					return Error::UnusedArgument;
+			}
+
+			return Error::None;
+		}
+	}
+
+	// Возвращает массив из N элементов шаблона str
+	template<size_t N, class CharT>
+	static constexpr std::array<Item, N> GetItems(std::basic_string_view<CharT> str) noexcept
+	{
+		std::array<Item, N> items = {};
+		if constexpr (N != 0)
+			Parse(str, items.data());
+		return items;
+	}
+
+	// Элементы шаблона S, разобранного во время компиляции
+	template<class S>
+	struct Parsed
+	{
+		static constexpr auto str = S::Get();
+		static constexpr size_t count = Parse(str, static_cast<Item*>(nullptr)).count;
+		static constexpr std::array<Item, count> items = GetItems<count>(str);
+	};
+
+	// Выводит в out текст и аргумент каждого элемента шаблона P
+	template<class P, class CharT, size_t N, class Tuple, size_t... I>
+	static void Write(StringWriter<CharT, N>& out, const Tuple& args, std::index_sequence<I...>)
+	{
+		(WriteItem<P, I>(out, args), ...);
+	}
+
+	// Выводит аргумент value в соответствии с форматом spec
+	template<class CharT, size_t N, class T>
+	static void WriteArg(StringWriter<CharT, N>& out, const T& value, const Spec& spec)
+	{
+		using U = std::decay_t<T>;
+		constexpr ArgKind kind = GetArgKind<CharT, T, false>();
+
+		if constexpr (kind == ArgKind::Bool)
+		{
+			if constexpr (std::is_same_v<CharT, wchar_t>)
+				WriteString(out, value ? std::wstring_view(L"true") : std::wstring_view(L"false"), spec);
+			else
+				WriteString(out, value ? std::string_view("true") : std::string_view("false"), spec);
+		}
+		else if constexpr (kind == ArgKind::Char)
+		{
+			WritePadding(out, spec, 1, '<', false);
+			out.Append(value);
+			WritePadding(out, spec, 1, '<', true);
+		}
+		else if constexpr (kind == ArgKind::Int)
+		{
+			if constexpr (std::is_enum_v<U>)
+				WriteInt(out, static_cast<std::underlying_type_t<U>>(value), spec);
+			else
+				WriteInt(out, value, spec);
+		}
+		else if constexpr (kind == ArgKind::Float)
+			WriteFloat(out, value, spec);
+		else if constexpr (kind == ArgKind::String)
+			WriteString(out, std::basic_string_view<CharT>(value), spec);
+		else if constexpr (kind == ArgKind::Pointer)
+		{
+			CharT buffer[20];
+			CharT* const end = buffer + CountOf(buffer);
+			CharT* p = NumberChars::PutPow2<4>(end, reinterpret_cast<uintptr_t>(static_cast<const void*>(value)));
+			*(--p) = 'x';
+			*(--p) = '0';
+			WriteNumber(out, p, end - p, 2, spec);
+		} else
+		{
+			auto&& data = value.ToString();
+			WriteArg(out, data, spec);
+		}
+	}
+
+protected:
+	template<class T, class = void>
+	struct HasToString : std::false_type {};
+
+	template<class T>
+	struct HasToString<T, std::void_t<decltype(std::declval<const T&>().ToString())>> : std::true_type {};
+
+	template<class CharT>
+	static constexpr bool IsDigit(CharT c) noexcept
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	template<class CharT>
+	static constexpr bool IsAlign(CharT c) noexcept
+	{
+		return c == '<' || c == '>' || c == '^';
+	}
+
+	// Разбирает описание формата заполнителя с позиции pos строки str до символа '}'
+	template<class CharT>
+	static constexpr bool ParseSpec(std::basic_string_view<CharT> str, size_t& pos, Spec& spec) noexcept
+	{
+		const size_t size = str.size();
+		size_t i = pos;
+
+		if (i + 1 < size && IsAlign(str[i + 1]) && str[i] != '{' && str[i] != '}')
+		{
+			spec.fill = static_cast<char32_t>(str[i]);
+			spec.align = static_cast<char>(str[i + 1]);
+			i += 2;
+		}
+		else if (i < size && IsAlign(str[i]))
+			spec.align = static_cast<char>(str[i++]);
+
+		if (i < size && (str[i] == '+' || str[i] == '-' || str[i] == ' '))
+			spec.sign = static_cast<char>(str[i++]);
+		if (i < size && str[i] == '#')
+		{
+			spec.alternate = true;
+			++i;
+		}
+		if (i < size && str[i] == '0')
+		{
+			spec.zeroPad = true;
+			++i;
+		}
+
+		for (; i < size && IsDigit(str[i]); ++i)
+		{
+			spec.width = spec.width * 10 + (str[i] - '0');
+			if (spec.width > 0xffff)
+				return false;
+		}
+
+		if (i < size && str[i] == '.')
+		{
+			if (++i >= size || !IsDigit(str[i]))
+				return false;
+
+			for (spec.precision = 0; i < size && IsDigit(str[i]); ++i)
+			{
+				spec.precision = spec.precision * 10 + (str[i] - '0');
+				if (spec.precision > 0xffff)
+					return false;
+			}
+		}
+
+		if (i < size && str[i] != '}')
+		{
+			constexpr std::string_view TYPES = "bBcdeEfFgGopsxX";
+			if (str[i] > 0x7f || TYPES.find(static_cast<char>(str[i])) == TYPES.npos)
+				return false;
+			spec.type = static_cast<char>(str[i++]);
+		}
+
+		pos = i;
+		return true;
+	}
+
+	// Возвращает true, если формат spec подходит для аргумента вида kind
+	static constexpr bool IsSpecValid(const Spec& spec, ArgKind kind) noexcept
+	{
+		const char t = spec.type;
+		const bool isNumeric = kind == ArgKind::Int || kind == ArgKind::Float;
+		if (!isNumeric && (spec.sign || spec.alternate || spec.zeroPad))
+			return false;
+
+		switch (kind)
+		{
+		case ArgKind::Bool:
+			return spec.precision < 0 && (!t || t == 's');
+		case ArgKind::Char:
+			return spec.precision < 0 && (!t || t == 'c');
+		case ArgKind::Int:
+			return spec.precision < 0 && (!t || t == 'd' || t == 'x' || t == 'X' || t == 'b' || t == 'B' || t == 'o');
+		case ArgKind::Float:
+			return !spec.alternate && spec.precision <= MAX_FLOAT_PRECISION && (!t || t == 'f' || t == 'F' ||
+				t == 'e' || t == 'E' || t == 'g' || t == 'G');
+		case ArgKind::String:
+			return !t || t == 's';
+		case ArgKind::Pointer:
+			return spec.precision < 0 && (!t || t == 'p');
+		default:
+			return false;
+		}
+	}
+
+	template<class P, size_t I, class CharT, size_t N, class Tuple>
+	static void WriteItem(StringWriter<CharT, N>& out, const Tuple& args)
+	{
+		constexpr Item item = P::items[I];
+		if constexpr (item.textSize == 1)
+			out.Append(P::str[item.textPos]);
+		else if constexpr (item.textSize != 0)
+			out.Append(P::str.data() + item.textPos, item.textSize);
+
+		if constexpr (item.arg != NO_ARG)
+			WriteArg(out, std::get<item.arg>(args), item.spec);
+	}
+
+	// Выводит символы заполнителя перед значением (если after равен false) или после него (если after равен true).
+	// Параметр size задаёт длину значения, а defAlign - выравнивание по умолчанию для аргументов этого вида
+	template<class CharT, size_t N>
+	static void WritePadding(StringWriter<CharT, N>& out, const Spec& spec, size_t size, char defAlign, bool after)
+	{
+		const size_t width = spec.width;
+		if (width <= size)
+			return;
+
+		const size_t pad = width - size;
+		const char align = spec.align ? spec.align : defAlign;
+		const size_t left = (align == '>') ? pad : (align == '^') ? pad / 2 : 0;
+
+		const CharT fill = static_cast<CharT>(spec.fill);
+		for (size_t i = after ? pad - left : left; i; --i)
+			out.Append(fill);
+	}
+
+	template<class CharT, size_t N>
+	static void WriteString(StringWriter<CharT, N>& out, std::basic_string_view<CharT> str, const Spec& spec)
+	{
+		if (spec.precision >= 0 && str.size() > static_cast<size_t>(spec.precision))
+			str = str.substr(0, spec.precision);
+
+		WritePadding(out, spec, str.size(), '<', false);
+		out.Append(str.data(), str.size());
+		WritePadding(out, spec, str.size(), '<', true);
+	}
+
+	// Выводит число str длиной size символов, первые prefixSize из которых - знак и префикс
+	template<class CharT, size_t N, class SrcT>
+	static void WriteNumber(StringWriter<CharT, N>& out, const SrcT* str, size_t size, size_t prefixSize, const Spec& spec)
+	{
+		if (spec.zeroPad && !spec.align && static_cast<size_t>(spec.width) > size)
+		{
+			AppendChars(out, str, prefixSize);
+			for (size_t i = spec.width - size; i; --i)
+				out.Append(static_cast<CharT>('0'));
+			AppendChars(out, str + prefixSize, size - prefixSize);
+		} else
+		{
+			WritePadding(out, spec, size, '>', false);
+			AppendChars(out, str, size);
+			WritePadding(out, spec, size, '>', true);
+		}
+	}
+
+	template<class CharT, size_t N, class SrcT>
+	static void AppendChars(StringWriter<CharT, N>& out, const SrcT* str, size_t size)
+	{
+		if constexpr (std::is_same_v<CharT, SrcT>)
+			out.Append(str, size);
+		else
+		{
+			for (size_t i = 0; i < size; ++i)
+				out.Append(static_cast<CharT>(str[i]));
+		}
+	}
+
+	template<class CharT, size_t N, class T>
+	static void WriteInt(StringWriter<CharT, N>& out, T value, const Spec& spec)
+	{
+		using U = std::conditional_t<(sizeof(T) <= 4), uint32_t, uint64_t>;
+		const U v = static_cast<U>(value);
+
+		bool isNegative = false;
+		if constexpr (std::is_signed_v<T>)
+			isNegative = value < 0;
+
+		CharT buffer[64 + 3];
+		CharT* const end = buffer + CountOf(buffer);
+		CharT* p;
+
+		const char t = spec.type;
+		switch (t)
+		{
+		case 'x':
+		case 'X':
+			p = NumberChars::PutPow2<4>(end, isNegative ? 0 - v : v, t == 'X');
+			break;
+		case 'b':
+		case 'B':
+			p = NumberChars::PutPow2<1>(end, isNegative ? 0 - v : v);
+			break;
+		case 'o':
+			p = NumberChars::PutPow2<3>(end, isNegative ? 0 - v : v);
+			break;
+		default:
+			p = NumberChars::PutDecimal(end, isNegative ? U(0 - v) : v);
+		}
+
+		CharT* const digits = p;
+		if (spec.alternate && t && t != 'd')
+		{
+			if (t != 'o')
+				*(--p) = t;
+			*(--p) = '0';
+		}
+
+		if (isNegative)
+			*(--p) = '-';
+		else if (spec.sign == '+' || spec.sign == ' ')
+			*(--p) = spec.sign;
+
+		WriteNumber(out, p, end - p, digits - p, spec);
+	}
+
+	template<class CharT, size_t N, class T>
+	static void WriteFloat(StringWriter<CharT, N>& out, T value, const Spec& spec)
+	{
+		// Наибольшая длина: знак, 309 цифр целой части, точка и MAX_FLOAT_PRECISION цифр дробной части
+		char buffer[1 + 309 + 1 + MAX_FLOAT_PRECISION + 8];
+		char* p = buffer + 1;
+		char* const end = buffer + CountOf(buffer);
+
+		size_t size = 0;
+		const char t = spec.type;
+		if (!t && spec.precision < 0)
+		{
+			if (const auto result = std::to_chars(p, end, value); result.ec == std::errc())
+				size = result.ptr - p;
+		} else
+		{
+			const char type = t ? static_cast<char>(t | 0x20) : 'g';
+			size = NumberChars::PutFloat(p, end - p, value, type, (spec.precision < 0) ? 6 : spec.precision);
+		}
+
+		if (t == 'F' || t == 'E' || t == 'G')
+		{
+			for (size_t i = 0; i < size; ++i)
+			{
+				if (p[i] >= 'a' && p[i] <= 'z')
+					p[i] = static_cast<char>(p[i] - 32);
+			}
+		}
+
+		size_t prefixSize = (size && *p == '-') ? 1 : 0;
+		if (!prefixSize && (spec.sign == '+' || spec.sign == ' '))
+		{
+			*(--p) = spec.sign;
+			prefixSize = 1;
+			++size;
+		}
+
+		WriteNumber(out, p, size, prefixSize, spec);
+	}
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+// Добавляет в out строку, отформатированную по шаблону fmt (см. AML_FMT) с аргументами args
+template<class CharT, size_t N, class S, class... Args, class = std::enable_if_t<std::is_base_of_v<FormatStringBase, S>>>
+void FormatTo(StringWriter<CharT, N>& out, S, const Args&... args)
+{
+	using E = FormatEngine;
+	static_assert(std::is_same_v<typename decltype(S::Get())::value_type, CharT>,
+		"Format string and output must have the same character type");
+
+	constexpr E::Error error = E::Check<S, Args...>();
+	static_assert(error != E::Error::UnmatchedBrace, "Format string has an unmatched '{' or '}'");
+	static_assert(error != E::Error::InvalidSpec, "Format string has an invalid format specification");
+	static_assert(error != E::Error::MixedIndexing, "Format string mixes automatic and manual argument indexing");
+	static_assert(error != E::Error::BadIndex, "Format string refers to a missing argument");
+	static_assert(error != E::Error::UnusedArgument, "Format argument is not used by the format string");
+	static_assert(error != E::Error::TypeMismatch, "Format specification does not match the argument type");
+	static_assert(error != E::Error::UnsupportedType, "Format argument type is not supported");
+
+	if constexpr (error == E::Error::None)
+	{
+		using P = E::Parsed<S>;
+		E::Write<P>(out, std::forward_as_tuple(args...), std::make_index_sequence<P::count>());
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+// Возвращает строку, отформатированную по шаблону fmt (см. AML_FMT) с аргументами args
+template<class S, class... Args, class = std::enable_if_t<std::is_base_of_v<FormatStringBase, S>>>
+auto Format(S fmt, const Args&... args)
+{
+	StringWriter<typename decltype(S::Get())::value_type> out;
+	FormatTo(out, fmt, args...);
+
+	return out.ToString();
+}
+
+} // namespace util
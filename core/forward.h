@@ -15,6 +15,7 @@ namespace math {
 
 namespace thrd {
 	class CriticalSection;
+	class ShardedCounter;
 }
 
 namespace util {
@@ -33,8 +34,13 @@ namespace util {
 	class Log;
 	class Logable;
 	class LogRecord;
+	// Распределители памяти
+	class Arena;
+	class ArenaResource;
+	class SlabPool;
 	// Разное
 	class AssertHandler;
+	class Atom;
 	class Console;
 	class FuncToggle;
 	class VirtualKey;
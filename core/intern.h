@@ -0,0 +1,289 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "arena.h"
+#include "exception.h"
+#include "fasthash.h"
+#include "platform.h"
+#include "threadsync.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Atom - идентификатор строки в таблице BasicInternTable
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Объект Atom хранит 32-битный идентификатор строки, добавленной в таблицу BasicInternTable. Одинаковые строки одной
+// таблицы всегда имеют одинаковые идентификаторы, поэтому строки сравниваются сравнением идентификаторов. Пустой строке
+// соответствует идентификатор 0 (атом по умолчанию). Сравнивать можно только атомы, полученные из одной таблицы
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class Atom final
+{
+	template<class CharT, unsigned shardCount, bool threadSafe> friend class BasicInternTable;
+
+public:
+	constexpr Atom() noexcept = default;
+
+	// Создаёт атом с идентификатором id, ранее полученным функцией GetId
+	static constexpr Atom FromId(uint32_t id) noexcept { return Atom(id); }
+
+	// Возвращает идентификатор строки
+	constexpr uint32_t GetId() const noexcept { return m_Id; }
+	// Возвращает true, если атом соответствует пустой строке
+	constexpr bool IsEmpty() const noexcept { return !m_Id; }
+
+	constexpr bool operator ==(Atom that) const noexcept { return m_Id == that.m_Id; }
+	constexpr bool operator !=(Atom that) const noexcept { return m_Id != that.m_Id; }
+	// Сравнивает идентификаторы (а не строки), например, для использования атомов как ключей std::map
+	constexpr bool operator <(Atom that) const noexcept { return m_Id < that.m_Id; }
+
+private:
+	explicit constexpr Atom(uint32_t id) noexcept
+		: m_Id(id)
+	{
+	}
+
+	uint32_t m_Id = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   BasicInternTable - таблица уникальных строк
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс BasicInternTable хранит каждую добавленную строку в одном экземпляре и выдаёт для неё атом (см. Atom). Таблица
+// разделена на shardCount частей, часть выбирается по хешу строки (GetFastHash). У каждой части своя критическая секция,
+// своя арена для строк и своя хеш-таблица, поэтому потоки, добавляющие разные строки, редко конкурируют друг с другом.
+// Функция GetString не захватывает критических секций: массив строк части при росте копируется в её арене, а новый
+// массив публикуется атомарно (старые копии остаются в арене до вызова Clear, что увеличивает расход памяти не
+// больше чем вдвое). Вью, возвращаемые функцией GetString, действительны до вызова функции Clear или до разрушения
+// таблицы. Если параметр threadSafe равен false, то таблица не захватывает критических секций и может использоваться
+// только одним потоком (shardCount в этом случае должен быть равен 1)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT, unsigned shardCount = 16, bool threadSafe = true>
+class BasicInternTable final
+{
+	AML_NONCOPYABLE(BasicInternTable)
+	static_assert(shardCount && shardCount <= 256 && !(shardCount & (shardCount - 1)),
+		"Shard count must be a power of 2 not greater than 256");
+	static_assert(threadSafe || shardCount == 1, "Single-threaded table must have one shard");
+
+public:
+	using view_type = std::basic_string_view<CharT>;
+
+	// Параметр blockSize задаёт размер блоков арен частей таблицы. Блоки выделяются
+	// через источник памяти resource (если он равен nullptr, то через источник по умолчанию)
+	explicit BasicInternTable(size_t blockSize = Arena::DEFAULT_BLOCK_SIZE,
+		std::pmr::memory_resource* resource = nullptr) noexcept
+	{
+		for (auto& shard : m_Shards)
+			new(shard.buffer) Shard(blockSize, resource);
+	}
+
+	~BasicInternTable()
+	{
+		for (auto& shard : m_Shards)
+			shard.Get().~Shard();
+	}
+
+	// Добавляет строку str в таблицу (если её там ещё нет) и возвращает её атом. Если в части
+	// таблицы слишком много строк (больше 2^32 / shardCount), генерирует исключение ERuntime
+	Atom Intern(view_type str)
+	{
+		if (str.empty())
+			return Atom();
+
+		const unsigned hashValue = Mix(hash::GetFastHash(str));
+		const unsigned shardIndex = hashValue & (shardCount - 1);
+		Shard& shard = m_Shards[shardIndex].Get();
+
+		thrd::Lock lock(GetLock(shard));
+		uint32_t index = FindIndex(shard, hashValue, str);
+		if (index == NOT_FOUND)
+			index = Add(shard, hashValue, str);
+
+		return Atom(((index << SHARD_BITS) | shardIndex) + 1);
+	}
+
+	// Возвращает атом строки str или пустой атом, если строки нет в таблице (строка не добавляется)
+	Atom Find(view_type str) const noexcept
+	{
+		if (str.empty())
+			return Atom();
+
+		const unsigned hashValue = Mix(hash::GetFastHash(str));
+		const unsigned shardIndex = hashValue & (shardCount - 1);
+		Shard& shard = m_Shards[shardIndex].Get();
+
+		thrd::Lock lock(GetLock(shard));
+		const uint32_t index = FindIndex(shard, hashValue, str);
+		return (index == NOT_FOUND) ? Atom() : Atom(((index << SHARD_BITS) | shardIndex) + 1);
+	}
+
+	// Возвращает строку, соответствующую атому atom (атом должен быть получен из этой таблицы)
+	view_type GetString(Atom atom) const noexcept
+	{
+		if (atom.IsEmpty())
+			return view_type();
+
+		const uint32_t value = atom.m_Id - 1;
+		const Shard& shard = m_Shards[value & (shardCount - 1)].Get();
+		return shard.strings.load(std::memory_order_acquire)[value >> SHARD_BITS];
+	}
+
+	// Возвращает количество строк в таблице
+	size_t GetCount() const noexcept
+	{
+		size_t count = 0;
+		for (auto& shard : m_Shards)
+			count += shard.Get().count.load(std::memory_order_relaxed);
+		return count;
+	}
+
+	// Удаляет все строки и освобождает память. Все ранее выданные атомы становятся недействительными.
+	// Функция не является потокобезопасной: другие потоки не должны обращаться к таблице во время её вызова
+	void Clear() noexcept
+	{
+		for (auto& item : m_Shards)
+		{
+			Shard& shard = item.Get();
+			shard.strings.store(nullptr, std::memory_order_relaxed);
+			shard.count.store(0, std::memory_order_relaxed);
+			shard.capacity = 0;
+			shard.arena.Release();
+			std::vector<uint32_t>().swap(shard.slots);
+			std::vector<uint32_t>().swap(shard.hashes);
+		}
+	}
+
+private:
+	// Количество бит номера части в идентификаторе (двоичный логарифм shardCount)
+	static constexpr unsigned SHARD_BITS = (shardCount > 1) + (shardCount > 2) + (shardCount > 4) + (shardCount > 8) +
+		(shardCount > 16) + (shardCount > 32) + (shardCount > 64) + (shardCount > 128);
+	// Максимальное количество строк в одной части таблицы (все идентификаторы умещаются в 32 бита)
+	static constexpr uint32_t MAX_COUNT = UINT32_MAX >> SHARD_BITS;
+	static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+	struct Shard {
+		Shard(size_t blockSize, std::pmr::memory_resource* resource) noexcept
+			: arena(blockSize, resource)
+		{
+		}
+
+		thrd::CriticalSection lock;
+		Arena arena;								// Копии строк и массивы strings
+		std::atomic<view_type*> strings = nullptr;	// Массив строк (индекс - номер строки в части)
+		std::atomic<uint32_t> count = 0;			// Количество строк в части
+		uint32_t capacity = 0;						// Размер массива strings
+		std::vector<uint32_t> slots;				// Хеш-таблица: номер строки плюс 1 (0 - свободная ячейка)
+		std::vector<uint32_t> hashes;				// Хеши строк (индекс - номер строки в части)
+	};
+
+	struct alignas(AML_CACHE_LINE_SIZE) ShardHolder {
+		alignas(Shard) uint8_t buffer[sizeof(Shard)];
+		Shard& Get() noexcept { return *reinterpret_cast<Shard*>(buffer); }
+	};
+
+	// Возвращает критическую секцию части shard (или nullptr, если таблица используется одним потоком)
+	static thrd::CriticalSection* GetLock(Shard& shard) noexcept
+	{
+		if constexpr (threadSafe)
+			return &shard.lock;
+		else
+			return nullptr;
+	}
+
+	// Младшие биты хеша FNV-1a для близких строк распределены хуже старших, поэтому "подмешаем"
+	// старшие биты к младшим (младшие биты выбирают часть таблицы, остальные - ячейку в ней)
+	static unsigned Mix(unsigned hashValue) noexcept { return hashValue ^ (hashValue >> 16); }
+
+	// Возвращает номер строки str в части shard или NOT_FOUND
+	static uint32_t FindIndex(const Shard& shard, unsigned hashValue, view_type str) noexcept
+	{
+		if (shard.slots.empty())
+			return NOT_FOUND;
+
+		const view_type* const strings = shard.strings.load(std::memory_order_relaxed);
+		const size_t mask = shard.slots.size() - 1;
+		for (size_t pos = (hashValue >> SHARD_BITS) & mask;; pos = (pos + 1) & mask)
+		{
+			const uint32_t slot = shard.slots[pos];
+			if (!slot)
+				return NOT_FOUND;
+			if (shard.hashes[slot - 1] == hashValue && strings[slot - 1] == str)
+				return slot - 1;
+		}
+	}
+
+	// Добавляет строку str, которой ещё нет в части shard, и возвращает её номер
+	static uint32_t Add(Shard& shard, unsigned hashValue, view_type str)
+	{
+		const uint32_t index = shard.count.load(std::memory_order_relaxed);
+		if (index >= MAX_COUNT)
+			throw ERuntime("BasicInternTable: too many strings");
+
+		// Хеш-таблица заполняется не больше чем наполовину
+		if ((index + 1) * size_t(2) > shard.slots.size())
+			Rehash(shard, shard.slots.empty() ? 16 : shard.slots.size() * 2);
+
+		if (index == shard.capacity)
+		{
+			const uint32_t capacity = index ? (index <= MAX_COUNT / 2 ? index * 2 : MAX_COUNT) : 16;
+			view_type* strings = shard.arena.template AllocateArray<view_type>(capacity);
+			if (index)
+				std::copy_n(shard.strings.load(std::memory_order_relaxed), index, strings);
+
+			shard.strings.store(strings, std::memory_order_release);
+			shard.capacity = capacity;
+		}
+
+		shard.strings.load(std::memory_order_relaxed)[index] = shard.arena.CopyString(str);
+		shard.hashes.push_back(hashValue);
+		InsertSlot(shard, hashValue, index);
+
+		shard.count.store(index + 1, std::memory_order_release);
+		return index;
+	}
+
+	static void InsertSlot(Shard& shard, unsigned hashValue, uint32_t index) noexcept
+	{
+		const size_t mask = shard.slots.size() - 1;
+		size_t pos = (hashValue >> SHARD_BITS) & mask;
+		while (shard.slots[pos])
+			pos = (pos + 1) & mask;
+
+		shard.slots[pos] = index + 1;
+	}
+
+	static void Rehash(Shard& shard, size_t size)
+	{
+		shard.slots.assign(size, 0);
+		const uint32_t count = shard.count.load(std::memory_order_relaxed);
+		for (uint32_t i = 0; i < count; ++i)
+			InsertSlot(shard, shard.hashes[i], i);
+	}
+
+private:
+	// Критические секции частей захватываются и в константных функциях
+	mutable ShardHolder m_Shards[shardCount];
+};
+
+using InternTable = BasicInternTable<char>;
+using WInternTable = BasicInternTable<wchar_t>;
+
+} // namespace util
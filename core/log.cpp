@@ -9,13 +9,18 @@
 #include "datetime.h"
 #include "debug.h"
 #include "filesystem.h"
+#include "memtrack.h"
+#include "pool.h"
+#include "thread.h"
+#include "utf.h"
 
-using namespace util;
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
 
-// TODO: сейчас вывод в консоль отладчика, запись в файл, а также преобразование Wide->UTF-8 происходят в одном
-// и том же потоке. Чтобы ускорить работу журнала, можно вынести часть этой работы во вспомогательный поток. Но
-// сделать это нужно так, чтобы при отладке перед тем, как отладчик приостановит работу всех потоков в макросах
-// Assert/Verify/Halt, сообщение уже вывелось в файл и консоль (для этого должно быть достаточно вызова Flush)
+using namespace util;
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
@@ -44,6 +49,56 @@ public:
 	using Log::OnRecordEnd;
 };
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Вспомогательные функции
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+static inline bool IsHighSurrogate(wchar_t c) noexcept
+{
+	return sizeof(wchar_t) == 2 && (c & 0xfc00) == 0xd800;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+static inline bool IsLowSurrogate(wchar_t c) noexcept
+{
+	return sizeof(wchar_t) == 2 && (c & 0xfc00) == 0xdc00;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class F>
+static void ConvertToUtf8(std::wstring_view str, F&& output)
+{
+	// Преобразует строку str в UTF-8 и передаёт результат функции output(const char*, size_t)
+	if (const size_t size = str.size())
+	{
+		const size_t LOCAL_SIZE = 3840;
+
+		// Каждый символ Wide может стать максимум MAX_UTF8_PER_WIDE байтами в UTF-8. Считать точную длину
+		// результата (это намного быстрее самой конвертации) нужно, только если локального буфера может не хватить
+		const size_t bufferSize = (size <= LOCAL_SIZE / MAX_UTF8_PER_WIDE) ? LOCAL_SIZE : Utf8LengthOf(str);
+
+		SmartArray<char, LOCAL_SIZE> buffer(bufferSize);
+		if (const size_t len = WideToUtf8(buffer, bufferSize, str.data(), size))
+			output(static_cast<const char*>(buffer), len);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+static std::pmr::memory_resource* GetRecordResource() noexcept
+{
+	// Буферы сообщений растут при выводе в них (вне метки "Log" функции Log::StartRecord), поэтому
+	// они выделяют память через источник, задающий эту метку. Источник не удаляется при завершении программы
+	#if AML_MEMTRACK
+		static TaggedResource* resource = new TaggedResource("Log", GetDefaultResource());
+		return resource;
+	#else
+		return nullptr;
+	#endif
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //   LogRecord
@@ -53,6 +108,7 @@ public:
 //--------------------------------------------------------------------------------------------------------------------------------
 LogRecord::LogRecord(Log& log)
 	: m_Log(log)
+	, m_Data(std::in_place_type<WideBuffer>, GetRecordResource())
 {
 }
 
@@ -60,7 +116,12 @@ LogRecord::LogRecord(Log& log)
 AML_NOINLINE void LogRecord::End()
 {
 	if (m_IsOutputEnabled)
-		m_Data.Append(L'\n');
+	{
+		if (m_IsUtf8)
+			GetUtf8Buffer().Append('\n');
+		else
+			GetWideBuffer().Append(L'\n');
+	}
 
 	auto& log = static_cast<LogAccessor&>(m_Log);
 	log.OnRecordEnd(this);
@@ -70,7 +131,7 @@ AML_NOINLINE void LogRecord::End()
 AML_NOINLINE LogRecord& LogRecord::operator <<(bool value)
 {
 	if (m_IsOutputEnabled)
-		m_Data << value;
+		Put(value);
 
 	return *this;
 }
@@ -79,7 +140,7 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(bool value)
 AML_NOINLINE LogRecord& LogRecord::operator <<(double value)
 {
 	if (m_IsOutputEnabled)
-		m_Data << value;
+		Put(value);
 
 	return *this;
 }
@@ -88,7 +149,7 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(double value)
 AML_NOINLINE LogRecord& LogRecord::operator <<(int32_t value)
 {
 	if (m_IsOutputEnabled)
-		m_Data << value;
+		Put(value);
 
 	return *this;
 }
@@ -97,7 +158,7 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(int32_t value)
 AML_NOINLINE LogRecord& LogRecord::operator <<(uint32_t value)
 {
 	if (m_IsOutputEnabled)
-		m_Data << value;
+		Put(value);
 
 	return *this;
 }
@@ -106,7 +167,7 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(uint32_t value)
 AML_NOINLINE LogRecord& LogRecord::operator <<(int64_t value)
 {
 	if (m_IsOutputEnabled)
-		m_Data << value;
+		Put(value);
 
 	return *this;
 }
@@ -115,7 +176,7 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(int64_t value)
 AML_NOINLINE LogRecord& LogRecord::operator <<(uint64_t value)
 {
 	if (m_IsOutputEnabled)
-		m_Data << value;
+		Put(value);
 
 	return *this;
 }
@@ -125,10 +186,14 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(char value)
 {
 	if (m_IsOutputEnabled)
 	{
-		if (value < 0x80)
+		if (m_IsUtf8)
+		{
+			GetUtf8Buffer().Append(value);
+		}
+		else if (value < 0x80)
 		{
 			wchar_t c = value;
-			m_Data.Append(c);
+			GetWideBuffer().Append(c);
 		} else
 		{
 			Append({ &value, 1 });
@@ -142,7 +207,21 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(char value)
 AML_NOINLINE LogRecord& LogRecord::operator <<(wchar_t value)
 {
 	if (m_IsOutputEnabled)
-		m_Data.Append(value);
+	{
+		if (!m_IsUtf8)
+			GetWideBuffer().Append(value);
+		else if (value < 0x80)
+			GetUtf8Buffer().Append(static_cast<char>(value));
+		else if (IsHighSurrogate(value))
+		{
+			// Старший суррогат запоминается до следующего символа, чтобы суррогатная пара, выводимая
+			// по одному символу, стала одним символом UTF-8, а не двумя символами U+FFFD
+			if (m_HighSurrogate)
+				FlushSurrogate();
+			m_HighSurrogate = value;
+		} else
+			AppendWide({ &value, 1 });
+	}
 
 	return *this;
 }
@@ -163,7 +242,12 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(const char* str)
 AML_NOINLINE LogRecord& LogRecord::operator <<(const wchar_t* str)
 {
 	if (m_IsOutputEnabled && str)
-		m_Data.Append(str);
+	{
+		if (m_IsUtf8)
+			AppendWide(str);
+		else
+			GetWideBuffer().Append(str);
+	}
 
 	return *this;
 }
@@ -181,7 +265,7 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(std::string_view str)
 AML_NOINLINE LogRecord& LogRecord::operator <<(std::wstring_view str)
 {
 	if (m_IsOutputEnabled)
-		m_Data.Append(str);
+		AppendWide(str);
 
 	return *this;
 }
@@ -192,12 +276,32 @@ AML_NOINLINE LogRecord& LogRecord::operator <<(const Logable& obj)
 	if (m_IsOutputEnabled)
 	{
 		auto&& text = obj.LogToString();
-		m_Data.Append(text);
+		AppendWide(text);
 	}
 
 	return *this;
 }
 
+//--------------------------------------------------------------------------------------------------------------------------------
+const StringWriter<wchar_t>& LogRecord::GetData() const noexcept
+{
+	if (const auto data = std::get_if<WideBuffer>(&m_Data))
+		return *data;
+
+	static const WideBuffer empty;
+	return empty;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+const StringWriter<char>& LogRecord::GetUtf8Data() const noexcept
+{
+	if (const auto data = std::get_if<Utf8Buffer>(&m_Data))
+		return *data;
+
+	static const Utf8Buffer empty;
+	return empty;
+}
+
 //--------------------------------------------------------------------------------------------------------------------------------
 int LogRecord::FormatHeader(wchar_t* buffer, size_t bufferSize, MsgType msgType, uint64_t time)
 {
@@ -237,20 +341,49 @@ std::wstring LogRecord::FormatHeader(MsgType msgType, uint64_t time)
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-void LogRecord::Start(MsgType msgType, uint64_t time)
+void LogRecord::Start(MsgType msgType, uint64_t time, bool utf8)
 {
-	m_Data.Clear();
+	// Буфер другой кодировки заменяется, только если кодировка журнала изменилась,
+	// иначе буфер (вместе с памятью, выделенной им в куче) используется повторно
+	if (utf8 != m_IsUtf8)
+	{
+		if (utf8)
+			m_Data.emplace<Utf8Buffer>(GetRecordResource());
+		else
+			m_Data.emplace<WideBuffer>(GetRecordResource());
+		m_IsUtf8 = utf8;
+	}
+
+	std::visit([](auto& data) { data.Clear(); }, m_Data);
+	m_HighSurrogate = 0;
+	m_MsgType = msgType;
+
 	if (m_IsOutputEnabled)
 	{
 		wchar_t buffer[32];
-		int len = FormatHeader(buffer, CountOf(buffer), msgType, time);
-		m_Data.Append(buffer, (len > 0) ? len : 0);
+		const int len = FormatHeader(buffer, CountOf(buffer), msgType, time);
+		if (!utf8)
+			GetWideBuffer().Append(buffer, (len > 0) ? len : 0);
+		else
+		{
+			// Заголовок состоит только из символов ASCII
+			auto& data = GetUtf8Buffer();
+			for (int i = 0; i < len; ++i)
+				data.Append(static_cast<char>(buffer[i]));
+		}
 	}
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 void LogRecord::Append(std::string_view str)
 {
+	if (m_IsUtf8)
+	{
+		GetUtf8Buffer().Append(str);
+		return;
+	}
+	auto& data = GetWideBuffer();
+
 	const size_t count = str.size();
 	wchar_t buffer[3840 / sizeof(wchar_t)];
 
@@ -263,7 +396,7 @@ void LogRecord::Append(std::string_view str)
 	{
 		if (int len = FromAnsi(buffer, CountOf(buffer), str); len >= 0)
 		{
-			m_Data.Append(buffer, len);
+			data.Append(buffer, len);
 			return;
 		}
 	}
@@ -277,8 +410,38 @@ void LogRecord::Append(std::string_view str)
 		bigBuffer.Grow(bufLen);
 
 		if (int len = FromAnsi(bigBuffer, bufLen, str); len > 0)
-			m_Data.Append(bigBuffer, len);
+			data.Append(bigBuffer, len);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void LogRecord::AppendWide(std::wstring_view str)
+{
+	if (!m_IsUtf8)
+	{
+		GetWideBuffer().Append(str);
+		return;
 	}
+
+	const auto append = [this](const char* text, size_t size) { GetUtf8Buffer().Append(text, size); };
+
+	// Если предыдущий символ был старшим суррогатом, то пара завершается первым символом строки
+	if (m_HighSurrogate && !str.empty() && IsLowSurrogate(str[0]))
+	{
+		const wchar_t pair[2] = { m_HighSurrogate, str[0] };
+		m_HighSurrogate = 0;
+		str.remove_prefix(1);
+		ConvertToUtf8({ pair, 2 }, append);
+	}
+
+	ConvertToUtf8(str, append);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void LogRecord::FlushSurrogate()
+{
+	m_HighSurrogate = 0;
+	std::get_if<Utf8Buffer>(&m_Data)->Append("\xef\xbf\xbd", 3);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -301,104 +464,247 @@ LogRecordHolder::LogRecordHolder(Log& log, LogRecord::MsgType msgType)
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-//   Log::LogRecordStack
+//   Log
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Log::Log()
+	: m_IsDebugMsgAllowed(!IsProductionBuild())
+{
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Log::~Log()
+{
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+LogRecord* Log::StartRecord(MsgType msgType)
+{
+	const bool utc = m_TimeFormat == TimeFormat::Utc;
+	const bool outputEnabled = m_IsOutputEnabled && (msgType != MsgType::Debug || m_IsDebugMsgAllowed);
+
+	LogRecord* record;
+	{
+		// Объекты LogRecord выделяются в пуле (у каждого потока свой кеш свободных блоков), поэтому потоки,
+		// одновременно выводящие сообщения, как правило, не ожидают друг друга и не обращаются к куче
+		MemTag tag("Log");
+		record = m_Records.New(*this);
+	}
+
+	record->SetOutputEnabled(outputEnabled);
+	record->Start(msgType, outputEnabled ? DateTime::Now(utc) : 0, m_RecordEncoding == RecordEncoding::Utf8);
+
+	return record;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Log::OnRecordEnd(LogRecord* record)
+{
+	m_Records.Delete(record);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   FileLog::AsyncWriter
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Класс AsyncWriter реализует очередь и поток записи асинхронного журнала. Очередь - это стек объектов LogRecord, связанных
+// через поле m_Next: потоки, выводящие сообщения, добавляют в него объекты операцией CAS, а поток записи забирает весь стек
+// целиком и разворачивает его, восстанавливая порядок сообщений. Счётчики m_PostedCount и m_WrittenCount позволяют функции
+// Wait дождаться записи сообщений, помещённых в очередь до её вызова, и ограничить размер очереди. Мьютекс и условные
+// переменные используются только для ожидания: поток записи будится, лишь если он уже уснул из-за пустой очереди
+
 //--------------------------------------------------------------------------------------------------------------------------------
-class Log::LogRecordStack final
+class FileLog::AsyncWriter final
 {
 public:
-	LogRecordStack(Log& log);
-	~LogRecordStack();
+	AsyncWriter(FileLog& log, size_t queueSize, OverflowPolicy policy);
+	~AsyncWriter();
+
+	// Помещает сообщение record в очередь (или освобождает его, если сообщение отброшено)
+	void Post(LogRecord* record);
+	// Ожидает записи всех сообщений, помещённых в очередь до вызова функции
+	void Wait();
+
+	uint64_t GetDroppedCount() const noexcept { return m_DroppedCount.load(std::memory_order_relaxed); }
 
-	LogRecord* Get();
-	void Release(LogRecord* record);
+private:
+	void Run() noexcept;
+	// Выводит сообщения списка records (в порядке их добавления в очередь) и освобождает их
+	void Write(LogRecord* records) noexcept;
+
+	// Возвращает количество сообщений в очереди
+	uint64_t GetQueuedCount() const noexcept;
 
 private:
-	Log& m_Log;
-	thrd::CriticalSection m_CS;
-	std::vector<LogRecord*> m_Records;
+	FileLog& m_Log;
+	const size_t m_QueueSize;
+	const OverflowPolicy m_Policy;
+
+	std::atomic<LogRecord*> m_Head = nullptr;		// Вершина стека сообщений
+	std::atomic<uint64_t> m_PostedCount = 0;		// Количество сообщений, помещённых в очередь
+	std::atomic<uint64_t> m_WrittenCount = 0;		// Количество записанных сообщений
+	std::atomic<uint64_t> m_DroppedCount = 0;		// Количество отброшенных сообщений
+	std::atomic<bool> m_IsSleeping = false;			// true, если поток записи ожидает сообщений
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WakeUp;				// Сигнал потоку записи о новых сообщениях или о завершении
+	std::condition_variable m_Progress;				// Сигнал ожидающим потокам о записи очередных сообщений
+	bool m_IsStopping = false;
+
+	std::thread m_Thread;
 };
 
 //--------------------------------------------------------------------------------------------------------------------------------
-Log::LogRecordStack::LogRecordStack(Log& log)
+FileLog::AsyncWriter::AsyncWriter(FileLog& log, size_t queueSize, OverflowPolicy policy)
 	: m_Log(log)
-	, m_CS(500)
+	, m_QueueSize(queueSize ? queueSize : 1)
+	, m_Policy(policy)
 {
+	// Поток создаётся последним, когда все остальные поля уже инициализированы
+	m_Thread = std::thread(&AsyncWriter::Run, this);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-Log::LogRecordStack::~LogRecordStack()
+FileLog::AsyncWriter::~AsyncWriter()
 {
-	for (auto record : m_Records)
-		AML_SAFE_DELETE(record);
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_IsStopping = true;
+	}
+
+	m_WakeUp.notify_one();
+	m_Thread.join();
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-LogRecord* Log::LogRecordStack::Get()
+uint64_t FileLog::AsyncWriter::GetQueuedCount() const noexcept
 {
-	thrd::Lock lock(m_CS);
-
-	if (!m_Records.empty())
-	{
-		auto p = m_Records.back();
-		m_Records.pop_back();
-		return p;
-	}
-
-	lock.Leave();
-	return new LogRecord(m_Log);
+	// Счётчик записанных сообщений читается первым, поэтому он не может оказаться больше счётчика добавленных
+	const uint64_t written = m_WrittenCount.load(std::memory_order_acquire);
+	return m_PostedCount.load(std::memory_order_acquire) - written;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-void Log::LogRecordStack::Release(LogRecord* record)
+void FileLog::AsyncWriter::Post(LogRecord* record)
 {
-	if (record)
+	// Размер очереди проверяется без резервирования места, поэтому при одновременном выводе
+	// сообщений многими потоками он может быть превышен на количество этих потоков
+	if (GetQueuedCount() >= m_QueueSize)
 	{
-		record->Clear();
+		if (m_Policy == OverflowPolicy::DropNewest ||
+			(m_Policy == OverflowPolicy::DropDebug && record->GetMsgType() == MsgType::Debug))
+		{
+			m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+			m_Log.Log::OnRecordEnd(record);
+			return;
+		}
 
-		thrd::Lock lock(m_CS);
-		m_Records.push_back(record);
+		// Поток записи не может ожидать сам себя (например, если сообщение выводится из Assert
+		// внутри WriteRecord), поэтому его сообщение помещается в очередь сверх её размера
+		if (std::this_thread::get_id() != m_Thread.get_id())
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Progress.wait(lock, [this] { return GetQueuedCount() < m_QueueSize; });
+		}
 	}
-}
 
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//
-//   Log
-//
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Счётчик увеличивается до добавления сообщения в стек, поэтому функция Wait
+	// не может закончить ожидание раньше, чем будет записано это сообщение
+	m_PostedCount.fetch_add(1, std::memory_order_relaxed);
 
-//--------------------------------------------------------------------------------------------------------------------------------
-Log::Log()
-	: m_IsDebugMsgAllowed(!IsProductionBuild())
-{
-	m_Records = new LogRecordStack(*this);
+	LogRecord* head = m_Head.load(std::memory_order_relaxed);
+	do {
+		record->m_Next = head;
+	} while (!m_Head.compare_exchange_weak(head, record, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+	// Поток записи устанавливает флаг и затем проверяет стек, а мы добавили сообщение и затем проверяем флаг
+	// (все операции seq_cst), поэтому либо поток записи увидит сообщение, либо мы увидим, что он уснул
+	if (m_IsSleeping.load(std::memory_order_seq_cst))
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_WakeUp.notify_one();
+	}
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-Log::~Log()
+void FileLog::AsyncWriter::Wait()
 {
-	AML_SAFE_DELETE(m_Records);
+	// Если функция вызвана из самого потока записи (например, из Assert при выводе сообщения),
+	// то ожидать нечего: все сообщения, помещённые в очередь до этого, уже выведены
+	if (std::this_thread::get_id() == m_Thread.get_id())
+		return;
+
+	const uint64_t target = m_PostedCount.load(std::memory_order_acquire);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Progress.wait(lock, [&] { return m_WrittenCount.load(std::memory_order_acquire) >= target; });
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-LogRecord* Log::StartRecord(MsgType msgType)
+void FileLog::AsyncWriter::Run() noexcept
 {
-	const bool utc = m_TimeFormat == TimeFormat::Utc;
-	const bool outputEnabled = m_IsOutputEnabled && (msgType != MsgType::Debug || m_IsDebugMsgAllowed);
+	for (;;)
+	{
+		if (LogRecord* records = m_Head.exchange(nullptr, std::memory_order_acquire))
+		{
+			Write(records);
+			continue;
+		}
 
-	auto record = m_Records->Get();
-	record->SetOutputEnabled(outputEnabled);
-	record->Start(msgType, outputEnabled ? DateTime::Now(utc) : 0);
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_IsSleeping.store(true, std::memory_order_seq_cst);
+		while (!m_IsStopping && !m_Head.load(std::memory_order_seq_cst))
+			m_WakeUp.wait(lock);
+		m_IsSleeping.store(false, std::memory_order_relaxed);
 
-	return record;
+		// Завершаем работу, только когда в очереди не осталось сообщений
+		if (m_IsStopping && !m_Head.load(std::memory_order_acquire))
+			break;
+	}
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-void Log::OnRecordEnd(LogRecord* record)
+void FileLog::AsyncWriter::Write(LogRecord* records) noexcept
 {
-	m_Records->Release(record);
+	// Первым в стеке лежит последнее добавленное сообщение, поэтому разворачиваем список
+	LogRecord* list = nullptr;
+	uint64_t count = 0;
+	while (records)
+	{
+		LogRecord* next = records->m_Next;
+		records->m_Next = list;
+		list = records;
+		records = next;
+		++count;
+	}
+
+	while (list)
+	{
+		LogRecord* next = list->m_Next;
+		list->m_Next = nullptr;
+
+		// Ошибка вывода одного сообщения (например, нехватка памяти) не должна завершать поток записи
+		try {
+			m_Log.WriteRecord(list);
+		}
+		catch (...)
+		{
+		}
+
+		m_Log.Log::OnRecordEnd(list);
+		list = next;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_WrittenCount.fetch_add(count, std::memory_order_release);
+	}
+
+	m_Progress.notify_all();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -410,6 +716,7 @@ void Log::OnRecordEnd(LogRecord* record)
 //--------------------------------------------------------------------------------------------------------------------------------
 FileLog::~FileLog()
 {
+	StopAsync();
 	Close();
 }
 
@@ -458,45 +765,102 @@ bool FileLog::Open(WZStringView filePath, bool append)
 void FileLog::Close()
 {
 	m_IsOutputEnabled = false;
+	// Сообщения, уже помещённые в очередь, должны попасть в файл до его закрытия
+	if (m_Writer)
+		m_Writer->Wait();
+
+	thrd::Lock lock(m_CS);
 	if (m_File.IsOpened())
 		m_File.Close();
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-void FileLog::OnRecordEnd(LogRecord* record)
+bool FileLog::StartAsync(size_t queueSize, OverflowPolicy policy)
 {
-	if (record && record->IsOutputEnabled() && IsOpened())
-		WriteToFile(record->GetData());
+	StopAsync();
 
-	Log::OnRecordEnd(record);
+	try {
+		MemTag tag("Log");
+		m_Writer = new AsyncWriter(*this, queueSize, policy);
+	}
+	catch (const std::system_error&)
+	{
+		// Поток записи создать не удалось, журнал остаётся синхронным
+		return false;
+	}
+
+	return true;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-void FileLog::WriteToFile(std::wstring_view text)
+void FileLog::StopAsync()
+{
+	// Деструктор дожидается записи всех сообщений очереди и завершения потока записи
+	AML_SAFE_DELETE(m_Writer);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+uint64_t FileLog::GetDroppedCount() const
 {
-	if (const size_t size = text.size())
+	return m_Writer ? m_Writer->GetDroppedCount() : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void FileLog::Flush()
+{
+	if (m_Writer)
+		m_Writer->Wait();
+
+	thrd::Lock lock(m_CS);
+	m_File.Flush();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void FileLog::OnRecordEnd(LogRecord* record)
+{
+	if (record && record->IsOutputEnabled())
 	{
-		const size_t LOCAL_SIZE = 3840;
-		int bufferSize = LOCAL_SIZE;
-
-		// Каждый символ UCS-2 (эта кодировка использовалась до Windows 2000) может стать максимум 3 байтами в UTF-8.
-		// Это же справедливо и для UTF-16, но её суррогатные пары (2 16-битных слова) будут закодированы 4 байтами.
-		// В других операционных системах (например, Unix) используется 32-битный wchar_t, поэтому каждый Wide символ
-		// может быть закодирован последовательностью до 4 байт в UTF-8. Нам стоит искать требуемый размер буфера,
-		// только если он может быть больше размера локального
-		if (size > LOCAL_SIZE / 4)
+		// В асинхронном режиме объект record освободит поток записи
+		if (m_Writer)
 		{
-			bufferSize = ToUtf8(nullptr, 0, text);
-			if (bufferSize <= 0)
-				return;
+			m_Writer->Post(record);
+			return;
 		}
 
-		SmartArray<char, LOCAL_SIZE> buffer(bufferSize);
-		if (int len = ToUtf8(buffer, bufferSize, text); len > 0)
-		{
-			thrd::Lock lock(m_CS);
-			m_File.Write(buffer, len);
-		}
+		WriteRecord(record);
+	}
+
+	Log::OnRecordEnd(record);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void FileLog::WriteRecord(LogRecord* record)
+{
+	if (IsOpened())
+	{
+		if (record->IsUtf8())
+			WriteToFile(record->GetUtf8Data());
+		else
+			WriteToFile(record->GetData());
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void FileLog::WriteToFile(std::wstring_view text)
+{
+	ConvertToUtf8(text, [this](const char* data, size_t size) {
+		thrd::Lock lock(m_CS);
+		m_File.Write(data, size);
+	});
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void FileLog::WriteToFile(std::string_view text)
+{
+	if (!text.empty())
+	{
+		thrd::Lock lock(m_CS);
+		m_File.Write(text.data(), text.size());
 	}
 }
 
@@ -526,10 +890,22 @@ LogRecord* SystemLog::StartRecord(MsgType msgType)
 //--------------------------------------------------------------------------------------------------------------------------------
 void SystemLog::OnRecordEnd(LogRecord* record)
 {
+	// Сообщение выводится в консоль отладчика в потоке, который его сформировал, даже в асинхронном режиме. Функция
+	// DebugOutput захватывает критическую секцию DebugHelper, которую DebugHelper::Abort удерживает во время вызова
+	// Flush, поэтому поток записи, выводящий сообщения в консоль, не смог бы закончить запись, и Flush не вернул бы
+	// управление. Кроме того, сообщение об ошибке появится в консоли до того, как отладчик остановит программу
 	if (record && record->IsOutputEnabled())
 	{
-		auto&& s = record->GetData();
-		DebugHelper::DebugOutput(s);
+		if (!record->IsUtf8())
+		{
+			auto&& s = record->GetData();
+			DebugHelper::DebugOutput(s);
+		}
+		else if (DebugHelper::Instance().IsDebugOutputEnabled())
+		{
+			// Консоль отладчика принимает строки Ansi, поэтому сообщение UTF-8 перекодируется в Wide
+			DebugHelper::DebugOutput(FromUtf8(record->GetUtf8Data()));
+		}
 	}
 
 	FileLog::OnRecordEnd(record);
@@ -6,6 +6,7 @@
 
 #include "file.h"
 #include "platform.h"
+#include "pool.h"
 #include "singleton.h"
 #include "strcommon.h"
 #include "strformat.h"
@@ -16,6 +17,7 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <variant>
 
 namespace util {
 
@@ -46,10 +48,18 @@ protected:
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Объект LogRecord накапливает сообщение в одной из двух кодировок, которую задаёт журнал (см. Log::SetRecordEncoding).
+// В режиме Wide строки char считаются строками Ansi и преобразуются в Wide, а в режиме UTF-8 строки char считаются строками
+// UTF-8 и копируются без преобразования, строки Wide перекодируются в UTF-8 один раз при добавлении к сообщению. Режим UTF-8
+// позволяет файловому журналу записывать сообщения в файл без перекодирования и вдвое-вчетверо уменьшает размер сообщений.
+// Объект хранит буфер только для текущей кодировки, поэтому размер объекта в обоих режимах одинаков
+
 //--------------------------------------------------------------------------------------------------------------------------------
 class LogRecord final
 {
+	friend class FileLog;
 	friend class Log;
+	friend class ObjectPool<LogRecord>;
 	AML_NONCOPYABLE(LogRecord)
 
 public:
@@ -68,8 +78,17 @@ public:
 	// не имеет смысла, так как сессия журнала не открыта. В таких случаях нет смысла форматировать и сохранять вывод
 	void SetOutputEnabled(bool enabled) noexcept { m_IsOutputEnabled = enabled; }
 
-	// Возвращает ссылку на string-view-ish объект StringWriter с накопленным сообщением
-	const StringWriter<wchar_t>& GetData() const noexcept { return m_Data; }
+	// Возвращает тип сообщения
+	MsgType GetMsgType() const noexcept { return m_MsgType; }
+	// Возвращает true, если сообщение накапливается в кодировке UTF-8
+	bool IsUtf8() const noexcept { return m_IsUtf8; }
+
+	// Возвращает ссылку на string-view-ish объект StringWriter с накопленным сообщением (в режиме Wide). В режиме
+	// UTF-8 функция возвращает пустой объект
+	const StringWriter<wchar_t>& GetData() const noexcept;
+	// Возвращает ссылку на string-view-ish объект StringWriter с накопленным сообщением (в режиме UTF-8). В режиме
+	// Wide функция возвращает пустой объект
+	const StringWriter<char>& GetUtf8Data() const noexcept;
 
 	// Информирует класс журнала о завершении формирования сообщения. После вызова этой
 	// функции использование объекта (т.е. вызовы операторов << и т.п.) недопустимы
@@ -117,20 +136,50 @@ public:
 	static std::wstring FormatHeader(MsgType msgType, uint64_t time);
 
 private:
+	using WideBuffer = Formatter<wchar_t>;
+	using Utf8Buffer = Formatter<char>;
+
 	explicit LogRecord(Log& log);
 	~LogRecord() = default;
 
-	void Clear() { m_Data.Clear(); }
-
-	// Начинает новое сообщение с даты, времени и маркера типа
-	void Start(MsgType msgType, uint64_t time);
-	// Добавляет строку str к сообщению
+	// Начинает новое сообщение с даты, времени и маркера типа. Параметр
+	// utf8 задаёт кодировку сообщения (true - UTF-8, false - Wide)
+	void Start(MsgType msgType, uint64_t time, bool utf8);
+	// Добавляет строку str (Ansi или UTF-8, в зависимости от режима) к сообщению
 	void Append(std::string_view str);
+	// Добавляет строку Wide str к сообщению
+	void AppendWide(std::wstring_view str);
+
+	// Возвращают буфер сообщения в режиме Wide и в режиме UTF-8. Перед возвратом буфера
+	// UTF-8 в него выводится незавершённая суррогатная пара (см. m_HighSurrogate)
+	WideBuffer& GetWideBuffer() noexcept { return *std::get_if<WideBuffer>(&m_Data); }
+	Utf8Buffer& GetUtf8Buffer()
+	{
+		if (m_HighSurrogate)
+			FlushSurrogate();
+		return *std::get_if<Utf8Buffer>(&m_Data);
+	}
+
+	// Выводит в буфер UTF-8 символ U+FFFD вместо старшего суррогата, для которого не нашлось младшего
+	void FlushSurrogate();
+
+	// Выводит значение value в сообщение в текущей кодировке
+	template<class T> void Put(T value)
+	{
+		if (m_IsUtf8)
+			GetUtf8Buffer() << value;
+		else
+			GetWideBuffer() << value;
+	}
 
 private:
 	Log& m_Log;
-	Formatter<wchar_t> m_Data;
+	std::variant<WideBuffer, Utf8Buffer> m_Data;	// Сообщение в текущей кодировке
+	LogRecord* m_Next = nullptr;	// Следующее сообщение в очереди асинхронного журнала
+	wchar_t m_HighSurrogate = 0;	// Старший суррогат, ожидающий младшего (в режиме UTF-8)
+	MsgType m_MsgType = MsgType::Info;
 	bool m_IsOutputEnabled = true;
+	bool m_IsUtf8 = false;
 };
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -170,6 +219,12 @@ public:
 		Local	// Использовать для штампа даты/времени локальное время
 	};
 
+	// Кодировка, в которой объекты LogRecord накапливают сообщения (см. комментарий к классу LogRecord)
+	enum class RecordEncoding {
+		Wide,	// Строки Wide (строки char преобразуются из Ansi)
+		Utf8	// Строки UTF-8 (строки char копируются без преобразования)
+	};
+
 	Log();
 	virtual ~Log();
 
@@ -178,6 +233,10 @@ public:
 	// либо UTC время). По умолчанию используется локальное время
 	void SetTimeFormat(TimeFormat format) { m_TimeFormat = format; }
 
+	RecordEncoding GetRecordEncoding() const { return m_RecordEncoding; }
+	// Устанавливает кодировку сообщений. По умолчанию используется кодировка Wide
+	void SetRecordEncoding(RecordEncoding encoding) { m_RecordEncoding = encoding; }
+
 	// Разрешает или запрещает вывод в журнал сообщений типа MsgType::Debug (по
 	// умолчанию вывод сообщений этого типа запрещён только в production сборках)
 	void SetDebugMsgAllowed(bool allowed) { m_IsDebugMsgAllowed = allowed; }
@@ -194,18 +253,18 @@ protected:
 
 	// Эта функция должна вызываться из функции LogRecord::End, чтобы инициировать копирование
 	// готового сообщения из объекта record во внутренний буфер (файл) журнала, после которого
-	// объект record будет освобождён и помещён в стек (для повторного использования)
+	// объект record будет удалён (его память вернётся в пул объектов журнала)
 	virtual void OnRecordEnd(LogRecord* record);
 
 protected:
 	TimeFormat m_TimeFormat = TimeFormat::Local;
+	RecordEncoding m_RecordEncoding = RecordEncoding::Wide;
 
 	bool m_IsOutputEnabled = false;
 	bool m_IsDebugMsgAllowed = false;
 
 private:
-	class LogRecordStack;
-	LogRecordStack* m_Records = nullptr;
+	ObjectPool<LogRecord> m_Records;	// Пул объектов LogRecord (см. StartRecord и OnRecordEnd)
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -214,10 +273,26 @@ private:
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// В асинхронном режиме (см. функцию StartAsync) потоки, выводящие сообщения, только помещают готовые объекты LogRecord в
+// очередь без блокировок, а преобразование сообщений и запись в файл выполняет отдельный поток записи. Функция Flush
+// дожидается записи всех сообщений, помещённых в очередь до её вызова, поэтому при вызове Flush в макросах Assert/Verify/
+// Halt сообщение об ошибке окажется в файле до остановки программы. Поток записи не захватывает никаких блокировок, кроме
+// критической секции журнала, поэтому Flush можно вызывать, удерживая другие блокировки (например, в DebugHelper::Abort)
+
 //--------------------------------------------------------------------------------------------------------------------------------
 class FileLog : public Log
 {
 public:
+	// Размер очереди асинхронного журнала по умолчанию (в сообщениях)
+	static constexpr size_t DEFAULT_QUEUE_SIZE = 4096;
+
+	// Поведение асинхронного журнала при переполнении очереди
+	enum class OverflowPolicy {
+		Block,		// Поток, выводящий сообщение, ожидает, пока в очереди не освободится место
+		DropNewest,	// Новое сообщение отбрасывается
+		DropDebug	// Отбрасываются сообщения типа Debug, а для остальных - как Block
+	};
+
 	virtual ~FileLog() override;
 
 	// Возвращает true, если сессия журнала активна
@@ -234,15 +309,36 @@ public:
 	// будет игнорироваться до тех пор, пока не будет открыта новая сессия вызовом функции Open
 	void Close();
 
-	virtual void Flush() override { m_File.Flush(); }
+	// Включает асинхронный режим: создаёт поток записи и очередь на queueSize сообщений (при переполнении очереди журнал
+	// действует согласно policy). Если поток создать не удалось, функция вернёт false. Функции StartAsync и StopAsync не
+	// являются потокобезопасными: в момент их вызова другие потоки не должны выводить сообщения в журнал
+	bool StartAsync(size_t queueSize = DEFAULT_QUEUE_SIZE, OverflowPolicy policy = OverflowPolicy::Block);
+	// Записывает все сообщения из очереди, завершает поток записи и возвращает журнал в синхронный режим
+	void StopAsync();
+
+	// Возвращает true, если журнал работает в асинхронном режиме
+	bool IsAsync() const { return m_Writer != nullptr; }
+	// Возвращает количество сообщений, отброшенных из-за переполнения очереди с момента включения асинхронного режима
+	uint64_t GetDroppedCount() const;
+
+	virtual void Flush() override;
 
 protected:
 	virtual void OnRecordEnd(LogRecord* record) override;
+	// Выводит сообщение record (вывод которого разрешён) в файл. В асинхронном режиме функция вызывается
+	// в потоке записи. Наследник, переопределивший её, должен вызвать StopAsync в своём деструкторе
+	virtual void WriteRecord(LogRecord* record);
+
 	void WriteToFile(std::wstring_view text);
+	void WriteToFile(std::string_view text);
 
 protected:
 	thrd::CriticalSection m_CS;
 	BinaryFile m_File;
+
+private:
+	class AsyncWriter;
+	AsyncWriter* m_Writer = nullptr;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
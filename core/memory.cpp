@@ -0,0 +1,168 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "memory.h"
+
+#include "memtrack.h"
+#include "winapi.h"
+
+#include <cstddef>
+#include <new>
+
+namespace {
+
+// Источник памяти по умолчанию (nullptr - куча)
+std::atomic<std::pmr::memory_resource*> s_DefaultResource = nullptr;
+
+// Заголовок блока, выделенного функцией AllocBlock
+struct alignas(std::max_align_t) BlockHeader {
+	std::pmr::memory_resource* resource;	// Источник памяти блока
+	size_t size;							// Полный размер блока (вместе с заголовком)
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t InitLargePages() noexcept
+{
+	#if AML_OS_WINDOWS
+		using util::WinAPI;
+		if (!WinAPI::CanGetLargePageMinimum())
+			return 0;
+
+		const size_t pageSize = WinAPI::GetLargePageMinimum();
+		if (!pageSize)
+			return 0;
+
+		// Выделение больших страниц требует привилегии SeLockMemoryPrivilege. Она должна быть выдана пользователю
+		// в локальной политике безопасности, но даже в этом случае её нужно явно включить в маркере доступа
+		HANDLE token;
+		if (!::OpenProcessToken(::GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+			return 0;
+
+		TOKEN_PRIVILEGES privileges = {};
+		privileges.PrivilegeCount = 1;
+		privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+		// Функция AdjustTokenPrivileges возвращает TRUE и в том случае, когда привилегия не
+		// была включена. Поэтому результат нужно дополнительно проверить через GetLastError
+		bool isEnabled = ::LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+			::AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) && ::GetLastError() == ERROR_SUCCESS;
+
+		::CloseHandle(token);
+		return isEnabled ? pageSize : 0;
+	#else
+		#error Not implemented
+	#endif
+}
+
+} // namespace
+
+namespace util {
+
+//--------------------------------------------------------------------------------------------------------------------------------
+std::pmr::memory_resource* GetHeapResource() noexcept
+{
+	#if AML_MEMTRACK
+		return MemTracker::GetResource();
+	#else
+		return std::pmr::new_delete_resource();
+	#endif
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+std::pmr::memory_resource* GetDefaultResource() noexcept
+{
+	auto resource = s_DefaultResource.load(std::memory_order_acquire);
+	return resource ? resource : GetHeapResource();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+std::pmr::memory_resource* SetDefaultResource(std::pmr::memory_resource* resource) noexcept
+{
+	auto old = s_DefaultResource.exchange(resource, std::memory_order_acq_rel);
+	return old ? old : GetHeapResource();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void* AllocBlock(size_t size)
+{
+	if (size > size_t(-1) - sizeof(BlockHeader))
+		throw std::bad_alloc();
+
+	auto resource = GetDefaultResource();
+	const size_t blockSize = sizeof(BlockHeader) + size;
+	auto header = static_cast<BlockHeader*>(resource->allocate(blockSize, alignof(BlockHeader)));
+	header->resource = resource;
+	header->size = blockSize;
+
+	return header + 1;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void FreeBlock(void* ptr) noexcept
+{
+	if (ptr)
+	{
+		auto header = static_cast<BlockHeader*>(ptr) - 1;
+		header->resource->deallocate(header, header->size, alignof(BlockHeader));
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t GetLargePageSize() noexcept
+{
+	static const size_t largePageSize = InitLargePages();
+	return largePageSize;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void* AllocPages(size_t size, bool useLargePages, bool* isLargePages)
+{
+	if (isLargePages)
+		*isLargePages = false;
+
+	if (!size)
+		return nullptr;
+
+	#if AML_OS_WINDOWS
+		if (useLargePages)
+		{
+			// Размер памяти, выделяемой большими страницами, должен быть кратен размеру большой страницы
+			const size_t pageSize = GetLargePageSize();
+			if (pageSize && size >= pageSize && size <= size_t(-1) - pageSize)
+			{
+				const size_t largeSize = (size + pageSize - 1) & ~(pageSize - 1);
+				if (void* p = ::VirtualAlloc(nullptr, largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE))
+				{
+					if (isLargePages)
+						*isLargePages = true;
+					return p;
+				}
+			}
+		}
+
+		void* p = ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		if (!p)
+			throw std::bad_alloc();
+
+		return p;
+	#else
+		#error Not implemented
+	#endif
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void FreePages(void* ptr) noexcept
+{
+	if (ptr)
+	{
+		#if AML_OS_WINDOWS
+			::VirtualFree(ptr, 0, MEM_RELEASE);
+		#else
+			#error Not implemented
+		#endif
+	}
+}
+
+} // namespace util
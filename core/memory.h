@@ -0,0 +1,109 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "platform.h"
+
+#include <memory_resource>
+#include <new>
+#include <stddef.h>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Источник памяти по умолчанию
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Контейнеры и буферы AML (массивы, арены, файлы в памяти, строковые буферы) выделяют память не напрямую в куче, а через
+// источник памяти (std::pmr::memory_resource). Источник можно передать в конструктор объекта, а если он не задан, то
+// используется источник по умолчанию, действующий на момент создания объекта (или первого выделения памяти). Объект
+// запоминает источник и возвращает ему память, поэтому смена источника по умолчанию не влияет на существующие объекты.
+// Так можно направить всю память AML в арену, большие страницы или учитывающий распределитель, не меняя библиотеку.
+// Источник по умолчанию AML не зависит от std::pmr::get_default_resource и изначально равен GetHeapResource
+
+// Возвращает источник памяти "куча". Обычно это std::pmr::new_delete_resource, но если включён
+// учёт памяти (макрос AML_MEMTRACK), то это учитывающий источник (см. MemTracker::GetResource)
+std::pmr::memory_resource* GetHeapResource() noexcept;
+
+// Возвращает текущий источник памяти по умолчанию
+std::pmr::memory_resource* GetDefaultResource() noexcept;
+
+// Задаёт новый источник памяти по умолчанию (если resource равен nullptr, то память снова будет выделяться в куче).
+// Функция возвращает предыдущий источник. Источник должен существовать, пока существуют объекты, которые его используют
+std::pmr::memory_resource* SetDefaultResource(std::pmr::memory_resource* resource) noexcept;
+
+// Возвращает resource, если он не равен nullptr, иначе - источник памяти по умолчанию
+inline std::pmr::memory_resource* GetResource(std::pmr::memory_resource* resource) noexcept
+{
+	return resource ? resource : GetDefaultResource();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Выделение выровненной памяти
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Выделяет память под массив из count элементов типа T, выровненный по границе alignment (элементы не инициализируются).
+// Если память выделить невозможно, выбрасывает std::bad_alloc. Память должна быть освобождена функцией FreeArray с тем же
+// значением alignment, тем же количеством элементов и тем же источником памяти. По умолчанию массив выравнивается по
+// границе строки кеша CPU
+template<class T, size_t alignment = AML_CACHE_LINE_SIZE>
+T* AllocArray(size_t count, std::pmr::memory_resource* resource)
+{
+	static_assert(alignment >= alignof(T) && !(alignment & (alignment - 1)), "Invalid alignment");
+
+	if (count > size_t(-1) / sizeof(T))
+		throw std::bad_alloc();
+	return static_cast<T*>(resource->allocate(count * sizeof(T), alignment));
+}
+
+// Освобождает память, выделенную функцией AllocArray (если items равен nullptr, ничего не делает)
+template<class T, size_t alignment = AML_CACHE_LINE_SIZE>
+void FreeArray(T* items, size_t count, std::pmr::memory_resource* resource) noexcept
+{
+	if (items)
+		resource->deallocate(items, count * sizeof(T), alignment);
+}
+
+// Выделяет size байт из источника памяти по умолчанию (память выровнена по границе alignof(std::max_align_t)). Источник
+// и размер запоминаются в заголовке блока, поэтому объекту, владеющему блоком, не нужно их хранить. Это удобно для
+// объектов, размер которых важен (например, строковых вью). Если память выделить невозможно, выбрасывает std::bad_alloc
+void* AllocBlock(size_t size);
+
+// Освобождает блок, выделенный функцией AllocBlock (если ptr равен nullptr, ничего не делает)
+void FreeBlock(void* ptr) noexcept;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Выделение памяти страницами
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Способ выделения памяти для больших массивов
+enum class AllocPolicy
+{
+	Heap,		// Память выделяется через источник памяти (по умолчанию - см. GetDefaultResource)
+	Pages,		// Память выделяется страницами непосредственно у ОС
+	LargePages	// Память выделяется большими страницами (если это возможно), иначе обычными страницами
+};
+
+// Возвращает размер большой страницы памяти (обычно 2 МБ). Большие страницы уменьшают количество промахов TLB при работе
+// с большими массивами. Если ОС не поддерживает большие страницы или у процесса нет привилегии SeLockMemoryPrivilege, то
+// функция вернёт 0. При первом вызове функция пытается включить эту привилегию в маркере доступа процесса
+size_t GetLargePageSize() noexcept;
+
+// Выделяет size байт памяти страницами у ОС. Выделенная память заполнена нулями и выровнена как минимум по границе
+// страницы. Если параметр useLargePages равен true, а size не меньше размера большой страницы, функция попытается
+// выделить память большими страницами. Удалось ли это сделать, функция запишет в isLargePages (если он не nullptr).
+// Если память выделить невозможно, выбрасывает std::bad_alloc. Если size равен 0, функция вернёт nullptr
+void* AllocPages(size_t size, bool useLargePages = false, bool* isLargePages = nullptr);
+
+// Освобождает память, выделенную функцией AllocPages (если ptr равен nullptr, ничего не делает)
+void FreePages(void* ptr) noexcept;
+
+} // namespace util
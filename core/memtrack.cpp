@@ -0,0 +1,241 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "memtrack.h"
+
+#if AML_MEMTRACK
+
+#include "log.h"
+#include "threadsync.h"
+
+#include <cstddef>
+
+using namespace util;
+
+namespace {
+
+// Счётчики метки
+struct TagCounters {
+	std::atomic<const char*> name = nullptr;
+	std::atomic<size_t> bytes = 0;
+	std::atomic<size_t> blocks = 0;
+	std::atomic<size_t> peakBytes = 0;
+	std::atomic<size_t> allocations = 0;
+};
+
+// Счётчики меток (метка с индексом 0 - "Other") и общие счётчики
+TagCounters s_Tags[MemTracker::MAX_TAGS];
+TagCounters s_Total;
+std::atomic<unsigned> s_TagCount = 1;
+
+// Индекс метки, действующей в текущем потоке
+thread_local unsigned s_CurrentTag = 0;
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void UpdatePeak(std::atomic<size_t>& peak, size_t value) noexcept
+{
+	size_t old = peak.load(std::memory_order_relaxed);
+	while (value > old && !peak.compare_exchange_weak(old, value, std::memory_order_relaxed));
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void AddBlock(TagCounters& counters, size_t size) noexcept
+{
+	const size_t bytes = counters.bytes.fetch_add(size, std::memory_order_relaxed) + size;
+	counters.blocks.fetch_add(1, std::memory_order_relaxed);
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	UpdatePeak(counters.peakBytes, bytes);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void RemoveBlock(TagCounters& counters, size_t size) noexcept
+{
+	counters.bytes.fetch_sub(size, std::memory_order_relaxed);
+	counters.blocks.fetch_sub(1, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+MemTracker::TagStats GetTagStats(const TagCounters& counters, const char* name) noexcept
+{
+	return { name, counters.bytes.load(std::memory_order_relaxed), counters.blocks.load(std::memory_order_relaxed),
+		counters.peakBytes.load(std::memory_order_relaxed), counters.allocations.load(std::memory_order_relaxed) };
+}
+
+// Учитывающий источник памяти. Перед каждым блоком хранится индекс метки, за которой он учтён
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class TrackingResource final : public std::pmr::memory_resource
+{
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		const size_t headerSize = GetHeaderSize(alignment);
+		if (bytes > size_t(-1) - headerSize)
+			throw std::bad_alloc();
+
+		auto p = static_cast<uint8_t*>(std::pmr::new_delete_resource()->allocate(bytes + headerSize, headerSize)) + headerSize;
+		const unsigned tag = s_CurrentTag;
+		reinterpret_cast<unsigned*>(p)[-1] = tag;
+
+		AddBlock(s_Tags[tag], bytes);
+		AddBlock(s_Total, bytes);
+		return p;
+	}
+
+	void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+	{
+		auto p = static_cast<uint8_t*>(ptr);
+		RemoveBlock(s_Tags[reinterpret_cast<unsigned*>(p)[-1]], bytes);
+		RemoveBlock(s_Total, bytes);
+
+		const size_t headerSize = GetHeaderSize(alignment);
+		std::pmr::new_delete_resource()->deallocate(p - headerSize, bytes + headerSize, headerSize);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+private:
+	// Заголовок занимает столько же, сколько выравнивание блока (но не меньше alignof(std::max_align_t)),
+	// поэтому выделенный блок остаётся выровненным так, как было запрошено
+	static size_t GetHeaderSize(size_t alignment) noexcept
+	{
+		return (std::max)(alignment, alignof(std::max_align_t));
+	}
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   MemTag
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+MemTag::MemTag(const char* name) noexcept
+	: m_PrevTag(s_CurrentTag)
+{
+	s_CurrentTag = MemTracker::GetTagIndex(name);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+MemTag::~MemTag() noexcept
+{
+	s_CurrentTag = m_PrevTag;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   TaggedResource
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void* TaggedResource::do_allocate(size_t bytes, size_t alignment)
+{
+	MemTag tag(m_Name);
+	return m_Upstream->allocate(bytes, alignment);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void TaggedResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	m_Upstream->deallocate(p, bytes, alignment);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool TaggedResource::do_is_equal(const std::pmr::memory_resource& that) const noexcept
+{
+	return this == &that;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   MemTracker
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void MemTracker::Report()
+{
+	if (!SystemLog::InstanceExists())
+		return;
+
+	auto print = [](const TagStats& stats) {
+		*LogRecordHolder(Log::MsgType::Info) << "  " << stats.name << ": " << uint64_t(stats.bytes) << " bytes in " <<
+			uint64_t(stats.blocks) << " blocks (peak " << uint64_t(stats.peakBytes) << " bytes, " <<
+			uint64_t(stats.allocations) << " allocations)";
+	};
+
+	LOG_INFO("Memory usage by subsystem:");
+	for (const auto& stats : GetStats())
+	{
+		if (stats.allocations)
+			print(stats);
+	}
+	print(GetTotalStats());
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+std::vector<MemTracker::TagStats> MemTracker::GetStats()
+{
+	const unsigned count = s_TagCount.load(std::memory_order_acquire);
+
+	std::vector<TagStats> result;
+	result.reserve(count);
+	for (unsigned i = 0; i < count; ++i)
+		result.push_back(GetTagStats(s_Tags[i], i ? s_Tags[i].name.load(std::memory_order_relaxed) : "Other"));
+
+	return result;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+MemTracker::TagStats MemTracker::GetTotalStats() noexcept
+{
+	return GetTagStats(s_Total, "Total");
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+std::pmr::memory_resource* MemTracker::GetResource() noexcept
+{
+	// Источник не удаляется при завершении программы, так как память может
+	// освобождаться в деструкторах статических объектов и после его уничтожения
+	static TrackingResource* resource = new TrackingResource;
+	return resource;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+unsigned MemTracker::GetTagIndex(const char* name) noexcept
+{
+	// Обычно метка задаётся литералом, поэтому сначала сравниваем указатели, и только потом строки
+	unsigned count = s_TagCount.load(std::memory_order_acquire);
+	for (unsigned i = 1; i < count; ++i)
+	{
+		if (s_Tags[i].name.load(std::memory_order_relaxed) == name)
+			return i;
+	}
+
+	static thrd::CriticalSection cs;
+	thrd::Lock lock(cs);
+
+	count = s_TagCount.load(std::memory_order_relaxed);
+	for (unsigned i = 1; i < count; ++i)
+	{
+		if (!strcmp(s_Tags[i].name.load(std::memory_order_relaxed), name))
+			return i;
+	}
+
+	if (count == MAX_TAGS)
+		return 0;
+
+	s_Tags[count].name.store(name, std::memory_order_relaxed);
+	s_TagCount.store(count + 1, std::memory_order_release);
+	return count;
+}
+
+#endif // AML_MEMTRACK
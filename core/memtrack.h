@@ -0,0 +1,128 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "platform.h"
+#include "util.h"
+
+#if AML_MEMTRACK
+	#include <memory_resource>
+	#include <vector>
+#endif
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   MemTag - метка подсистемы для учёта памяти
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Объект MemTag на время своего существования задаёт в текущем потоке метку (имя подсистемы), к которой относится память,
+// выделяемая в куче контейнерами и буферами AML. Метки образуют стек: вложенная метка действует до разрушения своего объекта,
+// после чего снова действует внешняя. Память учитывается за той меткой, которая действовала при её выделении (независимо от
+// того, где и когда память будет освобождена). Пример: { util::MemTag tag("xml"); doc.Load(path); }. Библиотека сама
+// ставит метки "Log", "MemoryFile" и "XmlDocument". Блоки MemoryFile выделяются слэбами общего пула, поэтому после закрытия
+// файлов память остаётся учтённой за меткой "MemoryFile", пока пул её удерживает (см. MemoryFile::TrimBlockPool). Если учёт
+// памяти выключен (макрос AML_MEMTRACK равен 0), то класс пустой и не генерирует никакого кода
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class MemTag final
+{
+	AML_NONCOPYABLE(MemTag)
+
+public:
+	#if AML_MEMTRACK
+		// Параметр name должен указывать на строку, существующую до завершения программы (обычно это литерал)
+		explicit MemTag(const char* name) noexcept;
+		~MemTag() noexcept;
+	#else
+		explicit constexpr MemTag(const char*) noexcept {}
+	#endif
+
+private:
+	#if AML_MEMTRACK
+		unsigned m_PrevTag;		// Индекс метки, действовавшей до создания объекта
+	#endif
+};
+
+#if AML_MEMTRACK
+//--------------------------------------------------------------------------------------------------------------------------------
+// Источник памяти TaggedResource выделяет память через источник upstream, задавая на время выделения метку name. Он нужен
+// объектам, которые выделяют память по мере использования, то есть вне области действия метки (например, буферам журнала)
+class TaggedResource final : public std::pmr::memory_resource
+{
+public:
+	// Параметр name должен указывать на строку, существующую до завершения программы
+	TaggedResource(const char* name, std::pmr::memory_resource* upstream) noexcept
+		: m_Name(name)
+		, m_Upstream(upstream)
+	{
+	}
+
+protected:
+	virtual void* do_allocate(size_t bytes, size_t alignment) override;
+	virtual void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	virtual bool do_is_equal(const std::pmr::memory_resource& that) const noexcept override;
+
+private:
+	const char* m_Name;
+	std::pmr::memory_resource* m_Upstream;
+};
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   MemTracker - учёт памяти по подсистемам
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс MemTracker учитывает память, выделяемую через источник памяти "куча" (см. GetHeapResource), то есть всю память
+// контейнеров и буферов AML, для которых не задан другой источник. Для каждой метки (см. MemTag) учитываются текущий
+// размер и количество блоков, максимальный размер и общее количество выделений. Память, выделенная без метки, относится
+// к метке "Other". Учёт включается макросом AML_MEMTRACK, без него доступна только функция Report (ничего не делает)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class MemTracker final
+{
+public:
+	// Максимальное количество меток (если меток больше, то память лишних меток относится к метке "Other")
+	static constexpr unsigned MAX_TAGS = 64;
+
+	// Выводит в системный журнал (SystemLog) отчёт о текущем использовании памяти
+	#if AML_MEMTRACK
+		static void Report();
+	#else
+		static void Report() noexcept {}
+	#endif
+
+	#if AML_MEMTRACK
+		// Статистика метки
+		struct TagStats {
+			const char* name;		// Имя метки
+			size_t bytes;			// Текущий размер выделенной памяти в байтах
+			size_t blocks;			// Текущее количество выделенных блоков
+			size_t peakBytes;		// Максимальный размер выделенной памяти в байтах
+			size_t allocations;		// Общее количество выделений
+		};
+
+		// Возвращает статистику всех меток (в порядке их первого использования) и общую статистику
+		static std::vector<TagStats> GetStats();
+		static TagStats GetTotalStats() noexcept;
+
+		// Возвращает учитывающий источник памяти (выделяет память в куче, запоминая метку каждого блока)
+		static std::pmr::memory_resource* GetResource() noexcept;
+	#endif
+
+private:
+	friend class MemTag;
+
+	#if AML_MEMTRACK
+		// Возвращает индекс метки с именем name, регистрируя её при первом использовании
+		static unsigned GetTagIndex(const char* name) noexcept;
+	#endif
+};
+
+} // namespace util
@@ -0,0 +1,447 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "multisearch.h"
+
+#include "exception.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#if AML_AVX2
+	#include <immintrin.h>
+#endif
+
+using namespace util;
+
+// Флаг в элементе таблицы переходов, означающий, что в состоянии, в которое выполняется
+// переход, заканчивается вхождение хотя бы одного шаблона. Состояния в таблице хранятся
+// как смещения их строк (номер состояния, умноженный на m_Stride)
+static constexpr uint32_t MATCH_FLAG = 0x80000000;
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+static inline uint32_t Fold(CharT c, bool ignoreCase) noexcept
+{
+	const uint32_t u = static_cast<std::make_unsigned_t<CharT>>(c);
+	return (ignoreCase && u - 'A' < 26) ? u | 0x20 : u;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+MultiSearcher::MultiSearcher(const std::vector<std::string_view>& patterns, bool ignoreCase)
+	: m_IgnoreCase(ignoreCase)
+{
+	Build(patterns);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+MultiSearcher::MultiSearcher(const std::vector<std::wstring_view>& patterns, bool ignoreCase)
+	: m_IgnoreCase(ignoreCase)
+{
+	Build(patterns);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+void MultiSearcher::Build(const std::vector<std::basic_string_view<CharT>>& patterns)
+{
+	// Каждому символу шаблонов назначается свой класс, класс 0 - все остальные символы. Если регистр
+	// не учитывается, то прописные латинские буквы получают классы соответствующих строчных букв
+	m_Stride = 1;
+	for (const auto& pattern : patterns)
+	{
+		for (const CharT c : pattern)
+		{
+			const uint32_t u = Fold(c, m_IgnoreCase);
+			if (u < 256)
+			{
+				if (!m_ByteClass[u])
+					m_ByteClass[u] = m_Stride++;
+			}
+			else if (m_WideClasses.TryEmplace(u, m_Stride).second)
+				++m_Stride;
+		}
+	}
+
+	if (m_IgnoreCase)
+	{
+		for (unsigned c = 'A'; c <= 'Z'; ++c)
+			m_ByteClass[c] = m_ByteClass[c | 0x20];
+	}
+
+	// Строим бор. Нулевой элемент таблицы означает отсутствие перехода, так
+	// как в корень (состояние 0) не ведёт ни одно ребро бора
+	const auto addState = [this]() -> uint32_t {
+		const size_t offset = m_Next.size();
+		if (offset + m_Stride >= MATCH_FLAG)
+			throw ERuntime("MultiSearcher: too many patterns");
+
+		m_Next.resize(offset + m_Stride);
+		return static_cast<uint32_t>(offset);
+	};
+
+	// Для каждого состояния храним первый шаблон, заканчивающийся в нём, а для каждого
+	// шаблона - следующий шаблон с тем же состоянием (значения увеличены на 1, 0 - нет шаблона)
+	std::vector<uint32_t> terminal(1);
+	std::vector<uint32_t> nextSame(patterns.size());
+
+	addState();
+	m_Lengths.reserve(patterns.size());
+	for (size_t i = 0; i < patterns.size(); ++i)
+	{
+		const auto& pattern = patterns[i];
+		m_Lengths.push_back(pattern.size());
+		if (pattern.empty())
+			continue;
+
+		uint32_t state = 0;
+		for (const CharT c : pattern)
+		{
+			const size_t index = state + GetClass(static_cast<CharT>(Fold(c, m_IgnoreCase)));
+			if (!m_Next[index])
+			{
+				const uint32_t newState = addState();
+				m_Next[index] = newState;
+				terminal.push_back(0);
+			}
+			state = m_Next[index];
+		}
+
+		uint32_t& first = terminal[state / m_Stride];
+		nextSame[i] = first;
+		first = static_cast<uint32_t>(i + 1);
+	}
+
+	// Обходим бор в ширину, вычисляя суффиксные ссылки и достраивая недостающие переходы по
+	// переходам суффиксной ссылки. Состояния суффиксных ссылок короче и обработаны раньше
+	const size_t stateCount = m_Next.size() / m_Stride;
+	std::vector<uint32_t> fail(stateCount);
+	std::vector<uint32_t> queue;
+	queue.reserve(stateCount);
+
+	for (uint32_t c = 0; c < m_Stride; ++c)
+	{
+		if (const uint32_t child = m_Next[c])
+			queue.push_back(child);
+	}
+
+	for (size_t i = 0; i < queue.size(); ++i)
+	{
+		const uint32_t state = queue[i];
+		const uint32_t link = fail[state / m_Stride];
+		for (uint32_t c = 0; c < m_Stride; ++c)
+		{
+			uint32_t& next = m_Next[state + c];
+			if (next)
+			{
+				fail[next / m_Stride] = m_Next[link + c];
+				queue.push_back(next);
+			} else
+				next = m_Next[link + c];
+		}
+	}
+
+	// Список шаблонов состояния - это его собственные шаблоны и список состояния его суффиксной ссылки
+	m_OutBegin.assign(stateCount, 0);
+	m_OutEnd.assign(stateCount, 0);
+	for (const uint32_t state : queue)
+	{
+		const size_t id = state / m_Stride;
+		m_OutBegin[id] = static_cast<uint32_t>(m_Outputs.size());
+		for (uint32_t p = terminal[id]; p; p = nextSame[p - 1])
+			m_Outputs.push_back(p - 1);
+
+		const size_t link = fail[id] / m_Stride;
+		for (uint32_t k = m_OutBegin[link]; k < m_OutEnd[link]; ++k)
+			m_Outputs.push_back(m_Outputs[k]);
+		m_OutEnd[id] = static_cast<uint32_t>(m_Outputs.size());
+	}
+
+	for (uint32_t& next : m_Next)
+	{
+		const size_t id = next / m_Stride;
+		if (m_OutEnd[id] != m_OutBegin[id])
+			next |= MATCH_FLAG;
+	}
+
+	// Если вхождение может начаться лишь с нескольких символов, то их можно искать блоками
+	for (const auto& pattern : patterns)
+	{
+		if (pattern.empty())
+			continue;
+
+		const uint32_t u = static_cast<std::make_unsigned_t<CharT>>(pattern[0]);
+		const uint32_t variants[2] = { Fold(pattern[0], m_IgnoreCase), (m_IgnoreCase && u - 'a' < 26) ? u & ~0x20u : u };
+		for (const uint32_t v : variants)
+		{
+			if (v < 256)
+				m_FirstChars.Add(static_cast<char>(v));
+			m_WFirstChars.Add(static_cast<wchar_t>(v));
+		}
+	}
+
+	m_UsePrefilter = m_WFirstChars.GetCount() && m_WFirstChars.GetCount() <= WCharClass::MAX_BLOCK_CHARS;
+
+	#if AML_AVX2
+		if (!m_UsePrefilter)
+			BuildTeddy(patterns);
+	#endif
+}
+
+#if AML_AVX2
+// Максимальная оценка доли позиций-кандидатов, при которой используется префильтр Teddy
+static constexpr double MAX_TEDDY_SHARE = 0.2;
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+void MultiSearcher::BuildTeddy(const std::vector<std::basic_string_view<CharT>>& patterns)
+{
+	// Во всех позициях проверяется одинаковое количество первых символов,
+	// поэтому оно не может быть больше длины самого короткого шаблона
+	size_t length = 0;
+	for (const auto& pattern : patterns)
+	{
+		if (!pattern.empty())
+			length = length ? (std::min)(length, pattern.size()) : (std::min)(pattern.size(), TEDDY_MAX_LENGTH);
+	}
+
+	for (const auto& pattern : patterns)
+	{
+		if (pattern.empty())
+			continue;
+
+		// Шаблоны, среди первых символов которых есть символы с кодами 256 и больше, в строках char не встречаются
+		const auto isWide = [&](CharT c) { return Fold(c, m_IgnoreCase) >= 256; };
+		if (std::any_of(pattern.begin(), pattern.begin() + length, isWide))
+			continue;
+
+		// Шаблоны с одинаковым первым символом попадают в одну группу (так ложных срабатываний меньше)
+		const uint8_t group = static_cast<uint8_t>(1 << (Fold(pattern[0], m_IgnoreCase) & 7));
+		for (size_t k = 0; k < length; ++k)
+		{
+			const uint32_t u = Fold(pattern[k], m_IgnoreCase);
+			const uint32_t variants[2] = { u, (m_IgnoreCase && u - 'a' < 26) ? u & ~0x20u : u };
+			for (const uint32_t v : variants)
+			{
+				m_TeddyLow[k][v & 15] |= group;
+				m_TeddyHigh[k][v >> 4] |= group;
+			}
+		}
+	}
+
+	// Когда шаблонов много, почти каждая позиция строки оказывается кандидатом, и префильтр только замедляет поиск.
+	// Поэтому оценим долю позиций-кандидатов в тексте из печатных символов ASCII (сумма по группам вероятностей того,
+	// что все первые символы подходят группе, - это оценка сверху) и не будем использовать префильтр, если она велика
+	double share = 0;
+	for (unsigned group = 1; group < 256; group <<= 1)
+	{
+		double probability = 1;
+		for (size_t k = 0; k < length; ++k)
+		{
+			unsigned count = 0;
+			for (unsigned c = 0x20; c < 0x7f; ++c)
+				count += (m_TeddyLow[k][c & 15] & m_TeddyHigh[k][c >> 4] & group) != 0;
+			probability *= count / 95.0;
+		}
+		share += probability;
+	}
+
+	if (share <= MAX_TEDDY_SHARE)
+		m_TeddyLength = length;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+const char* MultiSearcher::FindTeddyCandidate(const char* p, const char* end) const noexcept
+{
+	// Вхождение не может начаться ближе чем за m_TeddyLength символов до конца строки
+	const size_t length = m_TeddyLength;
+	if (static_cast<size_t>(end - p) < length)
+		return end;
+
+	const char* const last = end - (length - 1);
+	if (last - p >= 32)
+	{
+		__m256i low[TEDDY_MAX_LENGTH], high[TEDDY_MAX_LENGTH];
+		for (size_t k = 0; k < length; ++k)
+		{
+			low[k] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m_TeddyLow[k])));
+			high[k] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m_TeddyHigh[k])));
+		}
+
+		// Для каждого байта блока маски групп по младшей и старшей тетрадам выбираются инструкцией pshufb,
+		// а группа остаётся кандидатом, только если её бит есть во всех масках для всех первых символов
+		const __m256i nibbleMask = _mm256_set1_epi8(0x0f);
+		for (; last - p >= 32; p += 32)
+		{
+			__m256i groups = _mm256_set1_epi8(-1);
+			for (size_t k = 0; k < length; ++k)
+			{
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + k));
+				const __m256i lo = _mm256_shuffle_epi8(low[k], _mm256_and_si256(v, nibbleMask));
+				const __m256i hi = _mm256_shuffle_epi8(high[k], _mm256_and_si256(_mm256_srli_epi16(v, 4), nibbleMask));
+				groups = _mm256_and_si256(groups, _mm256_and_si256(lo, hi));
+			}
+
+			const __m256i empty = _mm256_cmpeq_epi8(groups, _mm256_setzero_si256());
+			if (const uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(empty)))
+				return p + CountTrailingZeros(mask);
+		}
+	}
+
+	for (; p < last; ++p)
+	{
+		unsigned groups = 0xff;
+		for (size_t k = 0; k < length; ++k)
+		{
+			const uint8_t c = static_cast<uint8_t>(p[k]);
+			groups &= m_TeddyLow[k][c & 15] & m_TeddyHigh[k][c >> 4];
+		}
+
+		if (groups)
+			return p;
+	}
+
+	return end;
+}
+#endif // AML_AVX2
+
+//--------------------------------------------------------------------------------------------------------------------------------
+uint32_t MultiSearcher::GetClass(wchar_t c) const noexcept
+{
+	const uint32_t u = static_cast<std::make_unsigned_t<wchar_t>>(c);
+	if (u < 256)
+		return m_ByteClass[u];
+	if (m_WideClasses.empty())
+		return 0;
+
+	const uint32_t* cls = m_WideClasses.Find(u);
+	return cls ? *cls : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+inline const CharT* MultiSearcher::SkipToCandidate(const CharT* p, const CharT* end) const noexcept
+{
+	#if AML_AVX2
+		if constexpr (std::is_same_v<CharT, char>)
+		{
+			if (m_TeddyLength)
+				return FindTeddyCandidate(p, end);
+		}
+	#endif
+
+	return GetFirstChars(CharT()).Find(p, end);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT, class F>
+bool MultiSearcher::Scan(std::basic_string_view<CharT> str, size_t from, F&& onMatch) const
+{
+	if (m_Next.empty() || from >= str.size())
+		return false;
+
+	const uint32_t* const next = m_Next.data();
+	const CharT* const begin = str.data();
+	const CharT* const end = begin + str.size();
+
+	bool usePrefilter = m_UsePrefilter;
+	#if AML_AVX2
+		if constexpr (std::is_same_v<CharT, char>)
+			usePrefilter = usePrefilter || m_TeddyLength;
+	#endif
+
+	uint32_t state = 0;
+	for (const CharT* p = begin + from; p != end; ++p)
+	{
+		if (!state && usePrefilter)
+		{
+			p = SkipToCandidate(p, end);
+			if (p == end)
+				break;
+		}
+
+		state = next[state + GetClass(*p)];
+		if (state & MATCH_FLAG)
+		{
+			state &= ~MATCH_FLAG;
+			if (onMatch(static_cast<size_t>(p - begin) + 1, state))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+size_t MultiSearcher::EnumMatches(std::basic_string_view<CharT> str, const MatchFn& cb) const
+{
+	size_t count = 0;
+	Scan(str, 0, [&](size_t end, uint32_t state) {
+		const size_t id = state / m_Stride;
+		for (uint32_t i = 0; i < m_OutEnd[id] - m_OutBegin[id]; ++i)
+		{
+			Match match;
+			GetMatch(match, end, state, i);
+			++count;
+			if (!cb(match))
+				return true;
+		}
+		return false;
+	});
+
+	return count;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void MultiSearcher::GetMatch(Match& match, size_t end, uint32_t state, uint32_t index) const noexcept
+{
+	const uint32_t pattern = m_Outputs[m_OutBegin[state / m_Stride] + index];
+	match.length = m_Lengths[pattern];
+	match.position = end - match.length;
+	match.pattern = pattern;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool MultiSearcher::IsFoundIn(std::string_view str) const noexcept
+{
+	return Scan(str, 0, [](size_t, uint32_t) { return true; });
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool MultiSearcher::IsFoundIn(std::wstring_view str) const noexcept
+{
+	return Scan(str, 0, [](size_t, uint32_t) { return true; });
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool MultiSearcher::FindFirst(std::string_view str, Match& match, size_t from) const noexcept
+{
+	return Scan(str, from, [&](size_t end, uint32_t state) {
+		GetMatch(match, end, state, 0);
+		return true;
+	});
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool MultiSearcher::FindFirst(std::wstring_view str, Match& match, size_t from) const noexcept
+{
+	return Scan(str, from, [&](size_t end, uint32_t state) {
+		GetMatch(match, end, state, 0);
+		return true;
+	});
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t MultiSearcher::ForEachMatch(std::string_view str, const MatchFn& cb) const
+{
+	return EnumMatches(str, cb);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t MultiSearcher::ForEachMatch(std::wstring_view str, const MatchFn& cb) const
+{
+	return EnumMatches(str, cb);
+}
@@ -0,0 +1,141 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "charclass.h"
+#include "flatmap.h"
+#include "platform.h"
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   MultiSearcher - одновременный поиск набора подстрок
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс MultiSearcher ищет в строке все подстроки-шаблоны набора за один проход по строке (алгоритм Ахо-Корасик). Автомат
+// строится в конструкторе в виде полной таблицы переходов (DFA), поэтому обработка каждого символа строки - это одно
+// обращение к таблице, независимо от количества шаблонов. Чтобы таблица была компактной, символы разбиваются на классы:
+// все символы, не встречающиеся в шаблонах, попадают в один класс. Участки строки, в которых не может начаться вхождение,
+// пропускаются блоками (префильтр). Если все шаблоны начинаются не больше чем с BasicCharClass::MAX_BLOCK_CHARS разных
+// символов (с учётом обоих регистров), то первые символы ищутся блоками SSE2/AVX2 с помощью класса BasicCharClass. Иначе,
+// если макрос AML_AVX2 равен 1, в строках char используется префильтр Teddy: шаблоны разбиваются на 8 групп по первому
+// символу, и для каждой позиции блока из 32 байт по тетрадам первых (до 3) символов инструкцией pshufb определяются группы,
+// шаблоны которых могут начинаться в этой позиции. Если шаблонов так много, что кандидатом оказывается большая часть
+// позиций (обычно это несколько сотен шаблонов), то префильтр Teddy не используется. Не используется префильтр и для строк
+// wchar_t с большим количеством первых символов, и без AVX2: тогда каждый символ строки обрабатывается автоматом
+
+// Шаблоны и строки сравниваются по кодовым единицам (символам char или wchar_t), поэтому шаблоны из символов не ASCII
+// должны быть в той же кодировке, что и строка (например, UTF-8 для строк char). Если параметр ignoreCase равен true,
+// то не учитывается регистр только латинских букв 'A'..'Z' (так же, как в функциях Str*InsCmp). Пустые шаблоны никогда
+// не находятся. Объект стоит создать один раз (например, для набора ключевых слов фильтра лога) и использовать много раз
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class MultiSearcher
+{
+public:
+	// Найденное вхождение шаблона
+	struct Match
+	{
+		size_t position;	// Позиция вхождения в строке
+		size_t length;		// Длина вхождения (длина шаблона)
+		size_t pattern;		// Индекс шаблона в наборе
+	};
+
+	using MatchFn = std::function<bool(const Match&)>;
+
+	// Создаёт пустой набор шаблонов, которые никогда не находятся
+	MultiSearcher() noexcept = default;
+
+	// Строит автомат для поиска шаблонов patterns. При слишком большом размере таблицы
+	// переходов (больше 2^31 элементов, т.е. 8 Гб) генерирует исключение ERuntime
+	explicit MultiSearcher(const std::vector<std::string_view>& patterns, bool ignoreCase = false);
+	explicit MultiSearcher(const std::vector<std::wstring_view>& patterns, bool ignoreCase = false);
+
+	// Возвращает количество шаблонов в наборе (включая пустые)
+	size_t GetPatternCount() const noexcept { return m_Lengths.size(); }
+	// Возвращает true, если регистр латинских букв не учитывается
+	bool IsIgnoreCase() const noexcept { return m_IgnoreCase; }
+
+	// Возвращает true, если строка str содержит хотя бы один шаблон
+	bool IsFoundIn(std::string_view str) const noexcept;
+	bool IsFoundIn(std::wstring_view str) const noexcept;
+
+	// Ищет в строке str, начиная с позиции from, вхождение, которое заканчивается раньше всех остальных (если таких
+	// вхождений несколько, то самое длинное из них). Возвращает false, если ни один шаблон не найден
+	bool FindFirst(std::string_view str, Match& match, size_t from = 0) const noexcept;
+	bool FindFirst(std::wstring_view str, Match& match, size_t from = 0) const noexcept;
+
+	// Вызывает функцию cb для каждого вхождения шаблонов (в том числе перекрывающихся) в порядке позиций их окончания,
+	// а для вхождений, заканчивающихся в одной позиции, - от длинных к коротким. Если функция cb вернёт false, то поиск
+	// прекращается. Возвращает количество вхождений, для которых была вызвана функция cb
+	size_t ForEachMatch(std::string_view str, const MatchFn& cb) const;
+	size_t ForEachMatch(std::wstring_view str, const MatchFn& cb) const;
+
+private:
+	template<class CharT>
+	void Build(const std::vector<std::basic_string_view<CharT>>& patterns);
+
+	// Проходит строку str автоматом, начиная с позиции from, и для каждой позиции, в которой заканчивается вхождение,
+	// вызывает функцию onMatch(end, state). Если функция вернула true, то проход прекращается, а функция возвращает true
+	template<class CharT, class F>
+	bool Scan(std::basic_string_view<CharT> str, size_t from, F&& onMatch) const;
+
+	template<class CharT>
+	size_t EnumMatches(std::basic_string_view<CharT> str, const MatchFn& cb) const;
+
+	// Возвращает класс символа c
+	uint32_t GetClass(char c) const noexcept { return m_ByteClass[static_cast<uint8_t>(c)]; }
+	uint32_t GetClass(wchar_t c) const noexcept;
+
+	const CharClass& GetFirstChars(char) const noexcept { return m_FirstChars; }
+	const WCharClass& GetFirstChars(wchar_t) const noexcept { return m_WFirstChars; }
+
+	// Возвращает указатель на первую позицию строки (от p до end), в которой может начаться вхождение, или end
+	template<class CharT>
+	const CharT* SkipToCandidate(const CharT* p, const CharT* end) const noexcept;
+
+	#if AML_AVX2
+		// Максимальное количество первых символов шаблонов, по которым работает префильтр Teddy
+		static constexpr size_t TEDDY_MAX_LENGTH = 3;
+
+		template<class CharT>
+		void BuildTeddy(const std::vector<std::basic_string_view<CharT>>& patterns);
+		const char* FindTeddyCandidate(const char* p, const char* end) const noexcept;
+	#endif
+
+	// Заполняет структуру match для вхождения с индексом index в списке вхождений состояния state
+	void GetMatch(Match& match, size_t end, uint32_t state, uint32_t index) const noexcept;
+
+private:
+	std::vector<uint32_t> m_Next;		// Таблица переходов: m_Stride элементов на каждое состояние автомата
+	std::vector<uint32_t> m_OutBegin;	// Начало списка шаблонов в m_Outputs для каждого состояния
+	std::vector<uint32_t> m_OutEnd;		// Конец списка шаблонов в m_Outputs для каждого состояния
+	std::vector<uint32_t> m_Outputs;	// Списки индексов шаблонов, вхождения которых заканчиваются в состоянии
+	std::vector<size_t> m_Lengths;		// Длины шаблонов
+	uint32_t m_ByteClass[256] = {};		// Классы символов с кодами меньше 256
+	FlatMap<uint32_t, uint32_t> m_WideClasses;	// Классы символов wchar_t с кодами 256 и больше
+	uint32_t m_Stride = 0;				// Количество классов символов (размер строки таблицы переходов)
+	CharClass m_FirstChars;				// Первые символы шаблонов (для пропуска участков строки)
+	WCharClass m_WFirstChars;
+	bool m_UsePrefilter = false;		// true, если участки строки пропускаются по первым символам шаблонов
+	bool m_IgnoreCase = false;
+
+	#if AML_AVX2
+		// Таблицы префильтра Teddy: для k-го символа шаблонов элементы m_TeddyLow[k][n] и m_TeddyHigh[k][n] - маски
+		// групп, у шаблонов которых младшая (старшая) тетрада этого символа равна n. Если m_TeddyLength равно 0, то
+		// префильтр Teddy не используется
+		alignas(16) uint8_t m_TeddyLow[TEDDY_MAX_LENGTH][16] = {};
+		alignas(16) uint8_t m_TeddyHigh[TEDDY_MAX_LENGTH][16] = {};
+		size_t m_TeddyLength = 0;
+	#endif
+};
+
+} // namespace util
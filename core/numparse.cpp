@@ -0,0 +1,80 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "numparse.h"
+
+#include "util.h"
+
+#include <charconv>
+
+using namespace util;
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+static NumParse ParseFloat(std::string_view str, T& value) noexcept
+{
+	const char* const end = str.data() + str.size();
+
+	T result;
+	const auto r = std::from_chars(str.data(), end, result);
+	if (r.ec == std::errc::invalid_argument || r.ptr != end)
+		return NumParse::Invalid;
+	if (r.ec == std::errc::result_out_of_range)
+		return NumParse::Overflow;
+
+	value = result;
+	return NumParse::Ok;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+static NumParse ParseFloat(std::wstring_view str, T& value)
+{
+	// Функция std::from_chars работает только со строками char, поэтому строка копируется в буфер.
+	// Строки длиннее буфера (например, с очень большим количеством цифр) копируются в кучу
+	char buffer[128];
+	std::string heapBuffer;
+
+	char* out = buffer;
+	const size_t size = str.size();
+	if (size > CountOf(buffer))
+	{
+		heapBuffer.resize(size);
+		out = heapBuffer.data();
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		if (static_cast<unsigned>(str[i]) >= 0x80)
+			return NumParse::Invalid;
+		out[i] = static_cast<char>(str[i]);
+	}
+
+	return ParseFloat(std::string_view(out, size), value);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+NumParse util::ParseNumber(std::string_view str, double& value) noexcept
+{
+	return ParseFloat(str, value);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+NumParse util::ParseNumber(std::string_view str, float& value) noexcept
+{
+	return ParseFloat(str, value);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+NumParse util::ParseNumber(std::wstring_view str, double& value)
+{
+	return ParseFloat(str, value);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+NumParse util::ParseNumber(std::wstring_view str, float& value)
+{
+	return ParseFloat(str, value);
+}
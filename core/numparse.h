@@ -0,0 +1,111 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "platform.h"
+
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Разбор чисел из строк
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функции ParseNumber этого раздела разбирают число, занимающее всю строку str (без пробелов до и после числа и без знака
+// '+'), и сохраняют его в value. Если строка не является корректным числом или число не умещается в типе value, то value
+// не изменяется, а функция возвращает код ошибки. Результат не зависит от локали: разделителем целой и дробной частей
+// числа с плавающей запятой всегда является точка. Строки Wide могут содержать только символы ASCII
+
+// Результат разбора числа
+enum class NumParse : uint8_t
+{
+	Ok,			// Число разобрано и сохранено в value
+	Invalid,	// Строка пустая или не является числом нужного типа
+	Overflow	// Число выходит за пределы диапазона типа (для чисел с плавающей запятой - в том числе слишком близко к 0)
+};
+
+// Разбирает целое число в диапазоне [p, end) так же, как функция ParseNumber (см. ниже)
+template<class T, class CharT>
+NumParse ParseInteger(const CharT* p, const CharT* const end, T& value, unsigned base) noexcept
+{
+	static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "T must be an integer type");
+	using U = std::make_unsigned_t<T>;
+
+	bool isNegative = false;
+	if (p != end && *p == '-')
+	{
+		if constexpr (!std::is_signed_v<T>)
+			return NumParse::Invalid;
+
+		isNegative = true;
+		++p;
+	}
+
+	if (p == end || base < 2 || base > 36)
+		return NumParse::Invalid;
+
+	// Наибольшее абсолютное значение числа и наибольшее значение, которое ещё можно умножить на base
+	const U limit = isNegative ? static_cast<U>(U(0) - static_cast<U>(std::numeric_limits<T>::min())) :
+		static_cast<U>(std::numeric_limits<T>::max());
+	const U mulLimit = static_cast<U>(limit / base);
+	const unsigned lastDigitLimit = static_cast<unsigned>(limit % base);
+
+	U result = 0;
+	bool isOverflow = false;
+	for (; p != end; ++p)
+	{
+		const auto c = static_cast<std::make_unsigned_t<CharT>>(*p);
+
+		unsigned digit = c - '0';
+		if (digit > 9)
+		{
+			digit = (c | 0x20) - 'a';
+			digit = (digit < 26) ? digit + 10 : base;
+		}
+		if (digit >= base)
+			return NumParse::Invalid;
+
+		// После переполнения строка проверяется до конца, чтобы отличить большое число от некорректной строки
+		if (result < mulLimit || (result == mulLimit && digit <= lastDigitLimit))
+			result = static_cast<U>(result * base + digit);
+		else
+			isOverflow = true;
+	}
+
+	if (isOverflow)
+		return NumParse::Overflow;
+
+	value = static_cast<T>(isNegative ? U(0) - result : result);
+	return NumParse::Ok;
+}
+
+// Разбирает целое число в системе счисления с основанием base (от 2 до 36, без префикса вроде "0x"). Цифры больше 9
+// задаются буквами в любом регистре. Знак '-' допускается только для знаковых типов. Число ноль с минусом ("-0")
+// считается корректным. Переполнение определяется точно: например, "-128" для int8_t - корректное число
+template<class T, class = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+inline NumParse ParseNumber(std::string_view str, T& value, unsigned base = 10) noexcept
+{
+	return ParseInteger(str.data(), str.data() + str.size(), value, base);
+}
+
+template<class T, class = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+inline NumParse ParseNumber(std::wstring_view str, T& value, unsigned base = 10) noexcept
+{
+	return ParseInteger(str.data(), str.data() + str.size(), value, base);
+}
+
+// Разбирают число с плавающей запятой в десятичной записи (как у функции strtod, в том числе с экспонентой,
+// а также "inf" и "nan"). Значение округляется до ближайшего числа типа value (функция std::from_chars)
+NumParse ParseNumber(std::string_view str, double& value) noexcept;
+NumParse ParseNumber(std::string_view str, float& value) noexcept;
+NumParse ParseNumber(std::wstring_view str, double& value);
+NumParse ParseNumber(std::wstring_view str, float& value);
+
+} // namespace util
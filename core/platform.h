@@ -72,6 +72,15 @@
 	#define AML_PRODUCTION 0
 #endif
 
+#ifdef AML_MEMTRACK
+	// Макрос AML_MEMTRACK включает учёт памяти, выделяемой контейнерами и буферами AML в куче, с разбивкой по
+	// подсистемам (см. memtrack.h). Учёт замедляет выделение памяти, поэтому по умолчанию он выключен
+	#undef AML_MEMTRACK
+	#define AML_MEMTRACK 1
+#else
+	#define AML_MEMTRACK 0
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //   Настройка компилятора
@@ -101,4 +110,22 @@
 
 	#define AML_LITTLE_ENDIAN 1
 	#define AML_BIG_ENDIAN 0
+
+	// Размер строки кеша CPU в байтах. Используется для выравнивания данных, к которым
+	// часто обращаются разные потоки, во избежание ложного разделения (false sharing)
+	#define AML_CACHE_LINE_SIZE 64
+
+	// Наборы инструкций SIMD, которые компилятор может использовать (задаются ключом /arch). SSE2 всегда
+	// доступен в 64-битном коде, а AVX2 - только если он явно разрешён ключом /arch:AVX2. Функции, которые
+	// используют эти инструкции, должны иметь и реализацию без них для случая, когда макрос равен 0
+	#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+		#define AML_SSE2 1
+	#else
+		#define AML_SSE2 0
+	#endif
+	#ifdef __AVX2__
+		#define AML_AVX2 1
+	#else
+		#define AML_AVX2 0
+	#endif
 #endif
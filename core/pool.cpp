@@ -0,0 +1,305 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "pool.h"
+
+#include "debug.h"
+#include "sysinfo.h"
+#include "thread.h"
+
+using namespace util;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SlabPool
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Свободный блок. Поля nextBatch и batchSize используются только в первом блоке пачки, находящейся в депо
+struct SlabPool::FreeNode {
+	FreeNode* next;			// Следующий блок в пачке (в кеше)
+	FreeNode* nextBatch;	// Первый блок следующей пачки в депо
+	size_t batchSize;		// Количество блоков в пачке
+};
+
+// Заголовок слэба (блоки следуют за ним)
+struct SlabPool::Slab {
+	Slab* next;				// Следующий слэб в списке
+	size_t freeCount;		// Количество свободных блоков (используется только функцией Trim)
+};
+
+// Кеш свободных блоков. Каждый кеш занимает отдельную строку кеша CPU
+struct alignas(AML_CACHE_LINE_SIZE) SlabPool::Cache {
+	std::atomic<bool> isLocked = false;
+	FreeNode* first = nullptr;
+	size_t count = 0;
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SlabPool::SlabPool(size_t objectSize, size_t alignment, std::pmr::memory_resource* resource)
+	: m_ObjectSize(objectSize)
+	, m_Alignment((std::max)(alignment, alignof(Slab)))
+	, m_Resource(GetResource(resource))
+	, m_DepotCS(500)
+{
+	Assert(alignment && !(alignment & (alignment - 1)));
+	auto alignUp = [this](size_t size) { return (size + m_Alignment - 1) & ~(m_Alignment - 1); };
+
+	m_HeaderSize = alignUp(sizeof(SlotHeader));
+	m_SlotSize = alignUp(m_HeaderSize + (std::max)(objectSize, sizeof(FreeNode)));
+
+	// Пачка занимает до 16 КБ (от 1 до 32 блоков), а слэб - около 64 КБ (но не менее одной пачки). Поэтому
+	// большие блоки (от 16 КБ) передаются в депо поодиночке, а слэб содержит всего несколько таких блоков
+	m_BatchSize = (std::min<size_t>)((std::max<size_t>)(16 * 1024 / m_SlotSize, 1), 32);
+	m_SlabCapacity = m_BatchSize * (std::max<size_t>)(64 * 1024 / (m_SlotSize * m_BatchSize), 1);
+	m_SlabHeaderSize = alignUp(sizeof(Slab));
+	m_SlabSize = m_SlabHeaderSize + m_SlabCapacity * m_SlotSize;
+
+	// Кешей вдвое больше, чем логических процессоров: так меньше вероятность, что кеш
+	// (выбираемый по порядковому номеру потока) окажется общим для активных потоков
+	const unsigned cacheCount = 2 * SystemInfo::Instance().GetCoreCount().logical;
+	unsigned count = 1;
+	while (count < cacheCount && count < 64)
+		count <<= 1;
+
+	m_Caches = new Cache[count];
+	m_CacheMask = count - 1;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SlabPool::~SlabPool()
+{
+	delete[] m_Caches;
+
+	for (Slab* slab = m_Slabs; slab;)
+	{
+		Slab* p = slab;
+		slab = slab->next;
+		m_Resource->deallocate(p, m_SlabSize, m_Alignment);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void* SlabPool::Allocate()
+{
+	Cache& cache = GetCache();
+	LockCache(cache);
+
+	if (!cache.first)
+	{
+		try {
+			Refill(cache);
+		}
+		catch (...)
+		{
+			UnlockCache(cache);
+			throw;
+		}
+	}
+
+	FreeNode* node = cache.first;
+	cache.first = node->next;
+	--cache.count;
+
+	UnlockCache(cache);
+	return node;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SlabPool::Deallocate(void* ptr) noexcept
+{
+	if (!ptr)
+		return;
+
+	Cache& cache = GetCache();
+	LockCache(cache);
+
+	auto node = static_cast<FreeNode*>(ptr);
+	node->next = cache.first;
+	cache.first = node;
+
+	// Держим в кеше не более двух пачек: так поток, который попеременно выделяет
+	// и освобождает блоки, не будет обращаться к депо на каждой границе пачки
+	if (++cache.count >= 2 * m_BatchSize)
+		Flush(cache);
+
+	UnlockCache(cache);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SlabPool::Trim()
+{
+	// Сначала забираем в депо все блоки из кешей потоков
+	for (unsigned i = 0; i <= m_CacheMask; ++i)
+	{
+		Cache& cache = m_Caches[i];
+		LockCache(cache);
+		while (cache.count)
+			Flush(cache);
+		UnlockCache(cache);
+	}
+
+	thrd::Lock lock(m_DepotCS);
+
+	// Подсчитываем количество свободных блоков в каждом слэбе
+	for (FreeNode* batch = m_Depot; batch; batch = batch->nextBatch)
+	{
+		for (FreeNode* node = batch; node; node = node->next)
+			GetHeader(node)->slab->freeCount++;
+	}
+
+	// Собираем свободные блоки из тех слэбов, которые останутся, в один список
+	FreeNode* nodes = nullptr;
+	size_t nodeCount = 0;
+	for (FreeNode* batch = m_Depot; batch;)
+	{
+		FreeNode* nextBatch = batch->nextBatch;
+		for (FreeNode* node = batch; node;)
+		{
+			FreeNode* next = node->next;
+			if (GetHeader(node)->slab->freeCount != m_SlabCapacity)
+			{
+				node->next = nodes;
+				nodes = node;
+				++nodeCount;
+			}
+			node = next;
+		}
+		batch = nextBatch;
+	}
+
+	// Освобождаем полностью свободные слэбы
+	for (Slab** slab = &m_Slabs; *slab;)
+	{
+		Slab* p = *slab;
+		if (p->freeCount == m_SlabCapacity)
+		{
+			*slab = p->next;
+			m_Resource->deallocate(p, m_SlabSize, m_Alignment);
+			m_AllocatedSize.fetch_sub(m_SlabSize, std::memory_order_relaxed);
+		} else
+		{
+			p->freeCount = 0;
+			slab = &p->next;
+		}
+	}
+
+	// Раскладываем оставшиеся блоки по пачкам
+	m_Depot = nullptr;
+	while (nodeCount)
+	{
+		const size_t count = (std::min)(nodeCount, m_BatchSize);
+		FreeNode* first = nodes;
+		for (size_t i = 1; i < count; ++i)
+			nodes = nodes->next;
+
+		FreeNode* last = nodes;
+		nodes = nodes->next;
+		last->next = nullptr;
+
+		PushBatch(first, count);
+		nodeCount -= count;
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SlabPool::LockCache(Cache& cache) noexcept
+{
+	// Кеш используется, как правило, одним потоком, поэтому блокировка почти никогда не ожидает. Но если поток,
+	// захвативший блокировку, был вытеснен, то вместо долгого ожидания отдаём остаток кванта времени системе
+	for (unsigned spinCount = 0; cache.isLocked.exchange(true, std::memory_order_acquire);)
+	{
+		while (cache.isLocked.load(std::memory_order_relaxed))
+		{
+			if (++spinCount < 100)
+				thrd::CPUPause();
+			else
+				thrd::Sleep(0);
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SlabPool::UnlockCache(Cache& cache) noexcept
+{
+	cache.isLocked.store(false, std::memory_order_release);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SlabPool::Cache& SlabPool::GetCache() noexcept
+{
+	return m_Caches[thrd::GetThreadIndex() & m_CacheMask];
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+AML_NOINLINE void SlabPool::Refill(Cache& cache)
+{
+	thrd::Lock lock(m_DepotCS);
+
+	if (!m_Depot)
+		AddSlab();
+
+	FreeNode* batch = m_Depot;
+	m_Depot = batch->nextBatch;
+
+	cache.first = batch;
+	cache.count = batch->batchSize;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SlabPool::Flush(Cache& cache) noexcept
+{
+	const size_t count = (std::min)(cache.count, m_BatchSize);
+
+	FreeNode* first = cache.first;
+	FreeNode* last = first;
+	for (size_t i = 1; i < count; ++i)
+		last = last->next;
+
+	cache.first = last->next;
+	cache.count -= count;
+	last->next = nullptr;
+
+	thrd::Lock lock(m_DepotCS);
+	PushBatch(first, count);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SlabPool::AddSlab()
+{
+	auto slab = static_cast<Slab*>(m_Resource->allocate(m_SlabSize, m_Alignment));
+	slab->next = m_Slabs;
+	slab->freeCount = 0;
+	m_Slabs = slab;
+	m_AllocatedSize.fetch_add(m_SlabSize, std::memory_order_relaxed);
+
+	uint8_t* slot = reinterpret_cast<uint8_t*>(slab) + m_SlabHeaderSize;
+	for (size_t i = 0; i < m_SlabCapacity; i += m_BatchSize)
+	{
+		FreeNode* first = nullptr;
+		for (size_t j = 0; j < m_BatchSize; ++j, slot += m_SlotSize)
+		{
+			reinterpret_cast<SlotHeader*>(slot)->slab = slab;
+			FreeNode* node = GetNode(slot);
+			node->next = first;
+			first = node;
+		}
+		PushBatch(first, m_BatchSize);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SlabPool::PushBatch(FreeNode* first, size_t count) noexcept
+{
+	first->nextBatch = m_Depot;
+	first->batchSize = count;
+	m_Depot = first;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SlabPool::SlotHeader* SlabPool::GetHeader(void* object) const noexcept
+{
+	return reinterpret_cast<SlotHeader*>(static_cast<uint8_t*>(object) - m_HeaderSize);
+}
@@ -0,0 +1,162 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "memory.h"
+#include "platform.h"
+#include "threadsync.h"
+#include "util.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SlabPool - потокобезопасный пул блоков памяти фиксированного размера
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс SlabPool выделяет блоки памяти одного размера из больших участков (слэбов), выделенных в куче. Освобождённые блоки
+// не возвращаются в кучу, а попадают в кеш потока (кеши выбираются по порядковому номеру потока, поэтому потоки, как правило,
+// не конкурируют друг с другом), и из него же выделяются новые блоки. Когда в кеше накапливается слишком много свободных
+// блоков, часть из них целой пачкой передаётся в общее хранилище (депо), откуда пачки забирают кеши, оставшиеся без блоков.
+// Слэбы выделяются через источник памяти (см. GetDefaultResource) и освобождаются только в деструкторе или функцией Trim
+// (если все блоки слэба свободны)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class SlabPool final
+{
+	AML_NONCOPYABLE(SlabPool)
+
+public:
+	// Параметры objectSize и alignment задают размер блоков пула в байтах и их выравнивание (должно быть степенью 2).
+	// Параметр resource задаёт источник памяти для слэбов (если он равен nullptr, то источник по умолчанию)
+	SlabPool(size_t objectSize, size_t alignment = alignof(std::max_align_t), std::pmr::memory_resource* resource = nullptr);
+	// К моменту уничтожения пула все выделенные им блоки должны быть освобождены
+	~SlabPool();
+
+	// Выделяет блок памяти. Если память выделить невозможно, выбрасывает std::bad_alloc
+	void* Allocate();
+	// Освобождает блок памяти ptr, ранее выделенный этим пулом (если ptr равен nullptr, ничего не делает)
+	void Deallocate(void* ptr) noexcept;
+
+	// Возвращает в кучу те слэбы, все блоки которых свободны. Функция просматривает
+	// все свободные блоки пула, поэтому её не стоит вызывать слишком часто
+	void Trim();
+
+	// Возвращает размер блоков пула (в байтах)
+	size_t GetObjectSize() const noexcept { return m_ObjectSize; }
+	// Возвращает общий размер слэбов, выделенных в куче (в байтах)
+	size_t GetAllocatedSize() const noexcept { return m_AllocatedSize.load(std::memory_order_relaxed); }
+
+private:
+	struct Slab;
+	struct FreeNode;
+	struct Cache;
+
+	// Заголовок блока: указатель на слэб, которому принадлежит блок
+	struct SlotHeader {
+		Slab* slab;
+	};
+
+	static void LockCache(Cache& cache) noexcept;
+	static void UnlockCache(Cache& cache) noexcept;
+
+	Cache& GetCache() noexcept;
+
+	// Заполняет пустой кеш пачкой свободных блоков из депо (или из нового слэба)
+	void Refill(Cache& cache);
+	// Передаёт в депо одну пачку блоков из кеша
+	void Flush(Cache& cache) noexcept;
+
+	// Выделяет в куче новый слэб и помещает все его блоки в депо (вызывается под блокировкой депо)
+	void AddSlab();
+	// Добавляет в депо пачку из count блоков (вызывается под блокировкой депо)
+	void PushBatch(FreeNode* first, size_t count) noexcept;
+
+	FreeNode* GetNode(uint8_t* slot) const noexcept { return reinterpret_cast<FreeNode*>(slot + m_HeaderSize); }
+	SlotHeader* GetHeader(void* object) const noexcept;
+
+private:
+	const size_t m_ObjectSize;			// Размер блока (без заголовка)
+	const size_t m_Alignment;			// Выравнивание блоков и их заголовков
+	size_t m_HeaderSize;				// Размер заголовка блока (с учётом выравнивания)
+	size_t m_SlotSize;					// Размер блока вместе с заголовком
+	size_t m_BatchSize;					// Количество блоков в пачке
+	size_t m_SlabCapacity;				// Количество блоков в слэбе
+	size_t m_SlabHeaderSize;			// Размер заголовка слэба (с учётом выравнивания)
+	size_t m_SlabSize;					// Полный размер слэба в байтах
+	std::pmr::memory_resource* m_Resource;	// Источник памяти для слэбов
+
+	Cache* m_Caches = nullptr;			// Массив кешей (количество - степень 2)
+	unsigned m_CacheMask = 0;			// Маска индекса кеша
+
+	thrd::CriticalSection m_DepotCS;	// Блокировка депо и списка слэбов
+	FreeNode* m_Depot = nullptr;		// Стек пачек свободных блоков
+	Slab* m_Slabs = nullptr;			// Список всех слэбов
+
+	std::atomic<size_t> m_AllocatedSize = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   ObjectPool - пул объектов типа T
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Шаблонный класс ObjectPool создаёт объекты типа T в памяти, выделенной пулом SlabPool. Объекты, созданные
+// функцией New, должны быть удалены функцией Delete этого же пула (возможно, в другом потоке)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+class ObjectPool final
+{
+	AML_NONCOPYABLE(ObjectPool)
+
+public:
+	ObjectPool()
+		: m_Pool(sizeof(T), alignof(T))
+	{
+	}
+
+	// Создаёт новый объект, вызывая его конструктор с аргументами args
+	template<class... Args> T* New(Args&&... args)
+	{
+		void* p = m_Pool.Allocate();
+		try {
+			return new(p) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			m_Pool.Deallocate(p);
+			throw;
+		}
+	}
+
+	// Удаляет объект obj, созданный функцией New (если obj равен nullptr, ничего не делает)
+	void Delete(T* obj) noexcept
+	{
+		if (obj)
+		{
+			obj->~T();
+			m_Pool.Deallocate(obj);
+		}
+	}
+
+	// Возвращает в кучу неиспользуемую память (см. SlabPool::Trim)
+	void Trim() { m_Pool.Trim(); }
+
+	SlabPool& GetSlabPool() noexcept { return m_Pool; }
+
+private:
+	SlabPool m_Pool;
+};
+
+} // namespace util
@@ -0,0 +1,298 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "memory.h"
+#include "platform.h"
+#include "util.h"
+
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   RingBufferBase - общая часть кольцевых буферов
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Кольцевой буфер (циклическая очередь) хранит элементы в массиве, ёмкость которого равна степени 2. Новые элементы
+// добавляются в конец очереди, а извлекаются из её начала. Индексы начала и конца очереди только увеличиваются, а
+// позиция элемента в массиве вычисляется наложением маски. Содержимое буфера всегда занимает не более двух непрерывных
+// участков массива (GetReadSpans), что позволяет копировать его функцией memcpy или передавать в функции ввода-вывода
+// без промежуточного буфера. Аналогично, свободное место буфера можно заполнить напрямую (GetWriteSpans и Commit).
+// Буфер может хранить только тривиально копируемые типы
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+class RingBufferBase
+{
+	AML_NONCOPYABLE(RingBufferBase)
+	static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types are allowed");
+
+public:
+	// Непрерывный участок массива буфера
+	struct Span {
+		T* data;
+		size_t size;
+	};
+
+	size_t size() const noexcept { return m_Tail - m_Head; }
+	bool empty() const noexcept { return m_Tail == m_Head; }
+
+	// Возвращает ёмкость буфера (максимальное количество элементов без увеличения массива)
+	size_t GetCapacity() const noexcept { return m_Mask + 1; }
+	// Возвращает true, если в буфере нет свободного места
+	bool IsFull() const noexcept { return size() > m_Mask; }
+
+	// Возвращает элемент с индексом index, считая от начала очереди (0 - самый старый элемент)
+	T& operator [](size_t index) noexcept { return m_Items[(m_Head + index) & m_Mask]; }
+	const T& operator [](size_t index) const noexcept { return m_Items[(m_Head + index) & m_Mask]; }
+
+	T& front() noexcept { return m_Items[m_Head & m_Mask]; }
+	const T& front() const noexcept { return m_Items[m_Head & m_Mask]; }
+	T& back() noexcept { return m_Items[(m_Tail - 1) & m_Mask]; }
+	const T& back() const noexcept { return m_Items[(m_Tail - 1) & m_Mask]; }
+
+	void clear() noexcept { m_Head = m_Tail = 0; }
+
+	void pop_front() noexcept { ++m_Head; }
+	void pop_back() noexcept { --m_Tail; }
+
+	// Добавляет элемент value в конец очереди. Если буфер заполнен, функция вернёт false
+	bool TryPush(const T& value) noexcept
+	{
+		if (IsFull())
+			return false;
+
+		m_Items[m_Tail++ & m_Mask] = value;
+		return true;
+	}
+
+	// Добавляет элемент value в конец очереди. Если буфер заполнен, то самый старый элемент
+	// будет удалён (удобно для "скользящего окна" последних значений)
+	void PushOverwrite(const T& value) noexcept
+	{
+		if (IsFull())
+			++m_Head;
+
+		m_Items[m_Tail++ & m_Mask] = value;
+	}
+
+	// Извлекает элемент из начала очереди в value. Если буфер пуст, функция вернёт false
+	bool TryPop(T& value) noexcept
+	{
+		if (empty())
+			return false;
+
+		value = m_Items[m_Head++ & m_Mask];
+		return true;
+	}
+
+	// Копирует в массив out до count элементов из начала очереди и удаляет их из буфера.
+	// Функция возвращает количество извлечённых элементов (не больше текущего размера)
+	size_t Read(T* out, size_t count) noexcept
+	{
+		count = Peek(out, count);
+		m_Head += count;
+		return count;
+	}
+
+	// Копирует в массив out до count элементов из начала очереди, не удаляя их из буфера
+	size_t Peek(T* out, size_t count) const noexcept
+	{
+		count = (std::min)(count, size());
+		CopyOut(m_Head, out, count);
+		return count;
+	}
+
+	// Удаляет из начала очереди до count элементов
+	void Discard(size_t count) noexcept
+	{
+		m_Head += (std::min)(count, size());
+	}
+
+	// Возвращает участки массива, занятые элементами очереди (в порядке от начала очереди
+	// к её концу). Если элементы занимают непрерывный участок, то второй участок будет пустым
+	std::pair<Span, Span> GetReadSpans() noexcept
+	{
+		const size_t pos = m_Head & m_Mask;
+		const size_t count = size();
+		const size_t first = (std::min)(count, GetCapacity() - pos);
+		return { Span { m_Items + pos, first }, Span { m_Items, count - first } };
+	}
+
+	// Возвращает свободные участки массива (в порядке заполнения). Записав в них элементы,
+	// нужно вызвать функцию Commit, чтобы добавить эти элементы в конец очереди
+	std::pair<Span, Span> GetWriteSpans() noexcept
+	{
+		const size_t pos = m_Tail & m_Mask;
+		const size_t count = GetCapacity() - size();
+		const size_t first = (std::min)(count, GetCapacity() - pos);
+		return { Span { m_Items + pos, first }, Span { m_Items, count - first } };
+	}
+
+	// Добавляет в конец очереди count элементов, записанных в участки, полученные
+	// функцией GetWriteSpans. Значение count не должно превышать размер свободного места
+	void Commit(size_t count) noexcept
+	{
+		m_Tail += count;
+	}
+
+protected:
+	RingBufferBase(T* items, size_t capacity) noexcept
+		: m_Items(items)
+		, m_Mask(capacity - 1)
+	{
+	}
+
+	// Копирует count элементов, начиная с позиции from, в массив out
+	void CopyOut(size_t from, T* out, size_t count) const noexcept
+	{
+		const size_t pos = from & m_Mask;
+		const size_t first = (std::min)(count, GetCapacity() - pos);
+		memcpy(out, m_Items + pos, first * sizeof(T));
+		memcpy(out + first, m_Items, (count - first) * sizeof(T));
+	}
+
+	// Копирует count элементов из массива items в конец очереди (места должно быть достаточно)
+	void CopyIn(const T* items, size_t count) noexcept
+	{
+		const size_t pos = m_Tail & m_Mask;
+		const size_t first = (std::min)(count, GetCapacity() - pos);
+		memcpy(m_Items + pos, items, first * sizeof(T));
+		memcpy(m_Items, items + first, (count - first) * sizeof(T));
+		m_Tail += count;
+	}
+
+protected:
+	T* m_Items;				// Массив элементов
+	size_t m_Mask;			// Маска позиции в массиве (ёмкость минус 1)
+	size_t m_Head = 0;		// Индекс начала очереди
+	size_t m_Tail = 0;		// Индекс конца очереди (следующего за последним элементом)
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   FixedRingBuffer - кольцевой буфер фиксированной ёмкости
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс FixedRingBuffer хранит до capacity элементов (должно быть степенью 2) во внутреннем массиве и никогда не
+// выделяет память в куче. Если буфер заполнен, новые элементы не добавляются (TryPush, Write) либо вытесняют самые
+// старые элементы (PushOverwrite)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T, size_t capacity>
+class FixedRingBuffer final : public RingBufferBase<T>
+{
+	static_assert(capacity && !(capacity & (capacity - 1)), "Capacity must be a power of 2");
+
+public:
+	FixedRingBuffer() noexcept
+		: RingBufferBase<T>(reinterpret_cast<T*>(m_Buffer), capacity)
+	{
+	}
+
+	// Добавляет в конец очереди до count элементов из массива items (столько, сколько
+	// поместится в свободное место буфера). Функция возвращает количество добавленных элементов
+	size_t Write(const T* items, size_t count) noexcept
+	{
+		count = (std::min)(count, capacity - this->size());
+		this->CopyIn(items, count);
+		return count;
+	}
+
+private:
+	alignas(T) uint8_t m_Buffer[capacity * sizeof(T)];
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   RingBuffer - кольцевой буфер с изменяемой ёмкостью
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс RingBuffer хранит элементы в массиве, выделенном в куче (через источник памяти resource). Функции push_back и Write при нехватке места увеличивают
+// ёмкость буфера вдвое, а функции TryPush и PushOverwrite работают так же, как и у буфера фиксированной ёмкости. Когда
+// ёмкость достигла размера, достаточного для обычной нагрузки, буфер больше не выделяет память
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+class RingBuffer final : public RingBufferBase<T>
+{
+public:
+	// Параметр capacity задаёт начальную ёмкость буфера (будет округлена вверх до степени 2). Если
+	// параметр resource равен nullptr, используется источник памяти по умолчанию (см. GetDefaultResource)
+	explicit RingBuffer(size_t capacity = 16, std::pmr::memory_resource* resource = nullptr)
+		: RingBufferBase<T>(nullptr, RoundUpCapacity(capacity))
+		, m_Resource(GetResource(resource))
+	{
+		this->m_Items = AllocArray<T>(this->GetCapacity(), m_Resource);
+	}
+
+	~RingBuffer() noexcept
+	{
+		FreeArray(this->m_Items, this->GetCapacity(), m_Resource);
+	}
+
+	// Добавляет элемент value в конец очереди, увеличивая при необходимости ёмкость буфера
+	void push_back(const T& value)
+	{
+		if (this->IsFull())
+			Reallocate(this->GetCapacity() * 2);
+
+		this->m_Items[this->m_Tail++ & this->m_Mask] = value;
+	}
+
+	// Добавляет в конец очереди count элементов из массива items, увеличивая при необходимости ёмкость буфера
+	void Write(const T* items, size_t count)
+	{
+		Reserve(this->size() + count);
+		this->CopyIn(items, count);
+	}
+
+	// Увеличивает (при необходимости) ёмкость буфера так, чтобы в нём поместилось не менее capacity элементов
+	void Reserve(size_t capacity)
+	{
+		if (capacity > this->GetCapacity())
+			Reallocate(RoundUpCapacity(capacity));
+	}
+
+private:
+	static size_t RoundUpCapacity(size_t capacity)
+	{
+		size_t result = 1;
+		while (result < capacity)
+		{
+			if (result > size_t(-1) / 2)
+				throw std::bad_alloc();
+			result <<= 1;
+		}
+		return result;
+	}
+
+	AML_NOINLINE void Reallocate(size_t newCapacity)
+	{
+		// Копируем элементы в начало нового массива, поэтому после
+		// этого очередь будет занимать один непрерывный участок
+		T* newItems = AllocArray<T>(newCapacity, m_Resource);
+		const size_t count = this->size();
+		this->CopyOut(this->m_Head, newItems, count);
+		FreeArray(this->m_Items, this->GetCapacity(), m_Resource);
+
+		this->m_Items = newItems;
+		this->m_Mask = newCapacity - 1;
+		this->m_Head = 0;
+		this->m_Tail = count;
+	}
+
+private:
+	std::pmr::memory_resource* m_Resource;
+};
+
+} // namespace util
@@ -0,0 +1,64 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "sharded.h"
+
+#include "sysinfo.h"
+
+using namespace thrd;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   ShardedCounter
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+ShardedCounter::ShardedCounter(unsigned shardCount)
+{
+	if (!shardCount)
+		shardCount = util::SystemInfo::Instance().GetCoreCount().logical;
+
+	// Количество ячеек ограничено разумным значением 1024 (64 КБ памяти на счётчик)
+	unsigned count = 1;
+	while (count < shardCount && count < 1024)
+		count <<= 1;
+
+	m_Shards = new Shard[count];
+	m_Mask = count - 1;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+ShardedCounter::~ShardedCounter()
+{
+	delete[] m_Shards;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+int64_t ShardedCounter::Get() const noexcept
+{
+	int64_t result = 0;
+	for (unsigned i = 0; i <= m_Mask; ++i)
+		result += m_Shards[i].value.load(std::memory_order_relaxed);
+
+	return result;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+int64_t ShardedCounter::Exchange() noexcept
+{
+	int64_t result = 0;
+	for (unsigned i = 0; i <= m_Mask; ++i)
+		result += m_Shards[i].value.exchange(0, std::memory_order_relaxed);
+
+	return result;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void ShardedCounter::Reset() noexcept
+{
+	for (unsigned i = 0; i <= m_Mask; ++i)
+		m_Shards[i].value.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,158 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "fasthash.h"
+#include "platform.h"
+#include "thread.h"
+#include "threadsync.h"
+#include "util.h"
+
+#include <atomic>
+#include <new>
+#include <string_view>
+#include <type_traits>
+
+namespace thrd {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   ShardedCounter - счётчик, распределённый по нескольким ячейкам
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс ShardedCounter предназначен для счётчиков (статистики), которые часто изменяются из многих потоков, но читаются
+// редко. Вместо одной атомарной переменной, строка кеша с которой постоянно "кочует" между ядрами CPU, счётчик хранит
+// массив ячеек, каждая из которых занимает отдельную строку кеша. Поток изменяет только "свою" ячейку (выбираемую по
+// порядковому номеру потока), а итоговое значение вычисляется суммированием всех ячеек только в момент чтения
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class ShardedCounter final
+{
+	AML_NONCOPYABLE(ShardedCounter)
+
+public:
+	// Параметр shardCount задаёт количество ячеек счётчика (будет округлено вверх до степени 2). Если он
+	// равен 0, то количество ячеек будет выбрано равным количеству логических процессоров в системе
+	explicit ShardedCounter(unsigned shardCount = 0);
+	~ShardedCounter();
+
+	// Прибавляет к счётчику значение value. Операция атомарна, но не упорядочивает
+	// (memory_order_relaxed) другие обращения к памяти относительно изменения счётчика
+	void Add(int64_t value) noexcept
+	{
+		m_Shards[GetThreadIndex() & m_Mask].value.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	void Increment() noexcept { Add(1); }
+	void Decrement() noexcept { Add(-1); }
+
+	// Возвращает текущее значение счётчика (сумму значений всех ячеек). Если счётчик одновременно
+	// изменяется другими потоками, то результат может не учитывать часть параллельных изменений
+	int64_t Get() const noexcept;
+	// Возвращает текущее значение счётчика и обнуляет его. Каждое
+	// изменение счётчика будет учтено ровно одним вызовом функции
+	int64_t Exchange() noexcept;
+	// Обнуляет счётчик
+	void Reset() noexcept;
+
+	// Возвращает количество ячеек счётчика
+	unsigned GetShardCount() const noexcept { return m_Mask + 1; }
+
+private:
+	struct alignas(AML_CACHE_LINE_SIZE) Shard {
+		std::atomic<int64_t> value = 0;
+	};
+
+	Shard* m_Shards = nullptr;	// Массив ячеек (каждая выровнена по границе строки кеша)
+	unsigned m_Mask = 0;		// Маска индекса ячейки (количество ячеек минус 1)
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   StripedLock - набор критических секций, выбираемых по хешу ключа
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс StripedLock заменяет одну критическую секцию, защищающую большую структуру данных (например, хеш-таблицу),
+// набором из stripeCount секций. Секция выбирается по хешу ключа (GetFastHash), поэтому потоки, работающие с разными
+// ключами, в большинстве случаев не конкурируют друг с другом. Каждая секция занимает отдельную строку кеша CPU.
+// Пример использования: thrd::Lock lock(m_Locks.Get(name));
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<unsigned stripeCount = 16>
+class StripedLock final
+{
+	AML_NONCOPYABLE(StripedLock)
+	static_assert(stripeCount && !(stripeCount & (stripeCount - 1)), "Stripe count must be a power of 2");
+
+	// Ключи, хешируемые по байтовому представлению: целые числа, перечисления и указатели. Указатели на символы
+	// char и wchar_t сюда не относятся, так как это строки, и для них вызываются строковые перегрузки функции Get
+	template<class T, class P = std::remove_cv_t<std::remove_pointer_t<T>>>
+	static constexpr bool IS_RAW_KEY = (std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>) &&
+		!(std::is_pointer_v<T> && (std::is_same_v<P, char> || std::is_same_v<P, wchar_t>));
+
+public:
+	// Параметр spinCount задаёт количество циклов ожидания для каждой из критических секций (см. CriticalSection)
+	explicit StripedLock(unsigned spinCount = 0)
+	{
+		for (auto& stripe : m_Stripes)
+			new(stripe.buffer) CriticalSection(spinCount);
+	}
+
+	~StripedLock()
+	{
+		for (auto& stripe : m_Stripes)
+			stripe.Get().~CriticalSection();
+	}
+
+	// Возвращает критическую секцию для ключа со значением хеша hashValue
+	CriticalSection& GetByHash(unsigned hashValue) noexcept
+	{
+		// Младшие биты хеша FNV-1a для близких ключей распределены хуже старших,
+		// поэтому перед выбором секции "подмешаем" старшие биты хеша к младшим
+		return m_Stripes[(hashValue ^ (hashValue >> 16)) & (stripeCount - 1)].Get();
+	}
+
+	// Возвращает критическую секцию для строкового ключа key
+	CriticalSection& Get(const char* key) noexcept { return GetByHash(hash::GetFastHash(key)); }
+	CriticalSection& Get(const wchar_t* key) noexcept { return GetByHash(hash::GetFastHash(key)); }
+	CriticalSection& Get(std::string_view key) noexcept { return GetByHash(hash::GetFastHash(key)); }
+	CriticalSection& Get(std::wstring_view key) noexcept { return GetByHash(hash::GetFastHash(key)); }
+
+	// Возвращает критическую секцию для ключа key целого, перечислимого или указательного типа (кроме
+	// указателей на строки, см. выше). Хеш вычисляется по байтовому представлению key
+	template<class T>
+	std::enable_if_t<IS_RAW_KEY<T>, CriticalSection&> Get(const T& key) noexcept
+	{
+		return GetByHash(hash::GetFastHash(&key, sizeof(T)));
+	}
+
+	// Захватывает все критические секции (в порядке возрастания их индексов)
+	void EnterAll() noexcept
+	{
+		for (auto& stripe : m_Stripes)
+			stripe.Get().Enter();
+	}
+
+	// Освобождает все критические секции
+	void LeaveAll() noexcept
+	{
+		for (auto& stripe : m_Stripes)
+			stripe.Get().Leave();
+	}
+
+	static constexpr unsigned GetStripeCount() noexcept { return stripeCount; }
+
+private:
+	struct alignas(AML_CACHE_LINE_SIZE) Stripe {
+		alignas(CriticalSection) uint8_t buffer[sizeof(CriticalSection)];
+		CriticalSection& Get() noexcept { return *reinterpret_cast<CriticalSection*>(buffer); }
+	};
+
+	Stripe m_Stripes[stripeCount];
+};
+
+} // namespace thrd
@@ -8,31 +8,180 @@
 #include "datetime.h"
 #include "debug.h"
 #include "log.h"
+#include "strformat.h"
+#include "strutil.h"
 #include "thread.h"
+#include "winapi.h"
+
+#include <system_error>
+#include <thread>
 
 using namespace util;
 
+//--------------------------------------------------------------------------------------------------------------------------------
+struct SingletonHolder::StartupRecord
+{
+	static constexpr size_t NPOS = size_t(-1);
+
+	const char* typeName;	// Имя типа синглтона (результат вызова typeid(T).name())
+	size_t parent;			// Индекс записи синглтона, при создании которого был создан данный (или NPOS)
+	unsigned threadId;		// Идентификатор потока, в котором создавался синглтон
+	uint64_t startTime;		// Время начала создания (мкс)
+	uint64_t totalTime;		// Полное время создания (мкс)
+	uint64_t selfTime;		// Время создания без учёта создания зависимостей (мкс)
+};
+
 thrd::CriticalSection* SingletonHolder::s_Lock;
-volatile bool SingletonHolder::s_IsFinalizing;
-SingletonHolder::Item* SingletonHolder::s_ItemList;
-std::vector<void*>* SingletonHolder::s_ObjStack;
+std::atomic<bool> SingletonHolder::s_IsFinalizing;
+thrd::CriticalSection* SingletonHolder::s_RecordLock;
+std::atomic<SingletonHolder::Item*> SingletonHolder::s_ItemList;
+std::atomic<unsigned> SingletonHolder::s_CreationCount;
+std::vector<SingletonHolder::StartupRecord>* SingletonHolder::s_StartupRecords;
+thread_local SingletonHolder::CreationScope* SingletonHolder::s_TopScope;
+
+//--------------------------------------------------------------------------------------------------------------------------------
+static uint64_t GetTimestamp()
+{
+	#if AML_OS_WINDOWS
+		static const uint64_t frequency = [] {
+			LARGE_INTEGER value;
+			::QueryPerformanceFrequency(&value);
+			return static_cast<uint64_t>(value.QuadPart);
+		}();
+
+		LARGE_INTEGER value;
+		::QueryPerformanceCounter(&value);
+		const auto counter = static_cast<uint64_t>(value.QuadPart);
+		// Переводим значение счётчика в микросекунды, избегая переполнения при умножении
+		return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
+	#else
+		#error Not implemented
+	#endif
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+static void WaitForSpinlock(size_t& spinCounter)
+{
+	// Первые попытки захвата спинлока выполняем в активном цикле ожидания, затем отдаём системе остаток
+	// тайм-слайса нашего потока. Если и это не помогло, значит другой поток выполняет длительную операцию
+	// (например, создание синглтона, читающего файлы), и будем засыпать на 1 мс, чтобы не нагружать CPU
+	if (++spinCounter < 1000)
+		thrd::CPUPause();
+	else
+		thrd::Sleep((spinCounter < 2000) ? 0 : 1);
+}
 
 //--------------------------------------------------------------------------------------------------------------------------------
 void SingletonHolder::KillAll()
 {
 	Initialize();
-	// Так как KillAll может быть вызван любым потоком (включая ситуацию, когда другой поток в это
-	// же время инициализирует какой-либо синглтон), мы должны защитить доступ к списку s_ItemList
+	// Так как KillAll может быть вызван любым потоком, то вызовы KillAll и Destroy сериализуются секцией s_Lock. Список
+	// забираем целиком: функторы синглтонов, созданных другими потоками за это время, останутся в списке до следующего вызова
 	thrd::Lock lock(s_Lock);
 
-	for (Item* p = s_ItemList; p;)
+	for (Item* p = s_ItemList.exchange(nullptr, std::memory_order_acquire); p;)
 	{
 		p->fn();
 		Item* old = p;
 		p = p->next;
 		delete old;
 	}
-	s_ItemList = nullptr;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SingletonHolder::CreateAll(const InitFn* fns, size_t count, bool concurrently)
+{
+	std::vector<std::thread> threads;
+
+	if (concurrently && count > 1)
+	{
+		threads.reserve(count - 1);
+		for (; count > 1; ++fns, --count)
+		{
+			try {
+				threads.emplace_back(*fns);
+			}
+			catch (const std::system_error&)
+			{
+				// Если создать поток не удалось, то вызовем функцию в текущем потоке
+				(*fns)();
+			}
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i)
+		fns[i]();
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+std::wstring SingletonHolder::GetStartupTrace()
+{
+	Initialize();
+	thrd::Lock lock(s_RecordLock);
+
+	if (!s_StartupRecords || s_StartupRecords->empty())
+		return std::wstring();
+
+	const auto records = *s_StartupRecords;
+	lock.Leave();
+
+	// Записи в массиве упорядочены по времени начала создания синглтонов, поэтому зависимости синглтона (в т.ч.
+	// созданные в других потоках) всегда находятся в массиве после него. Выведем записи в виде дерева: сначала
+	// синглтон, затем (рекурсивно) все его зависимости в порядке создания с увеличенным на 1 уровнем отступа
+	std::vector<size_t> depth(records.size());
+	std::vector<size_t> order;
+	order.reserve(records.size());
+
+	std::function<void(size_t, size_t)> addRecord = [&](size_t index, size_t level) {
+		depth[index] = level;
+		order.push_back(index);
+		for (size_t i = index + 1; i < records.size(); ++i)
+		{
+			if (records[i].parent == index)
+				addRecord(i, level + 1);
+		}
+	};
+
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		if (records[i].parent == StartupRecord::NPOS)
+			addRecord(i, 0);
+	}
+
+	Formatter<wchar_t> fmt;
+	fmt << L"Singleton startup trace (start, total and self time in ms):";
+
+	const uint64_t firstStart = records.front().startTime;
+	for (size_t index : order)
+	{
+		const auto& record = records[index];
+		std::string_view typeName = record.typeName;
+		for (std::string_view prefix : { "class ", "struct " })
+		{
+			if (typeName.substr(0, prefix.size()) == prefix)
+				typeName.remove_prefix(prefix.size());
+		}
+
+		fmt << L'\n' << Format(L"%9.3f %9.3f %9.3f  ", (record.startTime - firstStart) / 1000.0,
+			record.totalTime / 1000.0, record.selfTime / 1000.0);
+		fmt << std::wstring(depth[index] * 2, L' ') << FromAnsi(typeName);
+		fmt << L" [thread " << record.threadId << L']';
+	}
+
+	return fmt.ToString();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SingletonHolder::LogStartupTrace()
+{
+	auto trace = GetStartupTrace();
+	if (!trace.empty())
+	{
+		*LogRecordHolder(SystemLog::Instance(), Log::MsgType::Info) << trace;
+	}
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -60,10 +209,11 @@ void SingletonHolder::Initialize()
 		current = 0;
 	}
 
-	static uint8_t data[sizeof(thrd::CriticalSection)];
-	// Инициализируем объект критической секции. Благодаря
-	// placement new, этот объект никогда не будет разрушен
-	s_Lock = new(data) thrd::CriticalSection;
+	alignas(thrd::CriticalSection) static uint8_t data[2][sizeof(thrd::CriticalSection)];
+	// Инициализируем объекты критических секций. Благодаря
+	// placement new, эти объекты никогда не будут разрушены
+	s_Lock = new(data[0]) thrd::CriticalSection;
+	s_RecordLock = new(data[1]) thrd::CriticalSection;
 
 	initLock.store(2, std::memory_order_release);
 }
@@ -71,80 +221,41 @@ void SingletonHolder::Initialize()
 //--------------------------------------------------------------------------------------------------------------------------------
 void SingletonHolder::Finalize()
 {
-	if (!s_IsFinalizing)
+	if (!s_IsFinalizing.exchange(true, std::memory_order_seq_cst))
 	{
-		// Значение s_IsFinalizing равно false и деинициализация только начинается. Так как другой поток сейчас может
-		// выполнять инициализацию синглтона, мы не должны допустить установку флага s_IsFinalizing после захвата
-		// критической секции другим потоком. Перед её захватом убедимся, что она проинициализирована
-		Initialize();
+		// Деинициализация только начинается. Так как другие потоки сейчас могут выполнять создание синглтонов, мы
+		// должны дождаться его окончания. Новые синглтоны после установки флага s_IsFinalizing создаваться уже не
+		// будут (см. CreationScope). Синглтоны, создаваемые текущим потоком (если функция exit была вызвана из
+		// конструктора синглтона), мы не ждём, так как их создание не может завершиться до нашего возврата
+		unsigned ownCount = 0;
+		for (CreationScope* scope = s_TopScope; scope; scope = scope->m_Parent)
+			++ownCount;
 
-		// Захватываем критическую секцию. Пытаясь это сделать, мы дождёмся завершения инициализации
-		// синглтона другим потоком (если секция была им захвачена) и гарантируем, что другой поток
-		// не начнёт инициализацию снова до того, как мы установим флаг
-		thrd::Lock lock(s_Lock);
+		for (size_t spinCounter = 0; s_CreationCount.load(std::memory_order_seq_cst) > ownCount;)
+			WaitForSpinlock(spinCounter);
 
-		s_IsFinalizing = true;
+		Initialize();
+		thrd::Lock lock(s_RecordLock);
+		AML_SAFE_DELETE(s_StartupRecords);
 	}
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 void SingletonHolder::SetKiller(KillerFn fn)
 {
-	// Мы не захватываем здесь критическую секцию, так как вызов этой функции делается только
-	// из функции Singleton::CreateInstance, в которой к этому моменту секция уже захвачена.
-	// Вышенаписанное справедливо и для функций PushObject/PopObject
-
+	// Функция вызывается из Singleton::CreateInstance под спинлоком создаваемого синглтона, поэтому
+	// не захватывает секцию s_Lock (см. комментарий там), а добавляет элемент в список без блокировки
 	if (fn)
 	{
-		Item* p = new Item { fn, s_ItemList };
-		s_ItemList = p;
+		Item* p = new Item { fn, s_ItemList.load(std::memory_order_relaxed) };
+		while (!s_ItemList.compare_exchange_weak(p->next, p, std::memory_order_release, std::memory_order_relaxed));
 	}
 
-	if (static bool didOnce; !didOnce)
-	{
-		// Этот вызов KillAll, добавляемый в очередь atexit, нужен для освобождения памяти, занимаемой списком
-		// s_ItemList, при завершении работы. Все destroyable синглтоны к этому моменту уже будут уничтожены
-		atexit(KillAll);
-		didOnce = true;
-	}
-}
-
-//--------------------------------------------------------------------------------------------------------------------------------
-void SingletonHolder::PushObject(void* objPtr)
-{
-	if (s_ObjStack)
-	{
-		// Проверим, нет ли в стеке указателя на инициализируемый синглтон. Если он там есть, значит имеется рекурсия. Причём,
-		// если этот указатель на вершине стека, значит это внутренняя рекурсия в конструкторе синглтона на самого себя. Если
-		// указатель будет найден не на вершине стека, значит у нас рекурсия между двумя различными синглтонами
-		for (size_t i = 0, size = s_ObjStack->size(); i < size; ++i)
-		{
-			if ((*s_ObjStack)[i] == objPtr)
-			{
-				bool isNotLast = i < size - 1;
-				LogErrorAndAbort(isNotLast ? L"Detected cross-singleton recursion" :
-					L"Detected recursion during singleton initialization");
-			}
-		}
-	} else
-		s_ObjStack = new std::vector<void*>;
-
-	// Поместим новый указатель на вершину стека
-	s_ObjStack->push_back(objPtr);
-}
-
-//--------------------------------------------------------------------------------------------------------------------------------
-void SingletonHolder::PopObject()
-{
-	if (s_ObjStack && !s_ObjStack->empty())
-	{
-		s_ObjStack->pop_back();
-		if (s_ObjStack->empty())
-		{
-			delete s_ObjStack;
-			s_ObjStack = nullptr;
-		}
-	}
+	// Этот вызов KillAll, добавляемый в очередь atexit, нужен для освобождения памяти, занимаемой списком
+	// s_ItemList, при завершении работы. Все destroyable синглтоны к этому моменту уже будут уничтожены.
+	// Инициализация статической переменной потокобезопасна, поэтому вызов atexit будет выполнен один раз
+	static const bool didOnce = (atexit(KillAll), true);
+	(void)didOnce;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -169,3 +280,96 @@ void SingletonHolder::LogErrorAndAbort(std::wstring_view errorMsg)
 	// Аварийно завершаем работу
 	DebugHelper::Abort();
 }
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SingletonHolder::CreationLock
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SingletonHolder::CreationLock::CreationLock(std::atomic<unsigned>& creator, const char* typeName)
+	: m_Creator(creator)
+{
+	const unsigned threadId = thrd::GetThreadId();
+
+	size_t spinCounter = 0;
+	for (unsigned current = 0; !creator.compare_exchange_weak(current, threadId, std::memory_order_acquire); current = 0)
+	{
+		// Если спинлок захвачен текущим потоком, значит имеет место рекурсия. Причём, если на вершине стека создаваемых
+		// синглтонов потока находится тот же синглтон, значит это внутренняя рекурсия в конструкторе синглтона на самого
+		// себя. Если нет, значит у нас рекурсия между двумя различными синглтонами (например, A -> B -> A)
+		if (current == threadId)
+		{
+			const bool isSelf = s_TopScope && !strcmp(s_TopScope->m_TypeName, typeName);
+			LogErrorAndAbort(isSelf ? L"Detected recursion during singleton initialization" :
+				L"Detected cross-singleton recursion");
+		}
+
+		// Синглтон создаётся другим потоком. Дождёмся окончания его создания
+		if (current)
+			WaitForSpinlock(spinCounter);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SingletonHolder::CreationLock::~CreationLock()
+{
+	m_Creator.store(0, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SingletonHolder::CreationScope
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SingletonHolder::CreationScope::CreationScope(const char* typeName)
+	: m_Parent(s_TopScope)
+	, m_TypeName(typeName)
+	, m_RecordIndex(StartupRecord::NPOS)
+	, m_StartTime(0)
+	, m_ChildrenTime(0)
+{
+	// Увеличение счётчика и последующая проверка флага, как и установка флага и последующая проверка счётчика в функции
+	// Finalize, последовательно согласованы. Поэтому либо мы увидим установленный флаг, либо Finalize увидит наш счётчик
+	s_CreationCount.fetch_add(1, std::memory_order_seq_cst);
+	if (s_IsFinalizing.load(std::memory_order_seq_cst))
+	{
+		s_CreationCount.fetch_sub(1, std::memory_order_seq_cst);
+		LogErrorAndAbort(L"Attempt to initialize singleton during finalization");
+	}
+
+	s_TopScope = this;
+	m_StartTime = GetTimestamp();
+
+	thrd::Lock lock(s_RecordLock);
+	if (!s_StartupRecords)
+		s_StartupRecords = new std::vector<StartupRecord>;
+
+	m_RecordIndex = s_StartupRecords->size();
+	const size_t parent = m_Parent ? m_Parent->m_RecordIndex : StartupRecord::NPOS;
+	s_StartupRecords->push_back({ typeName, parent, thrd::GetThreadId(), m_StartTime, 0, 0 });
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+SingletonHolder::CreationScope::~CreationScope()
+{
+	const uint64_t totalTime = GetTimestamp() - m_StartTime;
+	if (m_Parent)
+		m_Parent->m_ChildrenTime += totalTime;
+
+	s_TopScope = m_Parent;
+
+	thrd::Lock lock(s_RecordLock);
+	if (s_StartupRecords && m_RecordIndex < s_StartupRecords->size())
+	{
+		auto& record = (*s_StartupRecords)[m_RecordIndex];
+		record.totalTime = totalTime;
+		record.selfTime = totalTime - m_ChildrenTime;
+	}
+	lock.Leave();
+
+	s_CreationCount.fetch_sub(1, std::memory_order_seq_cst);
+}
@@ -10,8 +10,10 @@
 
 #include <atomic>
 #include <stdlib.h>
+#include <string>
 #include <string_view>
 #include <type_traits>
+#include <typeinfo>
 #include <vector>
 
 namespace util {
@@ -22,51 +24,99 @@ class SingletonHolder
 	AML_NONCOPYABLE(SingletonHolder)
 
 public:
+	using InitFn = void (*)();
+
 	// Уничтожает все "destroyable" синглтоны в порядке, обратном порядку, в котором они создавались, вызывая по очереди
 	// все добавленные в список функторы в порядке обратном порядку их добавления (функцией SetKiller) и очищая список
 	static void KillAll();
 
+	// Вызывает функции fns[0] ... fns[count - 1], каждая из которых должна создавать синглтон (или несколько синглтонов).
+	// Если параметр concurrently равен true, то функции будут вызваны одновременно в разных потоках (последняя из них -
+	// в текущем потоке), и эта функция вернёт управление, когда все они завершатся. См. также функцию CreateSingletons
+	static void CreateAll(const InitFn* fns, size_t count, bool concurrently);
+
+	// Возвращает текстовый отчёт о создании синглтонов: для каждого синглтона указывается время начала его создания
+	// (относительно создания первого синглтона), полное время создания (в т.ч. время создания зависимостей) и время
+	// работы только его конструктора. Синглтоны, созданные в процессе создания другого синглтона (его зависимости),
+	// выводятся под ним с отступом. Если синглтон был создан до вызова функции Instance другим синглтоном, то эта
+	// зависимость в отчёте не отражается. После начала завершения работы программы отчёт будет пустым
+	static std::wstring GetStartupTrace();
+
+	// Выводит отчёт о создании синглтонов (см. функцию GetStartupTrace) в системный журнал
+	static void LogStartupTrace();
+
 protected:
 	using KillerFn = void (*)();
 
 	SingletonHolder() = default;
 
-	// Инициализирует при первом вызове критическую секцию s_Lock
+	// Инициализирует при первом вызове критические секции s_Lock и s_RecordLock
 	static void Initialize();
 
 	// Эта функция должна вызываться при завершении работы (только во время обработки списка atexit)
 	static void Finalize();
 
-	// Добавляет функтор fn в последовательность "уничтожения". Первый вызов
-	// этой функции добавляет вызов KillAll в глобальный список atexit
+	// Добавляет функтор fn в последовательность "уничтожения". Первый вызов этой функции добавляет вызов KillAll
+	// в глобальный список atexit. Функция не захватывает критических секций и может вызываться из любого потока
 	static void SetKiller(KillerFn fn = nullptr);
 
-	// Проверяет, что указатель objPtr отсутствует в стеке, создаёт объект стека s_ObjStack
-	// (при необходимости) и помещает указатель на его вершину. Если такой указатель уже
-	// есть в стеке, то будет вызвана функция LogErrorAndAbort с сообщением об ошибке
-	static void PushObject(void* objPtr);
-
-	// Извлекает указатель с вершины стека. Если при этом стек
-	// становится пустым, то уничтожает и сам объект стека
-	static void PopObject();
-
 	// По возможности выводит сообщение об ошибке errorMsg в системный журнал и консоль отладчика (если их
 	// синглтоны были проинициализированы и ещё не уничтожены) и затем вызывает функцию DebugHelper::Abort
 	[[noreturn]] static void LogErrorAndAbort(std::wstring_view errorMsg);
 
+	// Класс CreationLock захватывает спинлок creator конкретного синглтона на время его создания, записывая в него
+	// идентификатор потока. Если спинлок уже захвачен текущим потоком, значит имеет место рекурсия (синглтон прямо
+	// или косвенно обращается к самому себе из своего конструктора), и будет вызвана функция LogErrorAndAbort
+	class CreationLock final
+	{
+		AML_NONCOPYABLE(CreationLock)
+
+	public:
+		CreationLock(std::atomic<unsigned>& creator, const char* typeName);
+		~CreationLock();
+
+	private:
+		std::atomic<unsigned>& m_Creator;
+	};
+
+	// Класс CreationScope объявляется на время работы конструктора синглтона. Он проверяет, что программа ещё не
+	// завершается, помещает синглтон в стек создаваемых синглтонов текущего потока и замеряет время его создания
+	class CreationScope final
+	{
+		AML_NONCOPYABLE(CreationScope)
+		friend class SingletonHolder;
+		friend class CreationLock;
+
+	public:
+		explicit CreationScope(const char* typeName);
+		~CreationScope();
+
+	private:
+		CreationScope* m_Parent;	// Синглтон, при создании которого создаётся данный (в том же потоке)
+		const char* m_TypeName;		// Имя типа синглтона
+		size_t m_RecordIndex;		// Индекс записи в массиве s_StartupRecords
+		uint64_t m_StartTime;		// Время начала создания синглтона (мкс)
+		uint64_t m_ChildrenTime;	// Суммарное время создания зависимостей синглтона (мкс)
+	};
+
 private:
 	struct Item {
 		KillerFn fn;
 		Item* next;
 	};
 
+	struct StartupRecord;
+
 protected:
 	static thrd::CriticalSection* s_Lock;
-	static volatile bool s_IsFinalizing;
+	static std::atomic<bool> s_IsFinalizing;
 
 private:
-	static Item* s_ItemList;
-	static std::vector<void*>* s_ObjStack;
+	static thrd::CriticalSection* s_RecordLock;
+	static std::atomic<Item*> s_ItemList;
+	static std::atomic<unsigned> s_CreationCount;
+	static std::vector<StartupRecord>* s_StartupRecords;
+	static thread_local CreationScope* s_TopScope;
 };
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -126,9 +176,16 @@ private:
 	static AML_NOINLINE T* CreateInstance()
 	{
 		Initialize();
-		thrd::Lock lock(s_Lock);
 
-		if (T* p = s_This.load(std::memory_order_relaxed))
+		// Каждый синглтон создаётся под своим спинлоком (а не под общей критической секцией s_Lock), поэтому разные
+		// синглтоны могут создаваться одновременно в разных потоках. Пока спинлок захвачен, секция s_Lock не должна
+		// захватываться: её владелец (функция KillAll или Destroy) вызывает OnDestroy, которая может обратиться к Instance
+		// этого же синглтона и ждать освобождения спинлока. Поэтому функтор уничтожения добавляется в список без захвата
+		// секции, а записи о создании синглтонов защищены отдельной секцией s_RecordLock, под которой ничего не ждут.
+		// Рекурсия между синглтонами, обращающимися друг к другу из конструкторов, обнаруживается классом CreationLock
+		CreationLock lock(s_Creator, typeid(T).name());
+
+		if (T* p = s_This.load(std::memory_order_acquire))
 			return p;
 
 		// Если мы находимся в процессе завершения работы приложения (флаг s_IsFinalizing установлен, и сейчас вызываются
@@ -136,27 +193,9 @@ private:
 		// обработки списка atexit. Данная ситуация возникает тогда, когда деструктор какого-либо класса пытается обратиться
 		// к функции Instance синглтона, который уже был уничтожен (или не был проинициализирован). Для решения проблемы
 		// нужно в конструктор этого класса добавить тот же вызов функции Instance, что и в деструкторе. Это приведёт
-		// к тому, что синглтон будет уничтожаться позже класса (т.е. будет всё еще доступен из его деструктора)
-		if (s_IsFinalizing)
-		{
-			LogErrorAndAbort(L"Attempt to initialize singleton during finalization");
-		}
-
-		// Проверим, что синглтон, который мы собираемся проинициализировать, отсутствует в стеке инициализируемых
-		// синглтонов. Если он там всё же есть, значит имеет место рекурсия (т.е. либо 2 синглтона обращаются друг
-		// к другу из своих конструкторов, либо наш синглтон обращается сам к себе, например при инициализации
-		// своего члена данных, который в своём конструкторе обращается к Instance нашего синглтона)
-		PushObject(&s_This);
-
-		// Если мы не завершились с ошибкой при добавлении объекта в стек, значит
-		// всё хорошо. Удалим объект из стека, когда закончим его инициализацию
-		struct Invoke {
-			~Invoke()
-			{
-				PopObject();
-			}
-		} whenDone;
-
+		// к тому, что синглтон будет уничтожаться позже класса (т.е. будет всё еще доступен из его деструктора).
+		// Эту проверку, а также замер времени создания синглтона выполняет объект класса CreationScope
+		CreationScope scope(typeid(T).name());
 		T* instance = Create<true>();
 
 		if (destroyable)
@@ -187,6 +226,23 @@ private:
 
 protected:
 	static inline std::atomic<T*> s_This;
+
+private:
+	// Идентификатор потока, создающего синглтон в данный момент (или 0)
+	static inline std::atomic<unsigned> s_Creator;
 };
 
+//--------------------------------------------------------------------------------------------------------------------------------
+// Создаёт синглтоны перечисленных типов Ts, если они ещё не были созданы. Если параметр concurrently равен true, то каждый из
+// синглтонов будет создаваться в отдельном потоке, что может ускорить запуск программы, если конструкторы синглтонов выполняют
+// долгие операции (например, ввод/вывод). Синглтоны, от которых зависят сразу несколько из Ts, будут созданы только один раз
+template<class... Ts>
+void CreateSingletons(bool concurrently = true)
+{
+	static_assert(sizeof...(Ts) > 0, "At least one singleton type is required");
+
+	const SingletonHolder::InitFn fns[] = { [] { Ts::Instance(); }... };
+	SingletonHolder::CreateAll(fns, sizeof...(Ts), concurrently);
+}
+
 } // namespace util
@@ -0,0 +1,166 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "snapshot.h"
+
+#include "threadsync.h"
+
+using namespace thrd;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Rcu
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+//--------------------------------------------------------------------------------------------------------------------------------
+struct RetiredObject
+{
+	void* ptr;				// Указатель на объект
+	Rcu::Deleter deleter;	// Функция удаления объекта
+	uint64_t epoch;			// Эпоха, начатая при постановке объекта в очередь
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+struct RcuQueue
+{
+	// Размер очереди, при превышении которого функция Retire пытается удалить объекты из очереди
+	static constexpr size_t RECLAIM_THRESHOLD = 64;
+
+	CriticalSection cs { 500 };
+	std::vector<RetiredObject> objects;
+
+	~RcuQueue()
+	{
+		// Объекты, оставшиеся в очереди к моменту завершения
+		// программы, удаляем, не дожидаясь окончания эпох
+		for (auto& object : objects)
+			object.deleter(object.ptr);
+	}
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+RcuQueue& GetQueue()
+{
+	static RcuQueue queue;
+	return queue;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------------------------------------
+struct Rcu::ReaderOwner
+{
+	Reader* reader;
+
+	ReaderOwner()
+	{
+		// Сначала попробуем занять ячейку, освободившуюся после завершения другого потока
+		for (reader = s_Readers.load(std::memory_order_acquire); reader; reader = reader->next)
+		{
+			bool isUsed = false;
+			if (!reader->isUsed.load(std::memory_order_relaxed) &&
+				reader->isUsed.compare_exchange_strong(isUsed, true, std::memory_order_acquire))
+			{
+				return;
+			}
+		}
+
+		reader = new Reader;
+		Reader* head = s_Readers.load(std::memory_order_relaxed);
+		do {
+			reader->next = head;
+		} while (!s_Readers.compare_exchange_weak(head, reader, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	~ReaderOwner()
+	{
+		reader->nesting = 0;
+		reader->epoch.store(0, std::memory_order_relaxed);
+		reader->isUsed.store(false, std::memory_order_release);
+	}
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+Rcu::Reader* Rcu::GetReader() noexcept
+{
+	thread_local ReaderOwner owner;
+	return owner.reader;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+uint64_t Rcu::GetMinReaderEpoch() noexcept
+{
+	uint64_t minEpoch = UINT64_MAX;
+	for (Reader* reader = s_Readers.load(std::memory_order_acquire); reader; reader = reader->next)
+	{
+		const uint64_t epoch = reader->epoch.load(std::memory_order_seq_cst);
+		if (epoch && epoch < minEpoch)
+			minEpoch = epoch;
+	}
+
+	return minEpoch;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Rcu::Retire(void* ptr, Deleter deleter)
+{
+	if (!ptr)
+		return;
+
+	// Начинаем новую эпоху. Читатели, начавшие чтение в ней или позже, уже не смогут получить указатель
+	// ptr, а значит объект можно будет удалить после окончания всех секций чтения более ранних эпох
+	const uint64_t epoch = s_Epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+	RcuQueue& queue = GetQueue();
+	Lock lock(queue.cs);
+	queue.objects.push_back({ ptr, deleter, epoch });
+	const bool needReclaim = queue.objects.size() >= RcuQueue::RECLAIM_THRESHOLD;
+	lock.Leave();
+
+	if (needReclaim)
+		Reclaim();
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Rcu::Reclaim()
+{
+	RcuQueue& queue = GetQueue();
+	Lock lock(queue.cs);
+
+	// Объекты в очереди упорядочены по возрастанию эпох, поэтому удалить можно только объекты в начале
+	// очереди. Объект можно удалить, если эпоха его постановки в очередь не позже самой ранней эпохи
+	// среди начатых секций чтения: такие секции начались уже после замены указателя на объект
+	const uint64_t minEpoch = GetMinReaderEpoch();
+	auto last = std::find_if(queue.objects.begin(), queue.objects.end(),
+		[minEpoch](const RetiredObject& object) { return object.epoch > minEpoch; });
+
+	// Функции удаления будем вызывать после освобождения критической секции, так как
+	// деструкторы объектов могут сами вызывать функции Retire или Reclaim (в т.ч. косвенно)
+	std::vector<RetiredObject> objects(queue.objects.begin(), last);
+	queue.objects.erase(queue.objects.begin(), last);
+	lock.Leave();
+
+	for (auto& object : objects)
+		object.deleter(object.ptr);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void Rcu::Synchronize()
+{
+	// Ожидаем окончания всех секций чтения, начатых до текущей эпохи
+	const uint64_t epoch = s_Epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+	for (unsigned i = 1; GetMinReaderEpoch() < epoch; ++i)
+	{
+		if (i % 64)
+			CPUPause();
+		else
+			Sleep(0);
+	}
+
+	Reclaim();
+}
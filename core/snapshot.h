@@ -0,0 +1,280 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "platform.h"
+#include "thread.h"
+#include "util.h"
+
+#include <atomic>
+#include <memory>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+namespace thrd {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SeqLock - защита небольших POD-данных, которые часто читаются и редко изменяются
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Шаблонный класс SeqLock хранит значение типа T (небольшую тривиально копируемую структуру) и позволяет читать его из
+// многих потоков без каких-либо записей в общую память. Читатель копирует значение и проверяет, что счётчик версий не
+// изменился за время копирования (в противном случае копирование повторяется). Писатели изменяют счётчик версий дважды:
+// до записи нового значения (счётчик становится нечётным) и после. Одновременно может работать только один писатель
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+class SeqLock final
+{
+	AML_NONCOPYABLE(SeqLock)
+	static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types are allowed");
+	static_assert(std::is_default_constructible_v<T>, "Type must be default constructible");
+
+public:
+	explicit SeqLock(const T& value = T()) noexcept
+	{
+		StoreWords(value);
+	}
+
+	// Возвращает копию текущего значения. Если в момент чтения значение изменяется
+	// писателем, то функция дождётся окончания записи и повторит чтение
+	T Load() const noexcept
+	{
+		T result;
+		while (!TryLoad(result))
+			CPUPause();
+
+		return result;
+	}
+
+	// Выполняет одну попытку чтения значения. Если попытка оказалась удачной, то функция скопирует значение в out
+	// и вернёт true. Если в этот момент значение изменялось писателем, функция вернёт false (out не изменится)
+	bool TryLoad(T& out) const noexcept
+	{
+		const unsigned sequence = m_Sequence.load(std::memory_order_acquire);
+		if (sequence & 1)
+			return false;
+
+		size_t words[WORD_COUNT];
+		for (size_t i = 0; i < WORD_COUNT; ++i)
+			words[i] = m_Words[i].load(std::memory_order_relaxed);
+
+		// Барьер не позволит процессору (и компилятору) выполнить повторное
+		// чтение счётчика версий раньше чтения самих данных из массива m_Words
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_Sequence.load(std::memory_order_relaxed) != sequence)
+			return false;
+
+		memcpy(&out, words, sizeof(T));
+		return true;
+	}
+
+	// Записывает новое значение. Если одновременно с этим значение записывается другим
+	// потоком, то функция дождётся окончания его записи и только после этого выполнит свою
+	void Store(const T& value) noexcept
+	{
+		unsigned sequence = m_Sequence.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			if (!(sequence & 1) && m_Sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire))
+				break;
+
+			CPUPause();
+			sequence = m_Sequence.load(std::memory_order_relaxed);
+		}
+
+		// Барьер не позволит записать данные раньше, чем читатели увидят нечётное значение счётчика версий
+		std::atomic_thread_fence(std::memory_order_release);
+		StoreWords(value);
+		m_Sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	// Возвращает текущее значение счётчика версий. Каждая запись увеличивает счётчик на 2
+	unsigned GetVersion() const noexcept { return m_Sequence.load(std::memory_order_acquire); }
+
+private:
+	static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(size_t) - 1) / sizeof(size_t);
+
+	void StoreWords(const T& value) noexcept
+	{
+		size_t words[WORD_COUNT] = {};
+		memcpy(words, &value, sizeof(T));
+		for (size_t i = 0; i < WORD_COUNT; ++i)
+			m_Words[i].store(words[i], std::memory_order_relaxed);
+	}
+
+private:
+	// Значение хранится в массиве атомарных слов, так как одновременные чтение и запись обычной
+	// (неатомарной) памяти разными потоками с точки зрения стандарта C++ являются гонкой данных
+	alignas(AML_CACHE_LINE_SIZE) std::atomic<unsigned> m_Sequence = 0;
+	std::atomic<size_t> m_Words[WORD_COUNT];
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Rcu - отложенное освобождение объектов, которые могут использоваться читателями (в стиле RCU)
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс Rcu реализует схему Read-Copy-Update на основе эпох. Читатель в начале чтения сохраняет текущую эпоху в своей
+// (принадлежащей только его потоку) ячейке, а по окончании обнуляет её. Писатель, заменив указатель на объект новым,
+// передаёт старый объект функции Retire, которая начинает новую эпоху. Объект будет удалён только после того, как все
+// читатели, начавшие чтение в более ранних эпохах, его закончат. Функции чтения не захватывают никаких блокировок и
+// не ожидают других потоков. Эпохи общие для всего процесса и не связаны с конкретными объектами
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class Rcu final
+{
+	struct Reader;
+
+public:
+	using Deleter = void (*)(void*);
+
+	// Класс ReadGuard объявляет критическую секцию чтения: пока объект существует, никакой объект, переданный
+	// функции Retire после начала секции, не будет удалён. Секции чтения могут быть вложенными
+	class ReadGuard final
+	{
+		AML_NONCOPYABLE(ReadGuard)
+
+	public:
+		ReadGuard() noexcept
+			: m_Reader(Rcu::GetReader())
+		{
+			if (!m_Reader->nesting++)
+			{
+				// Загрузка эпохи с семантикой acquire гарантирует, что если мы увидим эпоху, начатую функцией Retire,
+				// то увидим и новое значение указателя, записанное до её вызова. Запись эпохи в нашу ячейку должна
+				// быть последовательно согласованной: она не может быть переставлена с последующим чтением указателя
+				const uint64_t epoch = s_Epoch.load(std::memory_order_acquire);
+				m_Reader->epoch.store(epoch, std::memory_order_seq_cst);
+			}
+		}
+
+		~ReadGuard() noexcept
+		{
+			if (!--m_Reader->nesting)
+				m_Reader->epoch.store(0, std::memory_order_release);
+		}
+
+	private:
+		Reader* m_Reader;
+	};
+
+	// Ставит объект ptr в очередь на удаление. Функция deleter будет вызвана для ptr после окончания всех
+	// секций чтения, начатых до вызова Retire. К моменту вызова этой функции объект ptr должен быть уже
+	// недоступен для новых читателей (например, указатель на него должен быть заменён другим)
+	static void Retire(void* ptr, Deleter deleter);
+
+	// Удаляет те объекты из очереди, которые уже не могут использоваться читателями. Функция вызывается
+	// автоматически из Retire, когда размер очереди превышает некоторый порог, но её можно вызвать и явно
+	static void Reclaim();
+
+	// Дожидается окончания всех секций чтения, начатых до вызова функции, и удаляет все объекты из
+	// очереди. Функцию нельзя вызывать внутри секции чтения (это приведёт к вечному ожиданию)
+	static void Synchronize();
+
+private:
+	struct alignas(AML_CACHE_LINE_SIZE) Reader
+	{
+		std::atomic<uint64_t> epoch = 0;	// Эпоха начала текущей секции чтения (0, если чтения нет)
+		unsigned nesting = 0;				// Уровень вложенности секций чтения (изменяется только владельцем)
+		std::atomic<bool> isUsed = true;	// true, если ячейка принадлежит какому-либо потоку
+		Reader* next = nullptr;				// Следующая ячейка в списке всех ячеек
+	};
+
+	// Владелец ячейки читателя (объект, локальный для потока)
+	struct ReaderOwner;
+
+	// Возвращает ячейку читателя, принадлежащую текущему потоку (при первом вызове в потоке ячейка будет выделена)
+	static Reader* GetReader() noexcept;
+	// Возвращает самую раннюю эпоху среди начатых секций чтения (или UINT64_MAX, если таких секций нет)
+	static uint64_t GetMinReaderEpoch() noexcept;
+
+	// Номер текущей эпохи. Значение 0 в ячейке читателя означает отсутствие чтения, поэтому отсчёт эпох начинается с 1
+	static inline std::atomic<uint64_t> s_Epoch = 1;
+	// Односвязный список всех ячеек читателей. Ячейки никогда не удаляются: после завершения
+	// потока его ячейка помечается как свободная и может быть использована другим потоком
+	static inline std::atomic<Reader*> s_Readers = nullptr;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   AtomicSnapshot - указатель на неизменяемый объект, публикуемый писателем и читаемый без блокировок
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Шаблонный класс AtomicSnapshot предназначен для больших объектов, которые читаются очень часто, а заменяются редко
+// (например, конфигурация приложения). Писатель создаёт новую версию объекта и публикует её функцией Publish, а старая
+// версия удаляется после того, как её перестанут использовать все читатели (см. класс Rcu). Читатель получает объект
+// ReadPtr, который гарантирует, что версия объекта, на которую он указывает, не будет удалена, пока ReadPtr существует
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+class AtomicSnapshot final
+{
+	AML_NONCOPYABLE(AtomicSnapshot)
+
+public:
+	class ReadPtr final
+	{
+		AML_NONCOPYABLE(ReadPtr)
+
+	public:
+		explicit ReadPtr(const AtomicSnapshot& snapshot) noexcept
+			: m_Ptr(snapshot.m_Ptr.load(std::memory_order_seq_cst))
+		{
+		}
+
+		const T* get() const noexcept { return m_Ptr; }
+		const T* operator ->() const noexcept { return m_Ptr; }
+		const T& operator *() const noexcept { return *m_Ptr; }
+		explicit operator bool() const noexcept { return m_Ptr != nullptr; }
+
+	private:
+		Rcu::ReadGuard m_Guard;		// Должен быть объявлен (и, значит, проинициализирован) до указателя
+		const T* m_Ptr;
+	};
+
+	AtomicSnapshot() noexcept = default;
+	explicit AtomicSnapshot(std::unique_ptr<T> value) noexcept
+		: m_Ptr(value.release())
+	{
+	}
+
+	// К моменту уничтожения объекта не должно быть читателей, использующих текущую версию
+	~AtomicSnapshot()
+	{
+		delete m_Ptr.load(std::memory_order_relaxed);
+	}
+
+	// Возвращает объект для чтения текущей версии. Пока объект ReadPtr существует, версия не будет удалена.
+	// Чтение обходится в несколько обращений к памяти и никогда не ожидает других потоков (wait-free)
+	ReadPtr Read() const noexcept
+	{
+		return ReadPtr(*this);
+	}
+
+	// Публикует новую версию объекта. Новые читатели сразу будут получать её, а предыдущая
+	// версия будет удалена после окончания чтения всеми читателями, которые её используют
+	void Publish(std::unique_ptr<T> value)
+	{
+		if (T* oldValue = m_Ptr.exchange(value.release(), std::memory_order_seq_cst))
+			Rcu::Retire(oldValue, [](void* p) { delete static_cast<T*>(p); });
+	}
+
+	// Создаёт новую версию объекта из аргументов args и публикует её
+	template<class... Args> void Emplace(Args&&... args)
+	{
+		Publish(std::make_unique<T>(std::forward<Args>(args)...));
+	}
+
+private:
+	std::atomic<T*> m_Ptr = nullptr;
+};
+
+} // namespace thrd
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "memory.h"
 #include "platform.h"
 
 #include <string>
@@ -126,7 +127,9 @@ using WZStringView = BasicZStringView<wchar_t>;
 // Класс ZExStringView имеет внутренний буфер небольшого размера (задаётся параметром ssoSize шаблона), в который может быть
 // помещена строка при инициализации из std::[w]string_view или пары <указатель, длина>. Если размер этой строки больше или
 // равен ssoSize символов, то в куче выделяется массив нужной длины и строка копируется в него. При инициализации из указателя
-// или строки std::[w]string буфер не используется (в этом случае поведение ZExStringView не отличается от BasicZStringView)
+// или строки std::[w]string буфер не используется (в этом случае поведение ZExStringView не отличается от BasicZStringView).
+// Массив выделяется функцией AllocBlock из источника памяти по умолчанию (см. GetDefaultResource): источник хранится в
+// заголовке массива, а не в объекте, поэтому размер вью не увеличивается
 
 //--------------------------------------------------------------------------------------------------------------------------------
 template<class CharT, size_t ssoSize = 16>
@@ -219,7 +222,7 @@ public:
 				m_Buffer = nullptr;
 			}
 			if (Base::m_Size >= ssoSize && oldBuffer)
-				delete[] oldBuffer;
+				FreeBlock(oldBuffer);
 			Base::m_Size = that.m_Size;
 		}
 
@@ -262,7 +265,7 @@ public:
 		const size_type newSize = str.size();
 		Base::m_Data = InitCopy(str.data(), newSize);
 		if (Base::m_Size >= ssoSize && oldBuffer)
-			delete[] oldBuffer;
+			FreeBlock(oldBuffer);
 		Base::m_Size = newSize;
 
 		return *this;
@@ -284,7 +287,7 @@ protected:
 	void Tidy() noexcept
 	{
 		if (Base::m_Size >= ssoSize && m_Buffer)
-			delete[] m_Buffer;
+			FreeBlock(m_Buffer);
 	}
 
 	AML_NOINLINE const_pointer InitCopy(const_pointer str, size_type count)
@@ -292,7 +295,9 @@ protected:
 		CharT* out = m_Inner;
 		if (count >= ssoSize)
 		{
-			out = new CharT[count + 1];
+			if (count >= size_t(-1) / sizeof(CharT))
+				throw std::bad_alloc();
+			out = static_cast<CharT*>(AllocBlock((count + 1) * sizeof(CharT)));
 			m_Buffer = out;
 		}
 		memcpy(out, str, count * sizeof(CharT));
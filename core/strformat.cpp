@@ -6,6 +6,7 @@
 #include "strformat.h"
 
 #include "array.h"
+#include "sysinfo.h"
 
 namespace util {
 
@@ -299,4 +300,37 @@ AML_NOINLINE bool FormatEx(const wchar_t* format, va_list args, const std::funct
 	return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   NumberChars
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t NumberChars::PutFloat(char* buffer, size_t size, double value, char type, int precision) noexcept
+{
+	#if AML_FLOAT_TO_CHARS
+		const auto fmt = (type == 'f') ? std::chars_format::fixed :
+			(type == 'e') ? std::chars_format::scientific : std::chars_format::general;
+
+		const auto result = std::to_chars(buffer, buffer + size, value, fmt, precision);
+		return (result.ec == std::errc()) ? result.ptr - buffer : 0;
+	#else
+		const char format[] = { '%', '.', '*', type, 0 };
+		const int count = FormatEx(buffer, size, format, precision, value);
+		if (count <= 0)
+			return 0;
+
+		// Если в качестве разделителя целой и дробной частей числа используется не точка (возможно
+		// только при установленной локали программы), то найдём и заменим этот символ на точку '.'
+		if (const char dp = SystemInfo::Instance().GetDecimalPoint(); dp != '.')
+		{
+			if (auto p = std::find(buffer, buffer + count, dp); p != buffer + count)
+				*p = '.';
+		}
+
+		return count;
+	#endif
+}
+
 } // namespace util
@@ -7,9 +7,9 @@
 #include "platform.h"
 #include "strcommon.h"
 #include "strutil.h"
-#include "sysinfo.h"
 #include "util.h"
 
+#include <charconv>
 #include <functional>
 #include <math.h>
 #include <stdarg.h>
@@ -50,22 +50,158 @@ int FormatEx(wchar_t* buffer, size_t bufferSize, const wchar_t* format, ...);
 bool FormatEx(const char* format, va_list args, const std::function<void(ZStringView)>& cb);
 bool FormatEx(const wchar_t* format, va_list args, const std::function<void(WZStringView)>& cb);
 
+// Функция std::to_chars с заданной точностью для чисел с плавающей запятой полностью поддерживается, начиная с VS 2019
+// версии 16.2. Если макрос AML_FLOAT_TO_CHARS равен 0, то функция NumberChars::PutFloat использует функцию FormatEx
+#if defined(__cpp_lib_to_chars)
+	#define AML_FLOAT_TO_CHARS 1
+#else
+	#define AML_FLOAT_TO_CHARS 0
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   NumberChars - запись чисел в буфер символов
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс NumberChars содержит функции, общие для классов и функций форматирования. Функции Put* записывают символы
+// числа в буфер справа налево (перед позицией end) и возвращают указатель на первый символ. Размер буфера должен
+// быть достаточным для любого значения типа: 10 символов для uint32_t и 20 (или 64 для двоичной записи) для uint64_t
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class NumberChars
+{
+public:
+	// Записывает десятичные цифры числа value (по 2 цифры за шаг)
+	template<class CharT>
+	static CharT* PutDecimal(CharT* end, uint32_t value) noexcept
+	{
+		CharT* p = end;
+		for (; value >= 100; value /= 100)
+		{
+			const size_t i = (value % 100) * 2;
+			*(--p) = DIGIT_PAIRS[i + 1];
+			*(--p) = DIGIT_PAIRS[i];
+		}
+
+		if (value >= 10)
+		{
+			*(--p) = DIGIT_PAIRS[value * 2 + 1];
+			*(--p) = DIGIT_PAIRS[value * 2];
+		} else
+			*(--p) = static_cast<CharT>('0' + value);
+
+		return p;
+	}
+
+	// Записывает десятичные цифры числа value (по 2 цифры за шаг)
+	template<class CharT>
+	static CharT* PutDecimal(CharT* end, uint64_t value) noexcept
+	{
+		CharT* p = end;
+		#if AML_64BIT
+			for (; value >= 100; value /= 100)
+			{
+				const size_t i = static_cast<size_t>(value % 100) * 2;
+				*(--p) = DIGIT_PAIRS[i + 1];
+				*(--p) = DIGIT_PAIRS[i];
+			}
+
+			return PutDecimal(p, static_cast<uint32_t>(value));
+		#else
+			// В 32-битном коде 64-битное деление медленное, поэтому число делится на части по 9 цифр,
+			// каждая из которых (кроме старшей) выводится 32-битным кодом и дополняется нолями слева
+			while (value >> 32)
+			{
+				const uint64_t hi = value / 1000000000;
+				CharT* const required = p - 9;
+				p = PutDecimal(p, static_cast<uint32_t>(value - hi * 1000000000));
+				while (p > required)
+					*(--p) = '0';
+				value = hi;
+			}
+
+			return PutDecimal(p, static_cast<uint32_t>(value));
+		#endif
+	}
+
+	// Записывает цифры числа value в системе счисления с основанием 2^bits (2, 8 или 16). Если параметр
+	// upper равен true, то шестнадцатеричные цифры больше 9 записываются в верхнем регистре
+	template<unsigned bits, class CharT>
+	static CharT* PutPow2(CharT* end, uint64_t value, bool upper = false) noexcept
+	{
+		static_assert(bits >= 1 && bits <= 4, "Unsupported radix");
+
+		const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+		CharT* p = end;
+		do {
+			*(--p) = digits[value & ((1 << bits) - 1)];
+			value >>= bits;
+		} while (value);
+
+		return p;
+	}
+
+	// Записывает в буфер buffer размером size символов число value с плавающей запятой в формате type ('f', 'e' или 'g',
+	// как у функции printf) с precision знаками после запятой (для формата 'g' - значащими знаками). Разделителем целой
+	// и дробной частей всегда является точка. Возвращает количество записанных символов или 0, если буфер мал
+	static size_t PutFloat(char* buffer, size_t size, double value, char type, int precision) noexcept;
+
+	// Удаляет ноли справа в дробной части числа (кроме первого ноля после точки)
+	// в строке buffer длиной count символов и возвращает новую длину строки
+	static size_t TrimFractionZeros(char* buffer, size_t count) noexcept
+	{
+		char* const end = buffer + count;
+		char* p = std::find(buffer, end, '.');
+		if (p == end || end - p < 2)
+			return count;
+
+		char* const first = p + 2;
+		char* last = first;
+		while (last < end && *last >= '0' && *last <= '9')
+			++last;
+
+		for (p = last; p > first && p[-1] == '0'; --p);
+		if (p == last)
+			return count;
+
+		const size_t zeros = last - p;
+		memmove(p, last, end - last);
+		return count - zeros;
+	}
+
+protected:
+	// Таблица пар десятичных цифр от "00" до "99"
+	static constexpr char DIGIT_PAIRS[] =
+		"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+		"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+};
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //   Formatter - форматирование в строку
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Класс RoundTripFloat - обёртка для числа с плавающей запятой (создаётся функцией RoundTrip). Класс Formatter выводит
+// такое число в кратчайшем виде, при чтении которого (например, функцией strtod) получается в точности то же значение
+template<class T>
+struct RoundTripFloat
+{
+	static_assert(std::is_floating_point_v<T>, "T must be a floating point type");
+	T value;
+};
+
+template<class T>
+constexpr RoundTripFloat<T> RoundTrip(T value) noexcept { return { value }; }
+
 //--------------------------------------------------------------------------------------------------------------------------------
 template<class CharT, size_t innerBuf = 640>
 class Formatter : public StringWriter<CharT, innerBuf>
 {
 public:
-	Formatter()
-	{
-		auto& sysInfo = SystemInfo::Instance();
-		m_DecimalPoint = sysInfo.GetDecimalPoint();
-	}
+	using StringWriter<CharT, innerBuf>::StringWriter;
 
 	// Выводит "true" или "false" в соответствии со значением value. Этот оператор объявлен как шаблонная
 	// функция, так как не должен иметь приоритет над другими операторами <<, принимающими строковые типы
@@ -82,93 +218,50 @@ public:
 
 	Formatter& operator <<(int32_t value)
 	{
-		uint32_t v;
-		if (value >= 0)
-			v = value;
-		else
-		{
-			this->Append('-');
-			v = -value;
-		}
+		CharT buffer[11];
+		CharT* const end = buffer + CountOf(buffer);
 
-		return *this << v;
+		const uint32_t v = static_cast<uint32_t>(value);
+		CharT* p = NumberChars::PutDecimal(end, (value >= 0) ? v : 0 - v);
+		if (value < 0)
+			*(--p) = '-';
+
+		this->Append(p, end - p);
+		return *this;
 	}
 
 	Formatter& operator <<(uint32_t value)
 	{
 		CharT buffer[10];
-		CharT* p = buffer + CountOf(buffer);
+		CharT* const end = buffer + CountOf(buffer);
 
-		size_t n, count = 0;
-		do {
-			n = value;
-			value /= 10;
-			*(--p) = '0' + static_cast<char>(n - 10 * value);
-			++count;
-		} while (value);
+		const CharT* p = NumberChars::PutDecimal(end, value);
+		this->Append(p, end - p);
 
-		this->Append(p, count);
 		return *this;
 	}
 
 	Formatter& operator <<(int64_t value)
 	{
-		uint64_t v;
-		if (value >= 0)
-			v = value;
-		else
-		{
-			this->Append('-');
-			v = -value;
-		}
+		CharT buffer[20];
+		CharT* const end = buffer + CountOf(buffer);
+
+		const uint64_t v = static_cast<uint64_t>(value);
+		CharT* p = NumberChars::PutDecimal(end, (value >= 0) ? v : 0 - v);
+		if (value < 0)
+			*(--p) = '-';
 
-		return *this << v;
+		this->Append(p, end - p);
+		return *this;
 	}
 
 	Formatter& operator <<(uint64_t value)
 	{
 		CharT buffer[20];
-		CharT* p = buffer + CountOf(buffer);
-
-		#if AML_64BIT
-			size_t n;
-			do {
-				n = value;
-				value /= 10;
-				*(--p) = '0' + static_cast<char>(n - 10 * value);
-			} while (value);
-		#else
-			for (auto required = p;;)
-			{
-				size_t n, low;
-				if (value >> 32)
-				{
-					required -= 9;
-					uint64_t hi = value / 1000000000;
-					low = static_cast<uint32_t>(value - hi * 1000000000);
-					value = hi;
-				} else
-				{
-					low = static_cast<uint32_t>(value);
-					value = 0;
-				}
-
-				do {
-					n = low;
-					low /= 10;
-					*(--p) = '0' + static_cast<char>(n - 10 * low);
-				} while (low);
-
-				if (!value)
-					break;
+		CharT* const end = buffer + CountOf(buffer);
 
-				while (p > required)
-					*(--p) = '0';
-			}
-		#endif
-
-		auto count = buffer + CountOf(buffer) - p;
-		this->Append(p, count);
+		const CharT* p = NumberChars::PutDecimal(end, value);
+		this->Append(p, end - p);
 
 		return *this;
 	}
@@ -179,61 +272,26 @@ public:
 	// и дробной частей числа независимо от установленной локали всегда является символ точка
 	Formatter& operator <<(double value)
 	{
-		char buffer[16];
-		// TODO: в С++17 появилась функция std::to_chars, работающая в разы быстрее функции FormatEx для чисел с плавающей
-		// запятой. Но мы пока не можем её использовать. Проблема в том, что в VS 2017 эта функция реализована частично: без
-		// возможности округления до заданного количества знаков (полная поддержка есть в VS 2019, начиная с версии 16.2)
-		/*if (auto result = std::to_chars(buffer, buffer + CountOf(buffer), value, (fabs(value) < 999999.9999995) ?
-			std::chars_format::fixed : std::chars_format::scientific, 6); result.ec == std::errc())
-		{
-			auto count = result.ptr - buffer;
-			buffer[count] = 0;*/
-
-		const char* fmt = (fabs(value) < 999999.9999995) ? "%.6f" : "%.6e";
-		if (int count = FormatEx(buffer, CountOf(buffer), fmt, value); count > 0)
+		char buffer[32];
+		const char type = (fabs(value) < 999999.9999995) ? 'f' : 'e';
+		if (size_t count = NumberChars::PutFloat(buffer, CountOf(buffer), value, type, 6))
 		{
-			// Если в качестве разделителя целой и дробной частей числа используется не точка (возможно
-			// только при установленной локали программы), то найдём и заменим этот символ на точку '.'
-			if (const char dp = m_DecimalPoint; dp != '.')
-			{
-				for (auto p = buffer; *p; ++p)
-				{
-					if (*p == dp)
-					{
-						*p = '.';
-						break;
-					}
-				}
-			}
+			count = NumberChars::TrimFractionZeros(buffer, count);
+			AppendAscii(buffer, count);
+		}
 
-			// Удалим ноли справа в дробной части (кроме первого ноля после точки)
-			for (auto p = buffer; *p; ++p)
-			{
-				if (*p == '.')
-				{
-					int z = 0;
-					for (p += 2; *p >= '0' && *p <= '9'; ++p)
-						z = (*p == '0') ? z + 1 : 0;
-					if (z)
-					{
-						count -= z;
-						for (p -= z; p[z]; ++p)
-							*p = p[z];
-					}
-					break;
-				}
-			}
+		return *this;
+	}
 
-			if constexpr (std::is_same_v<CharT, char>)
-				this->Append(buffer, count);
-			else
-			{
-				CharT wbuf[CountOf(buffer)];
-				for (int i = 0; i < count; ++i)
-					wbuf[i] = buffer[i];
-				this->Append(wbuf, count);
-			}
-		}
+	// Выводит число value в кратчайшем виде, при чтении которого получается в точности то же значение (без заданной
+	// точности функция std::to_chars есть, начиная с VS 2017 версии 15.9). Экспонента используется, только если с ней
+	// запись короче. Разделителем целой и дробной частей числа всегда является символ точка
+	template<class T>
+	Formatter& operator <<(RoundTripFloat<T> value)
+	{
+		char buffer[32];
+		if (const auto result = std::to_chars(buffer, buffer + CountOf(buffer), value.value); result.ec == std::errc())
+			AppendAscii(buffer, result.ptr - buffer);
 
 		return *this;
 	}
@@ -283,7 +341,19 @@ public:
 	}
 
 protected:
-	char m_DecimalPoint;
+	// Выводит строку str длиной count символов, состоящую только из символов ASCII
+	void AppendAscii(const char* str, size_t count)
+	{
+		if constexpr (std::is_same_v<CharT, char>)
+			this->Append(str, count);
+		else
+		{
+			CharT wbuf[32];
+			for (size_t i = 0; i < count; ++i)
+				wbuf[i] = str[i];
+			this->Append(wbuf, count);
+		}
+	}
 };
 
 } // namespace util
@@ -0,0 +1,286 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "strsearch.h"
+
+#include "util.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if AML_SSE2
+	#include <emmintrin.h>
+#endif
+#if AML_AVX2
+	#include <immintrin.h>
+#endif
+
+using namespace util;
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<bool ignoreCase, class CharT>
+static inline std::make_unsigned_t<CharT> Fold(CharT c) noexcept
+{
+	using CodeT = std::make_unsigned_t<CharT>;
+	const CodeT code = static_cast<CodeT>(c);
+	if constexpr (ignoreCase)
+		return (static_cast<unsigned>(code - 'A') < 26) ? static_cast<CodeT>(code | 0x20) : code;
+	else
+		return code;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<bool ignoreCase, class CharT>
+static inline bool IsEqual(const CharT* a, const CharT* b, size_t count) noexcept
+{
+	if constexpr (!ignoreCase)
+	{
+		return !count || !std::memcmp(a, b, count * sizeof(CharT));
+	} else {
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (Fold<ignoreCase>(a[i]) != Fold<ignoreCase>(b[i]))
+				return false;
+		}
+		return true;
+	}
+}
+
+#if AML_SSE2
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+struct SearchBlock final
+{
+	#if AML_AVX2
+		using Vec = __m256i;
+	#else
+		using Vec = __m128i;
+	#endif
+
+	// Количество символов в блоке
+	static constexpr size_t SIZE = sizeof(Vec) / sizeof(CharT);
+
+	static Vec Load(const CharT* p)
+	{
+		#if AML_AVX2
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		#else
+			return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		#endif
+	}
+
+	static Vec Broadcast(unsigned c)
+	{
+		#if AML_AVX2
+			if constexpr (sizeof(CharT) == 1)
+				return _mm256_set1_epi8(static_cast<char>(c));
+			else if constexpr (sizeof(CharT) == 2)
+				return _mm256_set1_epi16(static_cast<short>(c));
+			else
+				return _mm256_set1_epi32(static_cast<int>(c));
+		#else
+			if constexpr (sizeof(CharT) == 1)
+				return _mm_set1_epi8(static_cast<char>(c));
+			else if constexpr (sizeof(CharT) == 2)
+				return _mm_set1_epi16(static_cast<short>(c));
+			else
+				return _mm_set1_epi32(static_cast<int>(c));
+		#endif
+	}
+
+	// Возвращает маску (по биту на каждый байт блока), в которой установлены биты символов блока a,
+	// равных символу firstChar, и одновременно символов блока b, равных символу lastChar
+	static uint32_t Match(Vec a, Vec firstChar, Vec b, Vec lastChar)
+	{
+		#if AML_AVX2
+			if constexpr (sizeof(CharT) == 1)
+				a = _mm256_and_si256(_mm256_cmpeq_epi8(a, firstChar), _mm256_cmpeq_epi8(b, lastChar));
+			else if constexpr (sizeof(CharT) == 2)
+				a = _mm256_and_si256(_mm256_cmpeq_epi16(a, firstChar), _mm256_cmpeq_epi16(b, lastChar));
+			else
+				a = _mm256_and_si256(_mm256_cmpeq_epi32(a, firstChar), _mm256_cmpeq_epi32(b, lastChar));
+			return static_cast<uint32_t>(_mm256_movemask_epi8(a));
+		#else
+			if constexpr (sizeof(CharT) == 1)
+				a = _mm_and_si128(_mm_cmpeq_epi8(a, firstChar), _mm_cmpeq_epi8(b, lastChar));
+			else if constexpr (sizeof(CharT) == 2)
+				a = _mm_and_si128(_mm_cmpeq_epi16(a, firstChar), _mm_cmpeq_epi16(b, lastChar));
+			else
+				a = _mm_and_si128(_mm_cmpeq_epi32(a, firstChar), _mm_cmpeq_epi32(b, lastChar));
+			return static_cast<uint32_t>(_mm_movemask_epi8(a));
+		#endif
+	}
+
+	static Vec Or(Vec a, Vec b)
+	{
+		#if AML_AVX2
+			return _mm256_or_si256(a, b);
+		#else
+			return _mm_or_si128(a, b);
+		#endif
+	}
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<bool ignoreCase, class CharT>
+static size_t FindInBlocks(const CharT* str, size_t size, const CharT* needle, size_t n, size_t from) noexcept
+{
+	using Block = SearchBlock<CharT>;
+	using Vec = typename Block::Vec;
+
+	const unsigned firstChar = Fold<ignoreCase>(needle[0]);
+	const unsigned lastChar = Fold<ignoreCase>(needle[n - 1]);
+
+	// Без учёта регистра к символам блока добавляется бит 0x20, но только если соответствующий символ
+	// подстроки - строчная буква: тогда и строчная, и прописная буква блока совпадут с ней
+	const auto caseBit = [](unsigned c) { return (ignoreCase && c - 'a' < 26) ? 0x20u : 0u; };
+	const Vec firstCase = Block::Broadcast(caseBit(firstChar));
+	const Vec lastCase = Block::Broadcast(caseBit(lastChar));
+	const Vec firstVec = Block::Broadcast(firstChar);
+	const Vec lastVec = Block::Broadcast(lastChar);
+
+	// Позиция вхождения не может быть больше last, поэтому последний символ блока, сравниваемого
+	// с последним символом подстроки, не выходит за пределы строки
+	const size_t last = size - n;
+	size_t pos = from;
+	for (; pos <= last && last - pos >= Block::SIZE - 1; pos += Block::SIZE)
+	{
+		const Vec a = Block::Or(Block::Load(str + pos), firstCase);
+		const Vec b = Block::Or(Block::Load(str + pos + n - 1), lastCase);
+		for (uint32_t mask = Block::Match(a, firstVec, b, lastVec); mask;)
+		{
+			const unsigned i = CountTrailingZeros(mask) / sizeof(CharT);
+			if (IsEqual<ignoreCase>(str + pos + i, needle, n))
+				return pos + i;
+			mask &= ~(((1u << sizeof(CharT)) - 1) << (i * sizeof(CharT)));
+		}
+	}
+
+	for (; pos <= last; ++pos)
+	{
+		if (Fold<ignoreCase>(str[pos]) == firstChar && IsEqual<ignoreCase>(str + pos, needle, n))
+			return pos;
+	}
+
+	return std::basic_string_view<CharT>::npos;
+}
+#endif // AML_SSE2
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<bool ignoreCase, class CharT>
+static void BuildTable(uint32_t* table, const CharT* needle, size_t n) noexcept
+{
+	// Сдвиги больше UINT32_MAX (для очень длинных подстрок) уменьшаются, что не нарушает корректность поиска.
+	// Символы Wide с одинаковым младшим байтом попадают в одну ячейку, в которой остаётся меньший сдвиг
+	const uint32_t maxShift = static_cast<uint32_t>(std::min<size_t>(n, UINT32_MAX));
+	std::fill_n(table, SearchEngine::SKIP_TABLE_SIZE, maxShift);
+
+	for (size_t i = 0; i + 1 < n; ++i)
+	{
+		const size_t shift = std::min<size_t>(n - 1 - i, UINT32_MAX);
+		table[Fold<ignoreCase>(needle[i]) & 0xff] = static_cast<uint32_t>(shift);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<bool ignoreCase, class CharT>
+static size_t FindHorspool(const CharT* str, size_t size, const CharT* needle, size_t n, size_t from,
+	const uint32_t* table) noexcept
+{
+	const auto lastChar = Fold<ignoreCase>(needle[n - 1]);
+
+	const size_t last = size - n;
+	for (size_t pos = from; pos <= last;)
+	{
+		const auto c = Fold<ignoreCase>(str[pos + n - 1]);
+		if (c == lastChar && IsEqual<ignoreCase>(str + pos, needle, n - 1))
+			return pos;
+
+		const size_t shift = table[c & 0xff];
+		if (last - pos < shift)
+			break;
+		pos += shift;
+	}
+
+	return std::basic_string_view<CharT>::npos;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+static size_t FindImpl(std::basic_string_view<CharT> str, std::basic_string_view<CharT> needle, size_t from,
+	bool ignoreCase, const uint32_t* skipTable) noexcept
+{
+	const size_t size = str.size();
+	if (from > size)
+		return str.npos;
+
+	const size_t n = needle.size();
+	if (!n)
+		return from;
+	if (n > size - from)
+		return str.npos;
+
+	if (!ignoreCase && n == 1)
+		return str.find(needle[0], from);
+
+	#if AML_SSE2
+		if (n < SearchEngine::LONG_NEEDLE)
+		{
+			return ignoreCase ? FindInBlocks<true>(str.data(), size, needle.data(), n, from) :
+				FindInBlocks<false>(str.data(), size, needle.data(), n, from);
+		}
+	#else
+		if (!ignoreCase && n < SearchEngine::LONG_NEEDLE)
+			return str.find(needle, from);
+	#endif
+
+	uint32_t table[SearchEngine::SKIP_TABLE_SIZE];
+	if (!skipTable)
+	{
+		SearchEngine::BuildSkipTable(table, needle, ignoreCase);
+		skipTable = table;
+	}
+
+	return ignoreCase ? FindHorspool<true>(str.data(), size, needle.data(), n, from, skipTable) :
+		FindHorspool<false>(str.data(), size, needle.data(), n, from, skipTable);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   SearchEngine
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SearchEngine::BuildSkipTable(uint32_t* table, std::string_view needle, bool ignoreCase) noexcept
+{
+	if (ignoreCase)
+		BuildTable<true>(table, needle.data(), needle.size());
+	else
+		BuildTable<false>(table, needle.data(), needle.size());
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void SearchEngine::BuildSkipTable(uint32_t* table, std::wstring_view needle, bool ignoreCase) noexcept
+{
+	if (ignoreCase)
+		BuildTable<true>(table, needle.data(), needle.size());
+	else
+		BuildTable<false>(table, needle.data(), needle.size());
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t SearchEngine::Find(std::string_view str, std::string_view needle, size_t from, bool ignoreCase,
+	const uint32_t* skipTable) noexcept
+{
+	return FindImpl(str, needle, from, ignoreCase, skipTable);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t SearchEngine::Find(std::wstring_view str, std::wstring_view needle, size_t from, bool ignoreCase,
+	const uint32_t* skipTable) noexcept
+{
+	return FindImpl(str, needle, from, ignoreCase, skipTable);
+}
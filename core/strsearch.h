@@ -0,0 +1,130 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "platform.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Поиск подстроки
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функции Find и FindInsensitive этого раздела, а также класс BasicSearcher ищут первое вхождение подстроки needle в строку
+// str, начиная с позиции from, и возвращают его позицию или npos, если вхождения нет. Пустая подстрока находится в позиции
+// from (если from не больше длины строки). Функции FindInsensitive не учитывают регистр символов ASCII (так же, как функции
+// Str*InsCmp, работающие как при "C" локали). Если макрос AML_SSE2 равен 1, то подстроки короче SearchEngine::LONG_NEEDLE
+// символов ищутся блоками по 16 байт (или 32 байта, если AML_AVX2 равен 1): блок строки проверяется на совпадение с первым
+// и последним символами подстроки одновременно, и только позиции, где совпали оба символа, сравниваются полностью. Для
+// длинных подстрок (или если AML_SSE2 равен 0) используется алгоритм Хорспула (Boyer-Moore-Horspool)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class SearchEngine
+{
+public:
+	// Длина подстроки, начиная с которой используется алгоритм Хорспула
+	static constexpr size_t LONG_NEEDLE = 32;
+	// Размер таблицы сдвигов алгоритма Хорспула (символы Wide распределяются по таблице по младшему байту)
+	static constexpr size_t SKIP_TABLE_SIZE = 256;
+
+	// Заполняет таблицу сдвигов table для подстроки needle
+	static void BuildSkipTable(uint32_t* table, std::string_view needle, bool ignoreCase) noexcept;
+	static void BuildSkipTable(uint32_t* table, std::wstring_view needle, bool ignoreCase) noexcept;
+
+	// Ищет вхождение подстроки needle в строку str. Таблица сдвигов skipTable, заполненная функцией BuildSkipTable
+	// для той же подстроки, нужна только для длинных подстрок. Если она равна nullptr, то функция заполнит её сама
+	static size_t Find(std::string_view str, std::string_view needle, size_t from, bool ignoreCase,
+		const uint32_t* skipTable) noexcept;
+	static size_t Find(std::wstring_view str, std::wstring_view needle, size_t from, bool ignoreCase,
+		const uint32_t* skipTable) noexcept;
+};
+
+// Ищет вхождение подстроки needle в строку str с учётом регистра
+inline size_t Find(std::string_view str, std::string_view needle, size_t from = 0) noexcept
+{
+	return SearchEngine::Find(str, needle, from, false, nullptr);
+}
+
+inline size_t Find(std::wstring_view str, std::wstring_view needle, size_t from = 0) noexcept
+{
+	return SearchEngine::Find(str, needle, from, false, nullptr);
+}
+
+// Ищет вхождение подстроки needle в строку str без учёта регистра символов ASCII
+inline size_t FindInsensitive(std::string_view str, std::string_view needle, size_t from = 0) noexcept
+{
+	return SearchEngine::Find(str, needle, from, true, nullptr);
+}
+
+inline size_t FindInsensitive(std::wstring_view str, std::wstring_view needle, size_t from = 0) noexcept
+{
+	return SearchEngine::Find(str, needle, from, true, nullptr);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   BasicSearcher - подготовленный поиск подстроки
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Класс BasicSearcher хранит копию подстроки и подготовленную для неё таблицу сдвигов, поэтому его стоит использовать
+// для поиска одной и той же подстроки во многих строках (например, при поиске в строках лога)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+class BasicSearcher
+{
+public:
+	using view_type = std::basic_string_view<CharT>;
+	static constexpr size_t npos = view_type::npos;
+
+	// Подготавливает поиск подстроки needle. Если параметр ignoreCase
+	// равен true, то при поиске не учитывается регистр символов ASCII
+	explicit BasicSearcher(view_type needle, bool ignoreCase = false)
+		: m_Needle(needle)
+		, m_IgnoreCase(ignoreCase)
+	{
+		if (m_Needle.size() >= SearchEngine::LONG_NEEDLE)
+		{
+			m_SkipTable.resize(SearchEngine::SKIP_TABLE_SIZE);
+			SearchEngine::BuildSkipTable(m_SkipTable.data(), m_Needle, m_IgnoreCase);
+		}
+	}
+
+	// Возвращает позицию первого вхождения подстроки в строку str, начиная с позиции from, или npos
+	size_t Find(view_type str, size_t from = 0) const noexcept
+	{
+		const uint32_t* skipTable = m_SkipTable.empty() ? nullptr : m_SkipTable.data();
+		return SearchEngine::Find(str, m_Needle, from, m_IgnoreCase, skipTable);
+	}
+
+	// Возвращает true, если строка str содержит подстроку
+	bool IsFoundIn(view_type str) const noexcept
+	{
+		return Find(str) != npos;
+	}
+
+	// Возвращает искомую подстроку
+	view_type GetNeedle() const noexcept { return m_Needle; }
+
+	// Возвращает true, если регистр символов ASCII не учитывается
+	bool IsIgnoreCase() const noexcept { return m_IgnoreCase; }
+
+protected:
+	std::basic_string<CharT> m_Needle;	// Копия искомой подстроки
+	std::vector<uint32_t> m_SkipTable;	// Таблица сдвигов (только для длинных подстрок)
+	bool m_IgnoreCase;
+};
+
+using Searcher = BasicSearcher<char>;
+using WSearcher = BasicSearcher<wchar_t>;
+
+} // namespace util
@@ -6,9 +6,20 @@
 #include "strutil.h"
 
 #include "array.h"
+#include "unicase.h"
+#include "utf.h"
+#include "util.h"
 #include "winapi.h"
 
 #include <ctype.h>
+#include <wctype.h>
+
+#if AML_SSE2
+	#include <emmintrin.h>
+#endif
+#if AML_AVX2
+	#include <immintrin.h>
+#endif
 
 namespace util {
 
@@ -35,20 +46,218 @@ const EmptyStringContainer EMPTY;
 //--------------------------------------------------------------------------------------------------------------------------------
 struct caseTT final
 {
-	// Lookup таблица для преобразования латинских букв нижнего регистра к верхнему (вычитание). Первые 32
-	// байта нулевые, далее значения совпадают с началом массива down: значение 0x20 в индексах 0x61-0x7a
-	static inline const uint8_t up[32] = {};
-
-	// Lookup таблица для преобразования латинских букв верхнего регистра к нижнему (сложение).
-	// Все байты массива равны 0, кроме индексов 0x41-0x5a, в которых значение равно 0x20
-	static inline const uint8_t down[256] = {
+	// Обе таблицы up и down (по 256 байт) размещены в одном массиве: таблица up начинается
+	// на 32 байта раньше таблицы down, поэтому её значения сдвинуты на 32 индекса
+	static inline const uint8_t data[32 + 256] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 		0, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32,
 		32, 32, 32
 	};
+
+	// Lookup таблица для преобразования латинских букв нижнего регистра к верхнему (вычитание). Первые 32
+	// байта нулевые, далее значения совпадают с началом таблицы down: значение 0x20 в индексах 0x61-0x7a
+	static constexpr const uint8_t* up = data;
+
+	// Lookup таблица для преобразования латинских букв верхнего регистра к нижнему (сложение).
+	// Все байты таблицы равны 0, кроме индексов 0x41-0x5a, в которых значение равно 0x20
+	static constexpr const uint8_t* down = data + 32;
+
+	// Возвращают символ c, приведённый к нижнему (Lower) или верхнему (Upper) регистру. Для
+	// символов wchar_t таблицы используются только для значений, не превышающих 0x7f
+	static unsigned Lower(char c) { const unsigned u = static_cast<unsigned char>(c); return u + down[u]; }
+	static unsigned Upper(char c) { const unsigned u = static_cast<unsigned char>(c); return u - up[u]; }
+	static unsigned Lower(wchar_t c) { const unsigned u = c; return (u <= 0x7f) ? u + down[u] : u; }
+	static unsigned Upper(wchar_t c) { const unsigned u = c; return (u <= 0x7f) ? u - up[u] : u; }
 };
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Блочная обработка строк для функций Str*InsCmp, LoCase* и UpCase*
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функции этого раздела изменяют регистр и сравнивают строки блоками по 32 байта (если макрос AML_AVX2 равен 1) или по 16 байт
+// (если макрос AML_SSE2 равен 1), а остаток строки обрабатывают посимвольно. Результат всегда совпадает с результатом
+// посимвольной обработки с помощью таблиц caseTT: регистр меняется только у латинских букв 'A'..'Z' и 'a'..'z'
+
+#if AML_SSE2
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+struct CaseBlock final
+{
+	#if AML_AVX2
+		using Vec = __m256i;
+	#else
+		using Vec = __m128i;
+	#endif
+
+	// Количество символов в блоке
+	static constexpr size_t SIZE = sizeof(Vec) / sizeof(T);
+
+	static Vec Load(const T* p)
+	{
+		#if AML_AVX2
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		#else
+			return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		#endif
+	}
+
+	static void Store(T* p, Vec v)
+	{
+		#if AML_AVX2
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+		#else
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+		#endif
+	}
+
+	// Возвращает блок v, в котором символы first..first+25 (буквы одного регистра) заменены буквами другого регистра.
+	// Смещение на минимальное знаковое значение позволяет проверить диапазон одним знаковым сравнением
+	static Vec SwapCase(Vec v, int first)
+	{
+		#if AML_AVX2
+			if constexpr (sizeof(T) == 1)
+			{
+				const __m256i t = _mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(0x80 - first)));
+				const __m256i mask = _mm256_cmpgt_epi8(_mm256_set1_epi8(-0x80 + 26), t);
+				return _mm256_xor_si256(v, _mm256_and_si256(mask, _mm256_set1_epi8(0x20)));
+			}
+			else if constexpr (sizeof(T) == 2)
+			{
+				const __m256i t = _mm256_add_epi16(v, _mm256_set1_epi16(static_cast<short>(0x8000 - first)));
+				const __m256i mask = _mm256_cmpgt_epi16(_mm256_set1_epi16(-0x8000 + 26), t);
+				return _mm256_xor_si256(v, _mm256_and_si256(mask, _mm256_set1_epi16(0x20)));
+			} else {
+				const __m256i t = _mm256_add_epi32(v, _mm256_set1_epi32(static_cast<int>(0x80000000u - first)));
+				const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(INT_MIN + 26), t);
+				return _mm256_xor_si256(v, _mm256_and_si256(mask, _mm256_set1_epi32(0x20)));
+			}
+		#else
+			if constexpr (sizeof(T) == 1)
+			{
+				const __m128i t = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - first)));
+				const __m128i mask = _mm_cmplt_epi8(t, _mm_set1_epi8(-0x80 + 26));
+				return _mm_xor_si128(v, _mm_and_si128(mask, _mm_set1_epi8(0x20)));
+			}
+			else if constexpr (sizeof(T) == 2)
+			{
+				const __m128i t = _mm_add_epi16(v, _mm_set1_epi16(static_cast<short>(0x8000 - first)));
+				const __m128i mask = _mm_cmplt_epi16(t, _mm_set1_epi16(-0x8000 + 26));
+				return _mm_xor_si128(v, _mm_and_si128(mask, _mm_set1_epi16(0x20)));
+			} else {
+				const __m128i t = _mm_add_epi32(v, _mm_set1_epi32(static_cast<int>(0x80000000u - first)));
+				const __m128i mask = _mm_cmplt_epi32(t, _mm_set1_epi32(INT_MIN + 26));
+				return _mm_xor_si128(v, _mm_and_si128(mask, _mm_set1_epi32(0x20)));
+			}
+		#endif
+	}
+
+	// Возвращает битовую маску (по одному биту на байт блока) символов, которые
+	// в блоках a и b равны без учёта регистра. Если checkZero == true, то биты
+	// символов, равных 0, в маске сбрасываются
+	template<bool checkZero>
+	static uint32_t EqualMask(Vec a, Vec b)
+	{
+		a = SwapCase(a, 'A'), b = SwapCase(b, 'A');
+		#if AML_AVX2
+			__m256i eq = CmpEq(a, b);
+			if constexpr (checkZero)
+				eq = _mm256_andnot_si256(CmpEq(a, _mm256_setzero_si256()), eq);
+			return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+		#else
+			__m128i eq = CmpEq(a, b);
+			if constexpr (checkZero)
+				eq = _mm_andnot_si128(CmpEq(a, _mm_setzero_si128()), eq);
+			return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+		#endif
+	}
+
+	static Vec CmpEq(Vec a, Vec b)
+	{
+		#if AML_AVX2
+			if constexpr (sizeof(T) == 1)
+				return _mm256_cmpeq_epi8(a, b);
+			else if constexpr (sizeof(T) == 2)
+				return _mm256_cmpeq_epi16(a, b);
+			else
+				return _mm256_cmpeq_epi32(a, b);
+		#else
+			if constexpr (sizeof(T) == 1)
+				return _mm_cmpeq_epi8(a, b);
+			else if constexpr (sizeof(T) == 2)
+				return _mm_cmpeq_epi16(a, b);
+			else
+				return _mm_cmpeq_epi32(a, b);
+		#endif
+	}
+
+	// Битовая маска, в которой установлены биты всех байт блока
+	static constexpr uint32_t FULL_MASK = (sizeof(Vec) == 32) ? 0xffffffff : 0xffff;
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<bool isTerminated, class T>
+static size_t SkipEqualChars(const T* strA, const T* strB, size_t count)
+{
+	// Функция пропускает символы, которые в строках strA и strB (из которых читаются не более count символов) равны без учёта
+	// регистра, и возвращает количество пропущенных символов. Если isTerminated == true, то функция также останавливается на
+	// терминирующем нуле. В этом случае за концом строки могут быть прочитаны лишние байты, но только в пределах той же
+	// страницы памяти, поэтому блок читается лишь тогда, когда он не пересекает границу страницы ни в одной из строк
+	using Block = CaseBlock<T>;
+	constexpr size_t PAGE_SIZE = 4096;
+	constexpr size_t LAST_OFFSET = PAGE_SIZE - sizeof(typename Block::Vec);
+
+	size_t skipped = 0;
+	while (count - skipped >= Block::SIZE)
+	{
+		const T* const a = strA + skipped;
+		const T* const b = strB + skipped;
+		if constexpr (isTerminated)
+		{
+			if ((reinterpret_cast<uintptr_t>(a) & (PAGE_SIZE - 1)) > LAST_OFFSET ||
+				(reinterpret_cast<uintptr_t>(b) & (PAGE_SIZE - 1)) > LAST_OFFSET)
+			{
+				// Перед границей страницы сравниваем строки посимвольно
+				if (!*a || caseTT::Lower(*a) != caseTT::Lower(*b))
+					return skipped;
+
+				++skipped;
+				continue;
+			}
+		}
+
+		const uint32_t mask = Block::template EqualMask<isTerminated>(Block::Load(a), Block::Load(b));
+		if (mask != Block::FULL_MASK)
+			return skipped + CountTrailingZeros(~mask) / sizeof(T);
+
+		skipped += Block::SIZE;
+	}
+
+	return skipped;
+}
+
+#endif // AML_SSE2
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<bool toUpper, class T>
+static void ChangeCase(T* str, size_t size)
+{
+	T* const end = str + size;
+
+	#if AML_SSE2
+		using Block = CaseBlock<T>;
+		for (; static_cast<size_t>(end - str) >= Block::SIZE; str += Block::SIZE)
+			Block::Store(str, Block::SwapCase(Block::Load(str), toUpper ? 'a' : 'A'));
+	#endif
+
+	for (; str != end; ++str)
+		*str = static_cast<T>(toUpper ? caseTT::Upper(*str) : caseTT::Lower(*str));
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //   Сравнение строк
@@ -58,6 +267,11 @@ struct caseTT final
 //--------------------------------------------------------------------------------------------------------------------------------
 int StrInsCmp(const char* strA, const char* strB)
 {
+	#if AML_SSE2
+		const size_t skipped = SkipEqualChars<true>(strA, strB, SIZE_MAX);
+		strA += skipped, strB += skipped;
+	#endif
+
 	int a, b;
 	do {
 		a = static_cast<unsigned char>(*strA++);
@@ -78,6 +292,11 @@ int StrInsCmp(const wchar_t* strA, const wchar_t* strB)
 	static_assert(std::is_unsigned_v<wchar_t> || sizeof(wchar_t) == sizeof(unsigned),
 		"Type wchar_t must be unsigned or same-sized as unsigned (int) type");
 
+	#if AML_SSE2
+		const size_t skipped = SkipEqualChars<true>(strA, strB, SIZE_MAX);
+		strA += skipped, strB += skipped;
+	#endif
+
 	unsigned a, b;
 	do {
 		a = *strA++;
@@ -95,6 +314,11 @@ int StrInsCmp(const wchar_t* strA, const wchar_t* strB)
 //--------------------------------------------------------------------------------------------------------------------------------
 static int StrInsCmpImpl(const char* strA, const char* strB, size_t count)
 {
+	#if AML_SSE2
+		const size_t skipped = SkipEqualChars<false>(strA, strB, count);
+		strA += skipped, strB += skipped, count -= skipped;
+	#endif
+
 	if (!count)
 		return 0;
 
@@ -116,6 +340,11 @@ static int StrInsCmpImpl(const wchar_t* strA, const wchar_t* strB, size_t count)
 	static_assert(std::is_unsigned_v<wchar_t> || sizeof(wchar_t) == sizeof(unsigned),
 		"Type wchar_t must be unsigned or same-sized as unsigned (int) type");
 
+	#if AML_SSE2
+		const size_t skipped = SkipEqualChars<false>(strA, strB, count);
+		strA += skipped, strB += skipped, count -= skipped;
+	#endif
+
 	if (!count)
 		return 0;
 
@@ -196,6 +425,11 @@ int StrCaseCmp(const wchar_t* strA, const wchar_t* strB)
 //--------------------------------------------------------------------------------------------------------------------------------
 int StrNInsCmp(const char* strA, const char* strB, size_t count)
 {
+	#if AML_SSE2
+		const size_t skipped = SkipEqualChars<true>(strA, strB, count);
+		strA += skipped, strB += skipped, count -= skipped;
+	#endif
+
 	if (!count)
 		return 0;
 
@@ -217,6 +451,11 @@ int StrNInsCmp(const wchar_t* strA, const wchar_t* strB, size_t count)
 	static_assert(std::is_unsigned_v<wchar_t> || sizeof(wchar_t) == sizeof(unsigned),
 		"Type wchar_t must be unsigned or same-sized as unsigned (int) type");
 
+	#if AML_SSE2
+		const size_t skipped = SkipEqualChars<true>(strA, strB, count);
+		strA += skipped, strB += skipped, count -= skipped;
+	#endif
+
 	if (!count)
 		return 0;
 
@@ -311,221 +550,145 @@ int StrNCaseCmp(const wchar_t* strA, const wchar_t* strB, size_t count)
 #endif
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static inline char* Strlwr(char* str, bool useLocale)
+static inline void Strlwr(char* str, size_t size, bool useLocale)
 {
 	if (useLocale)
 	{
 		#if AML_OS_WINDOWS
 			// Эта функция работает почти вдвое быстрее цикла с вызовом tolower в
 			// каждой итерации (при условии, что локаль программы не изменялась)
-			return _strlwr(str);
+			_strlwr(str);
 		#else
 			for (char* p = str; *p; ++p)
 			{
 				unsigned char c = *p;
 				*p = static_cast<char>(tolower(c));
 			}
-			return str;
 		#endif
 	}
-
-	unsigned c;
-	for (char* p = str;; ++p)
-	{
-		c = static_cast<unsigned char>(*p);
-		if (c == 0)
-			return str;
-
-		c += caseTT::down[c];
-		*p = static_cast<char>(c);
-	}
+	else
+		ChangeCase<false>(str, size);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static inline char* Strupr(char* str, bool useLocale)
+static inline void Strupr(char* str, size_t size, bool useLocale)
 {
 	if (useLocale)
 	{
 		#if AML_OS_WINDOWS
 			// Эта функция работает почти вдвое быстрее цикла с вызовом toupper в
 			// каждой итерации (при условии, что локаль программы не изменялась)
-			return _strupr(str);
+			_strupr(str);
 		#else
 			for (char* p = str; *p; ++p)
 			{
 				unsigned char c = *p;
 				*p = static_cast<char>(toupper(c));
 			}
-			return str;
 		#endif
 	}
-
-	unsigned c;
-	for (char* p = str;; ++p)
-	{
-		c = static_cast<unsigned char>(*p);
-		if (c == 0)
-			return str;
-
-		c -= caseTT::up[c];
-		*p = static_cast<char>(c);
-	}
+	else
+		ChangeCase<true>(str, size);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static inline wchar_t* Wcslwr(wchar_t* str, bool useLocale)
+static inline void Wcslwr(wchar_t* str, size_t size, bool useLocale)
 {
 	if (useLocale)
 	{
 		#if AML_OS_WINDOWS
 			// Эта функция работает в ~4 раза быстрее цикла с вызовом towlower в
 			// каждой итерации (при условии, что локаль программы не изменялась)
-			return _wcslwr(str);
+			_wcslwr(str);
 		#else
-			for (wchar_t* p = str; *p; ++p)
-				*p = static_cast<wchar_t>(towlower(*p));
-			return str;
+			// Вместо цикла с вызовом towlower используем таблицы Unicode: так
+			// быстрее, а результат не зависит от локали (см. unicase.h)
+			ToLowerInplace(str, size);
 		#endif
 	}
-
-	for (wchar_t* p = str;; ++p)
-	{
-		unsigned c = *p;
-		if (c == 0)
-			return str;
-
-		if (c <= 0x7f)
-			c += caseTT::down[c];
-		*p = static_cast<wchar_t>(c);
-	}
+	else
+		ChangeCase<false>(str, size);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static inline wchar_t* Wcsupr(wchar_t* str, bool useLocale)
+static inline void Wcsupr(wchar_t* str, size_t size, bool useLocale)
 {
 	if (useLocale)
 	{
 		#if AML_OS_WINDOWS
 			// Эта функция работает в ~4 раза быстрее цикла с вызовом towupper в
 			// каждой итерации (при условии, что локаль программы не изменялась)
-			return _wcsupr(str);
+			_wcsupr(str);
 		#else
-			for (wchar_t* p = str; *p; ++p)
-				*p = static_cast<wchar_t>(towupper(*p));
-			return str;
+			// Вместо цикла с вызовом towupper используем таблицы Unicode (см. Wcslwr)
+			ToUpperInplace(str, size);
 		#endif
 	}
-
-	for (wchar_t* p = str;; ++p)
-	{
-		unsigned c = *p;
-		if (c == 0)
-			return str;
-
-		if (c <= 0x7f)
-			c -= caseTT::up[c];
-		*p = static_cast<wchar_t>(c);
-	}
+	else
+		ChangeCase<true>(str, size);
 }
 
 #if AML_OS_WINDOWS
 	#pragma warning(pop)
 #endif
 
+// Функции LoCase и UpCase копируют строку и изменяют регистр символов непосредственно в копии, а функции *Inplace - в самой
+// строке str (начиная с C++17 её буфер доступен для записи, а терминирующий 0 нужен функциям, использующим локаль)
+
 //--------------------------------------------------------------------------------------------------------------------------------
 std::string LoCase(std::string_view str, bool noLocale)
 {
-	const size_t len = str.size();
-	if (!len)
-		return std::string();
-
-	SmartArray<char, 512> buffer(len + 1);
-	memcpy(buffer, str.data(), len);
-	buffer[len] = 0;
-
-	return std::string(Strlwr(buffer, !noLocale), len);
+	std::string result(str);
+	Strlwr(result.data(), result.size(), !noLocale);
+	return result;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 std::wstring LoCase(std::wstring_view str, bool noLocale)
 {
-	const size_t len = str.size();
-	if (!len)
-		return std::wstring();
-
-	SmartArray<wchar_t, 512> buffer(len + 1);
-	memcpy(buffer, str.data(), len * sizeof(wchar_t));
-	buffer[len] = 0;
-
-	return std::wstring(Wcslwr(buffer, !noLocale), len);
+	std::wstring result(str);
+	Wcslwr(result.data(), result.size(), !noLocale);
+	return result;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 std::string UpCase(std::string_view str, bool noLocale)
 {
-	const size_t len = str.size();
-	if (!len)
-		return std::string();
-
-	SmartArray<char, 512> buffer(len + 1);
-	memcpy(buffer, str.data(), len);
-	buffer[len] = 0;
-
-	return std::string(Strupr(buffer, !noLocale), len);
+	std::string result(str);
+	Strupr(result.data(), result.size(), !noLocale);
+	return result;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 std::wstring UpCase(std::wstring_view str, bool noLocale)
 {
-	const size_t len = str.size();
-	if (!len)
-		return std::wstring();
-
-	SmartArray<wchar_t, 512> buffer(len + 1);
-	memcpy(buffer, str.data(), len * sizeof(wchar_t));
-	buffer[len] = 0;
-
-	return std::wstring(Wcsupr(buffer, !noLocale), len);
+	std::wstring result(str);
+	Wcsupr(result.data(), result.size(), !noLocale);
+	return result;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 void LoCaseInplace(std::string& str, bool noLocale)
 {
-	if (const size_t len = str.size())
-	{
-		SmartArray<char, 512> buffer(len + 1, str.c_str());
-		str.assign(Strlwr(buffer, !noLocale), len);
-	}
+	Strlwr(str.data(), str.size(), !noLocale);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 void LoCaseInplace(std::wstring& str, bool noLocale)
 {
-	if (const size_t len = str.size())
-	{
-		SmartArray<wchar_t, 512> buffer(len + 1, str.c_str());
-		str.assign(Wcslwr(buffer, !noLocale), len);
-	}
+	Wcslwr(str.data(), str.size(), !noLocale);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 void UpCaseInplace(std::string& str, bool noLocale)
 {
-	if (const size_t len = str.size())
-	{
-		SmartArray<char, 512> buffer(len + 1, str.c_str());
-		str.assign(Strupr(buffer, !noLocale), len);
-	}
+	Strupr(str.data(), str.size(), !noLocale);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 void UpCaseInplace(std::wstring& str, bool noLocale)
 {
-	if (const size_t len = str.size())
-	{
-		SmartArray<wchar_t, 512> buffer(len + 1, str.c_str());
-		str.assign(Wcsupr(buffer, !noLocale), len);
-	}
+	Wcsupr(str.data(), str.size(), !noLocale);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -737,8 +900,10 @@ enum class MBCodePage
 	Utf8
 };
 
+#if AML_OS_WINDOWS
+
 //--------------------------------------------------------------------------------------------------------------------------------
-static size_t FastMBToWide(const char* str, size_t size)
+static size_t FastAnsiToWide(const char* str, size_t size)
 {
 	for (size_t i = 0; i < size; ++i)
 	{
@@ -750,13 +915,11 @@ static size_t FastMBToWide(const char* str, size_t size)
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static size_t FastMBToWide(wchar_t* out, const char* str, size_t size)
+static size_t FastAnsiToWide(wchar_t* out, const char* str, size_t size)
 {
-	// TODO: эта и предыдущая функции - попытка оптимизировать алгоритм конвертации строк Ansi/UTF-8 в Wide. Идея
-	// заключается в том, чтобы быстро скопировать в выходной буфер символы, значения которых меньше 0x80, а затем
-	// обработать оставшуюся часть строки обычным способом, т.е. с помощью функций ОС. Но обрабатывать по 1 символу
-	// за раз - неоптимально. А чтобы делать это оптимально, нужны разные версии функций для x86/x64, а также разного
-	// размера типа wchar_t. Тем не менее, для коротких строк даже такая оптимизация даёт существенный выигрыш
+	// Эта и предыдущая функции быстро копируют в выходной буфер символы Ansi строки, значения которых меньше 0x80. Остаток
+	// строки конвертируется функцией ОС. Для коротких строк такая оптимизация даёт существенный выигрыш (строки UTF-8
+	// конвертируются без функций ОС, см. функцию Utf8ToWide)
 
 	for (size_t i = 0; i < size; ++i)
 	{
@@ -771,98 +934,84 @@ static size_t FastMBToWide(wchar_t* out, const char* str, size_t size)
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static void MBToWide(std::wstring& out, MBCodePage codePage, const char* str, size_t size)
+static void AnsiToWide(std::wstring& out, const char* str, size_t size)
 {
-	#if AML_OS_WINDOWS
-		const size_t LOCAL_SIZE = 3840 / sizeof(wchar_t);
-		int bufferSize = LOCAL_SIZE;
-
-		// Мне не известно, в какое максимальное количество codepoint UTF-16 может быть закодирован отдельный символ Ansi
-		// или какая-либо комбинация символов при конвертировании из Ansi (ACP). И чтобы наверняка не ошибиться, мы будем
-		// искать необходимый размер буфера, только если длина исходной строки будет больше 1/4 размера локального буфера.
-		// Для UTF-8 в худшем случае на каждый байт исходной строки будет приходится по одному codepoint UTF-16, в других
-		// случаях длина результирующей строки всегда будет меньше количества байт в исходной
-		if (auto limit = (codePage == MBCodePage::Ansi) ? LOCAL_SIZE / 4 : LOCAL_SIZE; size > limit)
-		{
-			if (size > INT_MAX)
-				return;
+	const size_t LOCAL_SIZE = 3840 / sizeof(wchar_t);
+	int bufferSize = LOCAL_SIZE;
 
-			const unsigned cp = (codePage == MBCodePage::Ansi) ? CP_ACP : CP_UTF8;
-			bufferSize = ::MultiByteToWideChar(cp, 0, str, static_cast<int>(size), nullptr, 0);
-			if (bufferSize <= 0)
-				return;
-		}
+	// Мне не известно, в какое максимальное количество codepoint UTF-16 может быть закодирован отдельный символ Ansi
+	// или какая-либо комбинация символов при конвертировании из Ansi (ACP). И чтобы наверняка не ошибиться, мы будем
+	// искать необходимый размер буфера, только если длина исходной строки будет больше 1/4 размера локального буфера
+	if (size > LOCAL_SIZE / 4)
+	{
+		if (size > INT_MAX)
+			return;
 
-		SmartArray<wchar_t, LOCAL_SIZE> buffer(bufferSize);
-		// Сначала пытаемся быстро сконвертировать те символы в начале строки, значение которых
-		// меньше 0x80. В случае коротких строк функция WinAPI будет работать намного медленнее
-		size_t count = (size < 120) ? FastMBToWide(buffer, str, size) : 0;
+		bufferSize = ::MultiByteToWideChar(CP_ACP, 0, str, static_cast<int>(size), nullptr, 0);
+		if (bufferSize <= 0)
+			return;
+	}
 
-		if (count < size)
-		{
-			const unsigned cp = (codePage == MBCodePage::Ansi) ? CP_ACP : CP_UTF8;
-			int len = ::MultiByteToWideChar(cp, 0, str + count, static_cast<int>(size - count),
-				buffer + count, bufferSize - static_cast<int>(count));
-			if (len <= 0)
-				return;
-			count += len;
-		}
+	SmartArray<wchar_t, LOCAL_SIZE> buffer(bufferSize);
+	// Сначала пытаемся быстро сконвертировать те символы в начале строки, значение которых
+	// меньше 0x80. В случае коротких строк функция WinAPI будет работать намного медленнее
+	size_t count = (size < 120) ? FastAnsiToWide(buffer, str, size) : 0;
 
-		out.assign(buffer, count);
-	#else
-		#error Not implemented
-	#endif
+	if (count < size)
+	{
+		int len = ::MultiByteToWideChar(CP_ACP, 0, str + count, static_cast<int>(size - count),
+			buffer + count, bufferSize - static_cast<int>(count));
+		if (len <= 0)
+			return;
+		count += len;
+	}
+
+	out.assign(buffer, count);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static int MBToWide(wchar_t* buffer, size_t bufferSize, MBCodePage codePage, const char* str, size_t size)
+static int AnsiToWide(wchar_t* buffer, size_t bufferSize, const char* str, size_t size)
 {
-	#if AML_OS_WINDOWS
-		size_t count;
-		if (!bufferSize || !buffer)
+	size_t count;
+	if (!bufferSize || !buffer)
+	{
+		// Сначала пытаемся быстро сконвертировать те символы в начале строки, значение которых
+		// меньше 0x80. В случае коротких строк функция WinAPI будет работать намного медленнее
+		count = (size < 120) ? FastAnsiToWide(str, size) : 0;
+
+		if (count < size)
 		{
-			// Сначала пытаемся быстро сконвертировать те символы в начале строки, значение которых
-			// меньше 0x80. В случае коротких строк функция WinAPI будет работать намного медленнее
-			count = (size < 120) ? FastMBToWide(str, size) : 0;
+			if (size > INT_MAX)
+				return -1;
 
-			if (count < size)
-			{
-				if (size > INT_MAX)
-					return -1;
-
-				const unsigned cp = (codePage == MBCodePage::Ansi) ? CP_ACP : CP_UTF8;
-				int len = ::MultiByteToWideChar(cp, 0, str + count, static_cast<int>(size - count), nullptr, 0);
-				if (len <= 0 || len > INT_MAX - static_cast<int>(count))
-					return -1;
-				count += len;
-			}
-		} else
+			int len = ::MultiByteToWideChar(CP_ACP, 0, str + count, static_cast<int>(size - count), nullptr, 0);
+			if (len <= 0 || len > INT_MAX - static_cast<int>(count))
+				return -1;
+			count += len;
+		}
+	} else
+	{
+		bufferSize = (bufferSize < INT_MAX) ? bufferSize : INT_MAX;
+		count = (size < 120) ? FastAnsiToWide(buffer, str, (size < bufferSize) ? size : bufferSize) : 0;
+
+		if (count < size)
 		{
-			bufferSize = (bufferSize < INT_MAX) ? bufferSize : INT_MAX;
-			count = (size < 120) ? FastMBToWide(buffer, str, (size < bufferSize) ? size : bufferSize) : 0;
+			if (count >= bufferSize)
+				return -1;
 
-			if (count < size)
-			{
-				if (count >= bufferSize)
-					return -1;
-
-				const unsigned cp = (codePage == MBCodePage::Ansi) ? CP_ACP : CP_UTF8;
-				int len = ::MultiByteToWideChar(cp, 0, str + count, static_cast<int>(size - count),
-					buffer + count, static_cast<int>(bufferSize - count));
-				if (len <= 0 || len > INT_MAX - static_cast<int>(count))
-					return -1;
-				count += len;
-			}
+			int len = ::MultiByteToWideChar(CP_ACP, 0, str + count, static_cast<int>(size - count),
+				buffer + count, static_cast<int>(bufferSize - count));
+			if (len <= 0 || len > INT_MAX - static_cast<int>(count))
+				return -1;
+			count += len;
 		}
+	}
 
-		return static_cast<int>(count);
-	#else
-		#error Not implemented
-	#endif
+	return static_cast<int>(count);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static size_t FastWideToMB(const wchar_t* str, size_t size)
+static size_t FastWideToAnsi(const wchar_t* str, size_t size)
 {
 	for (size_t i = 0; i < size; ++i)
 	{
@@ -874,10 +1023,9 @@ static size_t FastWideToMB(const wchar_t* str, size_t size)
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static size_t FastWideToMB(char* out, const wchar_t* str, size_t size)
+static size_t FastWideToAnsi(char* out, const wchar_t* str, size_t size)
 {
-	// TODO: эта и предыдущая функции - попытка оптимизировать конвертацию
-	// Wide-строк в Ansi/UTF-8. См. комментарий в функции FastMBToWide
+	// См. комментарий в функции FastAnsiToWide
 
 	for (size_t i = 0; i < size; ++i)
 	{
@@ -892,95 +1040,164 @@ static size_t FastWideToMB(char* out, const wchar_t* str, size_t size)
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
-static void WideToMB(std::string& out, MBCodePage codePage, const wchar_t* str, size_t size)
+static void WideToAnsi(std::string& out, const wchar_t* str, size_t size)
 {
-	#if AML_OS_WINDOWS
-		const size_t LOCAL_SIZE = 3840;
-		int bufferSize = LOCAL_SIZE;
-
-		// Мне не известно, в какое максимальное количество байт может быть закодирован отдельный символ UCS-2 (UTF-16) или
-		// какая-либо комбинация символов при конвертировании в Ansi (ACP). И чтобы наверняка не ошибиться, мы будем искать
-		// необходимый размер буфера, только если длина исходной строки будет больше 1/4 размера локального буфера. Каждый
-		// символ UCS-2 (эта кодировка использовалась до Windows 2000) может стать максимум 3 байтами в UTF-8. Это
-		// же справедливо и для UTF-16, но её суррогатные пары (2 16-битных слова) будут закодированы 4 байтами
-		if (auto limit = (codePage == MBCodePage::Ansi) ? LOCAL_SIZE / 4 : LOCAL_SIZE / 3; size > limit)
-		{
-			if (size > INT_MAX)
-				return;
+	const size_t LOCAL_SIZE = 3840;
+	int bufferSize = LOCAL_SIZE;
 
-			const unsigned cp = (codePage == MBCodePage::Ansi) ? CP_ACP : CP_UTF8;
-			bufferSize = ::WideCharToMultiByte(cp, 0, str, static_cast<int>(size), nullptr, 0, nullptr, nullptr);
-			if (bufferSize <= 0)
-				return;
-		}
+	// Мне не известно, в какое максимальное количество байт может быть закодирован отдельный символ UCS-2 (UTF-16) или
+	// какая-либо комбинация символов при конвертировании в Ansi (ACP). И чтобы наверняка не ошибиться, мы будем искать
+	// необходимый размер буфера, только если длина исходной строки будет больше 1/4 размера локального буфера
+	if (size > LOCAL_SIZE / 4)
+	{
+		if (size > INT_MAX)
+			return;
 
-		SmartArray<char, LOCAL_SIZE> buffer(bufferSize);
+		bufferSize = ::WideCharToMultiByte(CP_ACP, 0, str, static_cast<int>(size), nullptr, 0, nullptr, nullptr);
+		if (bufferSize <= 0)
+			return;
+	}
+
+	SmartArray<char, LOCAL_SIZE> buffer(bufferSize);
+	// Сначала пытаемся быстро сконвертировать те символы в начале строки, значение которых
+	// меньше 0x80. В случае коротких строк функция WinAPI будет работать намного медленнее
+	size_t count = (size < 120) ? FastWideToAnsi(buffer, str, size) : 0;
+
+	if (count < size)
+	{
+		int len = ::WideCharToMultiByte(CP_ACP, 0, str + count, static_cast<int>(size - count),
+			buffer + count, bufferSize - static_cast<int>(count), nullptr, nullptr);
+		if (len <= 0)
+			return;
+		count += len;
+	}
+
+	out.assign(buffer, count);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+static int WideToAnsi(char* buffer, size_t bufferSize, const wchar_t* str, size_t size)
+{
+	size_t count;
+	if (!bufferSize || !buffer)
+	{
 		// Сначала пытаемся быстро сконвертировать те символы в начале строки, значение которых
 		// меньше 0x80. В случае коротких строк функция WinAPI будет работать намного медленнее
-		size_t count = (size < 120) ? FastWideToMB(buffer, str, size) : 0;
+		count = (size < 120) ? FastWideToAnsi(str, size) : 0;
 
 		if (count < size)
 		{
-			const unsigned cp = (codePage == MBCodePage::Ansi) ? CP_ACP : CP_UTF8;
-			int len = ::WideCharToMultiByte(cp, 0, str + count, static_cast<int>(size - count),
-				buffer + count, bufferSize - static_cast<int>(count), nullptr, nullptr);
-			if (len <= 0)
-				return;
+			if (size > INT_MAX)
+				return -1;
+
+			int len = ::WideCharToMultiByte(CP_ACP, 0, str + count, static_cast<int>(size - count),
+				nullptr, 0, nullptr, nullptr);
+			if (len <= 0 || len > INT_MAX - static_cast<int>(count))
+				return -1;
 			count += len;
 		}
+	} else
+	{
+		bufferSize = (bufferSize < INT_MAX) ? bufferSize : INT_MAX;
+		count = (size < 120) ? FastWideToAnsi(buffer, str, (size < bufferSize) ? size : bufferSize) : 0;
 
-		out.assign(buffer, count);
-	#else
-		#error Not implemented
-	#endif
+		if (count < size)
+		{
+			if (count >= bufferSize)
+				return -1;
+
+			int len = ::WideCharToMultiByte(CP_ACP, 0, str + count, static_cast<int>(size - count),
+				buffer + count, static_cast<int>(bufferSize - count), nullptr, nullptr);
+			if (len <= 0 || len > INT_MAX - static_cast<int>(count))
+				return -1;
+			count += len;
+		}
+	}
+
+	return static_cast<int>(count);
 }
 
+#endif // AML_OS_WINDOWS
+
 //--------------------------------------------------------------------------------------------------------------------------------
-static int WideToMB(char* buffer, size_t bufferSize, MBCodePage codePage, const wchar_t* str, size_t size)
+static void MBToWide(std::wstring& out, MBCodePage codePage, const char* str, size_t size)
 {
 	#if AML_OS_WINDOWS
-		size_t count;
-		if (!bufferSize || !buffer)
+		if (codePage == MBCodePage::Ansi)
 		{
-			// Сначала пытаемся быстро сконвертировать те символы в начале строки, значение которых
-			// меньше 0x80. В случае коротких строк функция WinAPI будет работать намного медленнее
-			count = (size < 120) ? FastWideToMB(str, size) : 0;
+			AnsiToWide(out, str, size);
+			return;
+		}
+	#endif
 
-			if (count < size)
-			{
-				if (size > INT_MAX)
-					return -1;
-
-				const unsigned cp = (codePage == MBCodePage::Ansi) ? CP_ACP : CP_UTF8;
-				int len = ::WideCharToMultiByte(cp, 0, str + count, static_cast<int>(size - count),
-					nullptr, 0, nullptr, nullptr);
-				if (len <= 0 || len > INT_MAX - static_cast<int>(count))
-					return -1;
-				count += len;
-			}
-		} else
-		{
-			bufferSize = (bufferSize < INT_MAX) ? bufferSize : INT_MAX;
-			count = (size < 120) ? FastWideToMB(buffer, str, (size < bufferSize) ? size : bufferSize) : 0;
+	// Строки UTF-8 (а на других платформах и строки Ansi, см. strutil.h) перекодируем сами:
+	// сначала быстро считаем длину результата, а затем перекодируем строку прямо в out
+	out.resize(WideLengthOf({ str, size }));
+	Utf8ToWide(out.data(), out.size(), str, size);
+}
 
-			if (count < size)
-			{
-				if (count >= bufferSize)
-					return -1;
-
-				const unsigned cp = (codePage == MBCodePage::Ansi) ? CP_ACP : CP_UTF8;
-				int len = ::WideCharToMultiByte(cp, 0, str + count, static_cast<int>(size - count),
-					buffer + count, static_cast<int>(bufferSize - count), nullptr, nullptr);
-				if (len <= 0 || len > INT_MAX - static_cast<int>(count))
-					return -1;
-				count += len;
-			}
-		}
+//--------------------------------------------------------------------------------------------------------------------------------
+static int MBToWide(wchar_t* buffer, size_t bufferSize, MBCodePage codePage, const char* str, size_t size)
+{
+	#if AML_OS_WINDOWS
+		if (codePage == MBCodePage::Ansi)
+			return AnsiToWide(buffer, bufferSize, str, size);
+	#endif
+
+	if (size > INT_MAX)
+		return -1;
+
+	// Каждому байту строки UTF-8 соответствует не более одного символа Wide, поэтому
+	// если размер буфера не меньше size, то длину результата можно не считать
+	if (buffer && bufferSize >= size)
+		return static_cast<int>(Utf8ToWide(buffer, bufferSize, str, size));
 
+	const size_t count = WideLengthOf({ str, size });
+	if (!bufferSize || !buffer)
 		return static_cast<int>(count);
-	#else
-		#error Not implemented
+
+	return (count <= bufferSize) ? static_cast<int>(Utf8ToWide(buffer, bufferSize, str, size)) : -1;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+static void WideToMB(std::string& out, MBCodePage codePage, const wchar_t* str, size_t size)
+{
+	#if AML_OS_WINDOWS
+		if (codePage == MBCodePage::Ansi)
+		{
+			WideToAnsi(out, str, size);
+			return;
+		}
 	#endif
+
+	// См. комментарий в функции MBToWide
+	out.resize(Utf8LengthOf({ str, size }));
+	WideToUtf8(out.data(), out.size(), str, size);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+static int WideToMB(char* buffer, size_t bufferSize, MBCodePage codePage, const wchar_t* str, size_t size)
+{
+	#if AML_OS_WINDOWS
+		if (codePage == MBCodePage::Ansi)
+			return WideToAnsi(buffer, bufferSize, str, size);
+	#endif
+
+	if (size > INT_MAX)
+		return -1;
+
+	// Каждый символ Wide занимает в UTF-8 не более MAX_UTF8_PER_WIDE байт, поэтому если
+	// размер буфера заведомо достаточен, то длину результата можно не считать
+	if (buffer && size <= INT_MAX / MAX_UTF8_PER_WIDE && bufferSize / MAX_UTF8_PER_WIDE >= size)
+		return static_cast<int>(WideToUtf8(buffer, bufferSize, str, size));
+
+	const size_t count = Utf8LengthOf({ str, size });
+	if (count > INT_MAX)
+		return -1;
+	if (!bufferSize || !buffer)
+		return static_cast<int>(count);
+
+	return (count <= bufferSize) ? static_cast<int>(WideToUtf8(buffer, bufferSize, str, size)) : -1;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -1045,109 +1262,20 @@ int ToUtf8(char* buffer, size_t bufferSize, std::wstring_view str)
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-//--------------------------------------------------------------------------------------------------------------------------------
-template<class CharT, class ViewT = std::basic_string_view<CharT>>
-static size_t FindFirstOf(const ViewT str, const CharT* what, size_t from)
-{
-	if (what && *what)
-	{
-		const size_t len = str.size();
-		const CharT* p = str.data();
-
-		if (!what[1])
-		{
-			for (size_t i = from; i < len; ++i)
-			{
-				if (p[i] == *what)
-					return i;
-			}
-		} else
-		{
-			for (size_t i = from; i < len; ++i)
-			{
-				for (size_t j = 0; what[j]; ++j)
-				{
-					if (p[i] == what[j])
-						return i;
-				}
-			}
-		}
-	}
-
-	return ViewT::npos;
-}
-
 //--------------------------------------------------------------------------------------------------------------------------------
 template<class CharT, class StringT = std::basic_string<CharT>>
 static void Split(std::vector<StringT>& tokens, const std::basic_string_view<CharT> str,
-	const CharT* const delimiters, int flags)
+	const std::basic_string_view<CharT> delimiters, int flags)
 {
-	const size_t MAX_DELIMS = 32;
-	size_t delimPos[MAX_DELIMS];
-
-	const size_t len = str.size();
-	size_t tokenCount = 0, lastDelim = StringT::npos;
-	for (size_t fromPos = 0, delimCount = 0; fromPos < len;)
-	{
-		lastDelim = FindFirstOf(str, delimiters, fromPos);
-		if (delimCount < MAX_DELIMS)
-			delimPos[delimCount++] = lastDelim;
-		if (lastDelim == fromPos)
-		{
-			++fromPos;
-			if (flags & SPLIT_ALLOW_EMPTY)
-				++tokenCount;
-		} else
-		{
-			fromPos = (lastDelim == StringT::npos) ? len : lastDelim + 1;
-			++tokenCount;
-		}
-	}
-
-	const int TRAILING_FLAG = SPLIT_ALLOW_EMPTY | SPLIT_TRAILING_DELIMITER;
-	if ((flags & TRAILING_FLAG) == TRAILING_FLAG && lastDelim != StringT::npos)
-		++tokenCount;
-	else if (!tokenCount)
-		return;
-
-	tokens.reserve(tokenCount);
-	for (size_t fromPos = 0, delimIdx = 0; fromPos < len;)
-	{
-		lastDelim = (delimIdx < MAX_DELIMS) ? delimPos[delimIdx++] :
-			FindFirstOf(str, delimiters, fromPos);
-		if (lastDelim == fromPos)
-		{
-			++fromPos;
-			if (flags & SPLIT_ALLOW_EMPTY)
-				tokens.emplace_back();
-		} else
-		{
-			size_t tokenLen = ((lastDelim == StringT::npos) ? len : lastDelim) - fromPos;
-			auto left = str.data() + fromPos;
-			fromPos += tokenLen + 1;
-
-			if (flags & SPLIT_TRIM)
-			{
-				auto right = left + tokenLen - 1;
-				while (left <= right && (*left == 32 || *left == 9)) ++left;
-				if (left < right) while (*right == 32 || *right == 9) --right;
-				tokenLen = right - left + 1;
-			}
-
-			if (tokenLen || (flags & SPLIT_ALLOW_EMPTY))
-				tokens.emplace_back(left, tokenLen);
-		}
-	}
-
-	if ((flags & TRAILING_FLAG) == TRAILING_FLAG && lastDelim != StringT::npos)
-		tokens.emplace_back();
+	for (const auto token : BasicSplitView<CharT>(str, delimiters, flags))
+		tokens.emplace_back(token);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
 std::vector<std::string> Split(std::string_view str, ZStringView delimiters, int flags)
 {
 	std::vector<std::string> tokens;
-	Split(tokens, str, delimiters.c_str(), flags);
+	Split<char>(tokens, str, delimiters, flags);
 	return tokens;
 }
 
@@ -1155,7 +1283,7 @@ std::vector<std::string> Split(std::string_view str, ZStringView delimiters, int
 std::vector<std::wstring> Split(std::wstring_view str, WZStringView delimiters, int flags)
 {
 	std::vector<std::wstring> tokens;
-	Split(tokens, str, delimiters.c_str(), flags);
+	Split<wchar_t>(tokens, str, delimiters, flags);
 	return tokens;
 }
 
@@ -4,11 +4,14 @@
 
 #pragma once
 
+#include "charclass.h"
 #include "exception.h"
+#include "memory.h"
 #include "platform.h"
 #include "strcommon.h"
 #include "util.h"
 
+#include <iterator>
 #include <string>
 #include <string.h>
 #include <string_view>
@@ -279,7 +282,8 @@ inline int StrNCmp(const std::wstring& strA, const std::wstring& strB, size_t co
 // текущую локаль программы, если noLocale == false. Если параметр noLocale == true, то функции работают так, как если бы была
 // установлена "C" локаль, т.е. регистр символов изменяется только для латинских букв 'a'..'z' (для UpCase) и 'A'..'Z' (для
 // LoCase), а остальные символы не меняются. Значение параметра noLocale влияет на скорость работы функции: при значении
-// true скорость всегда значительно выше, особенно в случае, если локаль программы менялась. ПРИМЕЧАНИЕ: эти функции
+// true скорость всегда значительно выше, особенно в случае, если локаль программы менялась. На платформах, отличных от Windows,
+// Wide строки при noLocale == false преобразуются не по локали, а по таблицам Unicode (см. unicase.h). ПРИМЕЧАНИЕ: эти функции
 // всегда выполняют преобразование 1:1, т.е. например, из немецкой ß (нижний регистр) нельзя получить SS (верхний)
 std::string LoCase(std::string_view str, bool noLocale = false);
 std::wstring LoCase(std::wstring_view str, bool noLocale = false);
@@ -326,7 +330,8 @@ void TrimRightInplace(std::wstring& str, bool shrink = false);
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Преобразует Ansi строку в строку Wide, используя текущую системную локаль
+// Преобразует Ansi строку в строку Wide, используя текущую системную локаль. На платформах, отличных
+// от Windows, Ansi строками считаются строки UTF-8 (как в большинстве современных локалей)
 std::wstring FromAnsi(std::string_view str);
 
 // Преобразует Ansi строку str в строку Unicode (Wide) и сохраняет её в buffer. Параметр bufferSize задаёт размер буфера
@@ -350,7 +355,8 @@ int ToAnsi(char* buffer, size_t bufferSize, std::wstring_view str);
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Преобразует UTF-8 строку в строку Wide
+// Преобразует UTF-8 строку в строку Wide. Функции конвертации UTF-8/Wide не используют функции ОС (см. utf.h),
+// некорректные последовательности UTF-8 и непарные суррогаты UTF-16 заменяются символом U+FFFD
 std::wstring FromUtf8(std::string_view str);
 
 // Преобразует UTF-8 строку str в строку Unicode (Wide) и сохраняет её в buffer. Параметр bufferSize задаёт размер буфера
@@ -370,7 +376,7 @@ int ToUtf8(char* buffer, size_t bufferSize, std::wstring_view str);
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-//   Функция Split
+//   Функция Split и класс BasicSplitView
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -384,6 +390,162 @@ enum {
 std::vector<std::string> Split(std::string_view str, ZStringView delimiters, int flags = SPLIT_TRIM);
 std::vector<std::wstring> Split(std::wstring_view str, WZStringView delimiters, int flags = SPLIT_TRIM);
 
+// Класс BasicSplitView разбивает строку str на подстроки так же, как функция Split (с теми же флагами SPLIT_*), но не копирует
+// их: при обходе, например в цикле for по диапазону, подстроки возвращаются как std::basic_string_view, а очередная подстрока
+// ищется только при переходе к ней. Строка str должна существовать, пока используются объект и его итераторы. Разделители
+// задаются строкой или готовым объектом BasicCharClass (его стоит создать заранее, если одни и те же разделители
+// используются для многих строк). Такой объект не копируется и тоже должен существовать, пока используется BasicSplitView.
+// Пример: for (std::string_view field : util::SplitView(line, ";")) { ... }
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class CharT>
+class BasicSplitView
+{
+public:
+	using view_type = std::basic_string_view<CharT>;
+
+	class Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = view_type;
+		using difference_type = ptrdiff_t;
+		using pointer = const view_type*;
+		using reference = const view_type&;
+
+		// Создаёт итератор, указывающий на конец диапазона
+		Iterator() noexcept = default;
+
+		reference operator *() const noexcept { return m_Token; }
+		pointer operator ->() const noexcept { return &m_Token; }
+
+		Iterator& operator ++() noexcept
+		{
+			if (!Next())
+				*this = Iterator();
+			return *this;
+		}
+
+		Iterator operator ++(int) noexcept
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		bool operator ==(const Iterator& other) const noexcept
+		{
+			return m_Owner == other.m_Owner && m_Pos == other.m_Pos && m_Token.data() == other.m_Token.data() &&
+				m_Token.size() == other.m_Token.size();
+		}
+
+		bool operator !=(const Iterator& other) const noexcept { return !(*this == other); }
+
+	private:
+		friend class BasicSplitView;
+
+		explicit Iterator(const BasicSplitView* owner) noexcept
+			: m_Owner(owner)
+		{
+			++*this;
+		}
+
+		// Находит следующую подстроку. Возвращает false, если подстрок больше нет
+		bool Next() noexcept
+		{
+			const view_type str = m_Owner->m_Str;
+			const int flags = m_Owner->m_Flags;
+			const BasicCharClass<CharT>& delimiters = m_Owner->GetDelimiters();
+			const CharT* const end = str.data() + str.size();
+
+			while (m_Pos < str.size())
+			{
+				const CharT* const delimiter = delimiters.Find(str.data() + m_Pos, end);
+				const size_t delimiterPos = delimiter - str.data();
+				m_DelimiterFound = delimiter != end;
+
+				if (delimiterPos == m_Pos)
+				{
+					// Пустая подстрока между двумя разделителями (или перед первым разделителем)
+					++m_Pos;
+					if (flags & SPLIT_ALLOW_EMPTY)
+					{
+						m_Token = str.substr(m_Pos - 1, 0);
+						return true;
+					}
+					continue;
+				}
+
+				const CharT* left = str.data() + m_Pos;
+				const CharT* right = delimiter;
+				m_Pos = (delimiter != end) ? delimiterPos + 1 : str.size();
+
+				if (flags & SPLIT_TRIM)
+				{
+					while (left < right && (*left == 32 || *left == 9)) ++left;
+					while (left < right && (right[-1] == 32 || right[-1] == 9)) --right;
+				}
+
+				if (left != right || (flags & SPLIT_ALLOW_EMPTY))
+				{
+					m_Token = view_type(left, right - left);
+					return true;
+				}
+			}
+
+			// Разделитель в конце строки даёт ещё одну (пустую) подстроку
+			constexpr int TRAILING_FLAG = SPLIT_ALLOW_EMPTY | SPLIT_TRAILING_DELIMITER;
+			if ((flags & TRAILING_FLAG) == TRAILING_FLAG && m_DelimiterFound)
+			{
+				m_DelimiterFound = false;
+				m_Token = str.substr(str.size(), 0);
+				return true;
+			}
+
+			return false;
+		}
+
+		const BasicSplitView* m_Owner = nullptr;
+		view_type m_Token;				// Текущая подстрока
+		size_t m_Pos = 0;				// Позиция, с которой начинается поиск следующей подстроки
+		bool m_DelimiterFound = false;	// При последнем поиске был найден разделитель
+	};
+
+	BasicSplitView(view_type str, view_type delimiters, int flags = SPLIT_TRIM)
+		: m_Str(str)
+		, m_OwnDelimiters(delimiters)
+		, m_Flags(flags)
+	{
+	}
+
+	BasicSplitView(view_type str, const BasicCharClass<CharT>& delimiters, int flags = SPLIT_TRIM) noexcept
+		: m_Str(str)
+		, m_Delimiters(&delimiters)
+		, m_Flags(flags)
+	{
+	}
+
+	// Временный объект BasicCharClass был бы уничтожен раньше, чем закончится обход подстрок
+	BasicSplitView(view_type, BasicCharClass<CharT>&&, int = SPLIT_TRIM) = delete;
+
+	Iterator begin() const noexcept { return Iterator(this); }
+	Iterator end() const noexcept { return Iterator(); }
+
+private:
+	const BasicCharClass<CharT>& GetDelimiters() const noexcept
+	{
+		return m_Delimiters ? *m_Delimiters : m_OwnDelimiters;
+	}
+
+	view_type m_Str;										// Исходная строка
+	const BasicCharClass<CharT>* m_Delimiters = nullptr;	// Внешний набор символов-разделителей
+	BasicCharClass<CharT> m_OwnDelimiters;					// Набор разделителей, заданных строкой
+	int m_Flags;											// Флаги SPLIT_*
+};
+
+using SplitView = BasicSplitView<char>;
+using WSplitView = BasicSplitView<wchar_t>;
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //   StringWriter - вывод символьных данных в строку
@@ -392,7 +554,8 @@ std::vector<std::wstring> Split(std::wstring_view str, WZStringView delimiters,
 
 // Класс StringWriter - простой контейнер, предназначенный для вывода данных в строку. Хранит данные в виде массива.
 // Имеет внутренний буфер небольшого размера (размер в байтах задаётся параметром innerBuf шаблона). Автоматически
-// увеличивает свой размер по мере добавления новых данных
+// увеличивает свой размер по мере добавления новых данных. Массив в куче выделяется через источник памяти, заданный
+// в конструкторе, или через источник по умолчанию, действующий на момент первого выделения (см. GetDefaultResource)
 
 //--------------------------------------------------------------------------------------------------------------------------------
 template<class CharT, size_t innerBuf = 640>
@@ -407,10 +570,17 @@ public:
 	{
 	}
 
+	constexpr explicit StringWriter(std::pmr::memory_resource* resource) noexcept
+		: m_Data(m_Buffer)
+		, m_Capacity(INNER_CAPACITY)
+		, m_Resource(resource)
+	{
+	}
+
 	~StringWriter() noexcept
 	{
 		if (m_Capacity > INNER_CAPACITY)
-			delete[] m_Data;
+			FreeArray<CharT, alignof(CharT)>(m_Data, m_Capacity, m_Resource);
 	}
 
 	// Возвращает указатель на первый символ накопленных данных (начало
@@ -451,9 +621,10 @@ public:
 		CharT c = chr;
 		// Когда тип CharT не совпадает с типом chr, в общем случае требуется преобразование
 		// Ansi -> Wide. Если значение chr < 0x80, то оно не изменится при преобразовании.
-		// Но если значение выше, то мы заменим исходный символ на символ "�" (U+FFFD)
+		// Но если значение выше, то мы заменим исходный символ на символ "�" (U+FFFD). Тип char
+		// может быть знаковым, поэтому значение chr сравнивается как значение типа unsigned char
 		if constexpr (!std::is_same_v<CharT, char>)
-			c = (chr < 0x80) ? c : 0xfffd;
+			c = (static_cast<unsigned char>(chr) < 0x80) ? c : 0xfffd;
 
 		if (m_Size < m_Capacity)
 			m_Data[m_Size++] = c;
@@ -591,11 +762,14 @@ protected:
 					capacity = GetHugeSize(capacity);
 			}
 
+			if (!m_Resource)
+				m_Resource = GetDefaultResource();
+
 			auto old = m_Data;
-			m_Data = new CharT[capacity];
+			m_Data = AllocArray<CharT, alignof(CharT)>(capacity, m_Resource);
 			memcpy(m_Data, old, m_Size * sizeof(CharT));
 			if (m_Capacity > INNER_CAPACITY)
-				delete[] old;
+				FreeArray<CharT, alignof(CharT)>(old, m_Capacity, m_Resource);
 
 			m_Capacity = capacity;
 		} else
@@ -624,6 +798,9 @@ protected:
 	size_t m_Capacity = 0;		// Размер массива, на который указывает m_Data
 	size_t m_Size = 0;			// Количество символов в результирующей строке
 
+	// Источник памяти для массива в куче (nullptr, пока массив не выделялся)
+	std::pmr::memory_resource* m_Resource = nullptr;
+
 	// Внутренний буфер для выводимых данных
 	CharT m_Buffer[INNER_CAPACITY];
 };
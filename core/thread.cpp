@@ -23,6 +23,14 @@ unsigned GetThreadId()
 	#endif
 }
 
+//--------------------------------------------------------------------------------------------------------------------------------
+unsigned GetThreadIndex()
+{
+	static std::atomic<unsigned> nextIndex;
+	thread_local const unsigned index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+	return index;
+}
+
 //--------------------------------------------------------------------------------------------------------------------------------
 void CPUPause()
 {
@@ -10,6 +10,10 @@ namespace thrd {
 // пока этот поток не завершился, возвращённое значение уникально в пределах операционной системы
 unsigned GetThreadId();
 
+// Возвращает порядковый номер (0, 1, 2 и т.д.) потока, в контексте которого вызвана эта функция. Номер назначается потоку
+// при первом вызове функции и не переиспользуется после завершения потока. Подходит для распределения потоков по ячейкам
+unsigned GetThreadIndex();
+
 // Выполняет инструкцию pause на CPU Intel или аналогичную на других процессорах. Используется внутри
 // циклов ожидания для увеличения общей производительности системы и уменьшения её энергопотребления
 void CPUPause();
@@ -0,0 +1,717 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "unicase.h"
+
+#include "fasthash.h"
+
+using namespace util;
+
+namespace {
+
+// Разности между кодами символов, в которые переводится символ, и кодом самого символа
+struct CaseRecord {
+	int32_t lower;		// Нижний регистр
+	int32_t upper;		// Верхний регистр
+	int32_t fold;		// Свёртка регистра
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Таблицы преобразования регистра
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Таблицы сгенерированы из файлов UnicodeData.txt (поля Simple_Lowercase_Mapping и Simple_Uppercase_Mapping) и CaseFolding.txt
+// (статусы C и S) версии Unicode 14.0. Символы с кодами от 0 до MAX_CASED_CHAR разбиты на блоки по 128 символов. Для символа
+// c элемент CASE_INDEX[c >> 7] - это номер блока в массиве CASE_BLOCKS, а элемент блока с индексом c & 127 - это номер записи
+// в массиве CASE_RECORDS. Одинаковые блоки хранятся один раз, а запись с индексом 0 (без преобразования) соответствует
+// всем символам, у которых нет регистра. Благодаря этому таблицы занимают около 8 Кб. Таблицы генерируются скриптом
+// tools/unicase.py, поэтому изменять их вручную не следует
+
+constexpr char32_t MAX_CASED_CHAR = 0x1e944;
+constexpr unsigned CASE_BLOCK_SHIFT = 7;
+
+const uint8_t CASE_INDEX[979] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 13, 12, 12, 12, 12, 12, 14, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 15, 16, 17, 18, 19, 20, 21, 12, 12, 22, 23, 12, 12, 12, 12, 12, 24, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 25, 26, 27, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 28, 29, 30, 31,
+	12, 12, 12, 12, 12, 12, 32, 33, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 34, 12, 12, 12, 12, 12, 12, 12, 12, 12, 35, 36, 37, 38, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 39, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 40, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 41, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 42
+};
+
+const uint8_t CASE_BLOCKS[43][128] = {
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 150, 150, 150, 150, 150, 150, 150,
+		150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 0, 0, 0, 0, 0,
+		0, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92,
+		92, 92, 92, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 119, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 150, 150, 150, 150, 150, 150, 150, 150,
+		150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 0, 150, 150, 150, 150, 150, 150, 150, 0,
+		92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 0,
+		92, 92, 92, 92, 92, 92, 92, 113
+	},
+	{
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		25, 57, 142, 101, 142, 101, 142, 101, 0, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142,
+		101, 0, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		31, 142, 101, 142, 101, 142, 101, 56
+	},
+	{
+		118, 170, 142, 101, 142, 101, 167, 142, 101, 166, 166, 142, 101, 0, 161, 164, 165, 142, 101, 166, 168, 110, 171, 169,
+		142, 101, 117, 0, 171, 172, 116, 173, 142, 101, 142, 101, 142, 101, 175, 142, 101, 175, 0, 0, 142, 101, 175, 142,
+		101, 174, 174, 142, 101, 142, 101, 176, 142, 101, 0, 0, 142, 101, 0, 106, 0, 0, 0, 0, 143, 141, 100, 143,
+		141, 100, 143, 141, 100, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 76, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 0, 143, 141, 100, 142, 101, 34, 38,
+		142, 101, 142, 101, 142, 101, 142, 101
+	},
+	{
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 28, 0, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 0, 0, 0, 0, 0, 0, 180, 142, 101, 27, 179, 128, 128, 142, 101, 26, 159, 160, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 127, 125, 126, 64, 67, 0, 68, 68, 0, 70, 0, 69, 140, 0, 0, 0,
+		68, 139, 0, 66, 0, 134, 138, 0, 65, 63, 138, 123, 136, 0, 0, 63, 0, 124, 62, 0, 0, 61, 0, 0,
+		0, 0, 0, 0, 0, 122, 0, 0
+	},
+	{
+		59, 0, 137, 59, 0, 0, 0, 135, 59, 78, 60, 60, 77, 0, 0, 0, 0, 0, 58, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 133, 132, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 108, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 142, 101, 142, 101, 0, 0, 142, 101,
+		0, 0, 0, 116, 116, 116, 0, 163
+	},
+	{
+		0, 0, 0, 0, 0, 0, 153, 0, 152, 152, 152, 0, 158, 0, 157, 157, 0, 150, 150, 150, 150, 150, 150, 150,
+		150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 0, 150, 150, 150, 150, 150, 150, 150, 150, 150, 89, 90, 90, 90,
+		0, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 93, 92, 92, 92, 92, 92,
+		92, 92, 92, 92, 79, 80, 80, 145, 81, 83, 0, 0, 0, 86, 84, 99, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 73, 74, 102, 71, 37, 72, 0, 142,
+		101, 42, 142, 101, 0, 28, 28, 28
+	},
+	{
+		162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 150, 150, 150, 150, 150, 150, 150, 150,
+		150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150,
+		92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92,
+		92, 92, 92, 92, 92, 92, 92, 92, 75, 75, 75, 75, 75, 75, 75, 75, 75, 75, 75, 75, 75, 75, 75, 75,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101
+	},
+	{
+		142, 101, 0, 0, 0, 0, 0, 0, 0, 0, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 146, 142, 101, 142, 101, 142, 101, 142,
+		101, 142, 101, 142, 101, 142, 101, 97, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101
+	},
+	{
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		0, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156,
+		156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85,
+		85, 85, 85, 85, 85, 85, 85, 85
+	},
+	{
+		85, 85, 85, 85, 85, 85, 85, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178,
+		178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 0, 178,
+		0, 0, 0, 0, 0, 178, 0, 0, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120,
+		120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120, 120,
+		120, 120, 120, 0, 0, 120, 120, 120
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181,
+		181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181,
+		181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181,
+		181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 144, 144, 144, 144, 144, 144, 0, 0,
+		98, 98, 98, 98, 98, 98, 0, 0
+	},
+	{
+		48, 49, 50, 52, 52, 51, 53, 54, 129, 0, 0, 0, 0, 0, 0, 0, 24, 24, 24, 24, 24, 24, 24, 24,
+		24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24,
+		24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 0, 0, 24, 24, 24, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 130, 0, 0, 0, 121, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 131, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101
+	},
+	{
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 0, 0,
+		0, 0, 0, 82, 0, 0, 21, 0, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101
+	},
+	{
+		103, 103, 103, 103, 103, 103, 103, 103, 41, 41, 41, 41, 41, 41, 41, 41, 103, 103, 103, 103, 103, 103, 0, 0,
+		41, 41, 41, 41, 41, 41, 0, 0, 103, 103, 103, 103, 103, 103, 103, 103, 41, 41, 41, 41, 41, 41, 41, 41,
+		103, 103, 103, 103, 103, 103, 103, 103, 41, 41, 41, 41, 41, 41, 41, 41, 103, 103, 103, 103, 103, 103, 0, 0,
+		41, 41, 41, 41, 41, 41, 0, 0, 0, 103, 0, 103, 0, 103, 0, 103, 0, 41, 0, 41, 0, 41, 0, 41,
+		103, 103, 103, 103, 103, 103, 103, 103, 41, 41, 41, 41, 41, 41, 41, 41, 107, 107, 109, 109, 109, 109, 111, 111,
+		115, 115, 112, 112, 114, 114, 0, 0
+	},
+	{
+		103, 103, 103, 103, 103, 103, 103, 103, 41, 41, 41, 41, 41, 41, 41, 41, 103, 103, 103, 103, 103, 103, 103, 103,
+		41, 41, 41, 41, 41, 41, 41, 41, 103, 103, 103, 103, 103, 103, 103, 103, 41, 41, 41, 41, 41, 41, 41, 41,
+		103, 103, 0, 104, 0, 0, 0, 0, 41, 41, 36, 36, 40, 0, 47, 0, 0, 0, 0, 104, 0, 0, 0, 0,
+		35, 35, 35, 35, 40, 0, 0, 0, 103, 103, 0, 0, 0, 0, 0, 0, 41, 41, 33, 33, 0, 0, 0, 0,
+		103, 103, 0, 0, 0, 102, 0, 0, 41, 41, 32, 32, 42, 0, 0, 0, 0, 0, 0, 104, 0, 0, 0, 0,
+		29, 29, 30, 30, 40, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 22, 0, 0, 0, 19, 20, 0, 0, 0, 0,
+		0, 0, 149, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 94, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 96, 96, 96, 96, 96, 96, 96, 96,
+		96, 96, 96, 96, 96, 96, 96, 96
+	},
+	{
+		0, 0, 0, 142, 101, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148,
+		148, 148, 148, 148, 148, 148, 148, 148, 95, 95, 95, 95, 95, 95, 95, 95, 95, 95, 95, 95, 95, 95, 95, 95,
+		95, 95, 95, 95, 95, 95, 95, 95, 95, 95, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156,
+		156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156, 156,
+		85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85,
+		85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85,
+		142, 101, 17, 23, 18, 44, 45, 142, 101, 142, 101, 142, 101, 15, 16, 13, 14, 0, 142, 101, 0, 142, 101, 0,
+		0, 0, 0, 0, 0, 0, 12, 12
+	},
+	{
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 0, 0, 0, 0, 0, 0, 0, 142, 101, 142, 101, 0, 0, 0, 142, 101, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46,
+		46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 0, 46, 0, 0, 0, 0, 0, 46, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		0, 0, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 142, 101, 142, 101, 11, 142, 101
+	},
+	{
+		142, 101, 142, 101, 142, 101, 142, 101, 0, 0, 0, 142, 101, 7, 0, 0, 142, 101, 142, 101, 105, 0, 142, 101,
+		142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 3, 1, 2, 5, 3, 0,
+		9, 6, 8, 177, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 142, 101, 39, 4, 10, 142,
+		101, 142, 101, 0, 0, 0, 0, 0, 142, 101, 0, 0, 0, 0, 142, 101, 142, 101, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 142, 101, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 55, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 43, 43, 43, 43, 43, 43, 43, 43,
+		43, 43, 43, 43, 43, 43, 43, 43
+	},
+	{
+		43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43,
+		43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43,
+		43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150,
+		150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 0, 0, 0, 0, 0, 0, 92, 92, 92, 92, 92, 92, 92,
+		92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155,
+		155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 87, 87, 87, 87, 87, 87, 87, 87,
+		87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87,
+		87, 87, 87, 87, 87, 87, 87, 87, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155,
+		155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 155, 0, 0, 0, 0, 87, 87, 87, 87, 87, 87, 87, 87,
+		87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87, 87,
+		87, 87, 87, 87, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 154, 154, 154, 154, 154, 154, 154, 154,
+		154, 154, 154, 0, 154, 154, 154, 154
+	},
+	{
+		154, 154, 154, 154, 154, 154, 154, 154, 154, 154, 154, 0, 154, 154, 154, 154, 154, 154, 154, 0, 154, 154, 0, 88,
+		88, 88, 88, 88, 88, 88, 88, 88, 88, 88, 0, 88, 88, 88, 88, 88, 88, 88, 88, 88, 88, 88, 88, 88,
+		88, 88, 0, 88, 88, 88, 88, 88, 88, 88, 0, 88, 88, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158,
+		158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158, 158,
+		158, 158, 158, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 79, 79, 79, 79, 79, 79, 79, 79,
+		79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79,
+		79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150,
+		150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 92, 92, 92, 92, 92, 92, 92, 92,
+		92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 150, 150, 150, 150, 150, 150, 150, 150,
+		150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150, 150,
+		92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92,
+		92, 92, 92, 92, 92, 92, 92, 92
+	},
+	{
+		151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 151,
+		151, 151, 151, 151, 151, 151, 151, 151, 151, 151, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91,
+		91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 91, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0
+	}
+};
+
+const CaseRecord CASE_RECORDS[182] = {
+	{ 0, 0, 0 }, { -42319, 0, -42319 }, { -42315, 0, -42315 }, { -42308, 0, -42308 }, { -42307, 0, -42307 },
+	{ -42305, 0, -42305 }, { -42282, 0, -42282 }, { -42280, 0, -42280 }, { -42261, 0, -42261 }, { -42258, 0, -42258 },
+	{ -35384, 0, -35384 }, { -35332, 0, -35332 }, { -10815, 0, -10815 }, { -10783, 0, -10783 }, { -10782, 0, -10782 },
+	{ -10780, 0, -10780 }, { -10749, 0, -10749 }, { -10743, 0, -10743 }, { -10727, 0, -10727 }, { -8383, 0, -8383 },
+	{ -8262, 0, -8262 }, { -7615, 0, -7615 }, { -7517, 0, -7517 }, { -3814, 0, -3814 }, { -3008, 0, -3008 },
+	{ -199, 0, 0 }, { -195, 0, -195 }, { -163, 0, -163 }, { -130, 0, -130 }, { -128, 0, -128 },
+	{ -126, 0, -126 }, { -121, 0, -121 }, { -112, 0, -112 }, { -100, 0, -100 }, { -97, 0, -97 },
+	{ -86, 0, -86 }, { -74, 0, -74 }, { -60, 0, -60 }, { -56, 0, -56 }, { -48, 0, -48 },
+	{ -9, 0, -9 }, { -8, 0, -8 }, { -7, 0, -7 }, { 0, -38864, -38864 }, { 0, -10795, 0 },
+	{ 0, -10792, 0 }, { 0, -7264, 0 }, { 0, -7205, -7173 }, { 0, -6254, -6222 }, { 0, -6253, -6221 },
+	{ 0, -6244, -6212 }, { 0, -6243, -6211 }, { 0, -6242, -6210 }, { 0, -6236, -6204 }, { 0, -6181, -6180 },
+	{ 0, -928, 0 }, { 0, -300, -268 }, { 0, -232, 0 }, { 0, -219, 0 }, { 0, -218, 0 },
+	{ 0, -217, 0 }, { 0, -214, 0 }, { 0, -213, 0 }, { 0, -211, 0 }, { 0, -210, 0 },
+	{ 0, -209, 0 }, { 0, -207, 0 }, { 0, -206, 0 }, { 0, -205, 0 }, { 0, -203, 0 },
+	{ 0, -202, 0 }, { 0, -116, 0 }, { 0, -96, -64 }, { 0, -86, -54 }, { 0, -80, -48 },
+	{ 0, -80, 0 }, { 0, -79, 0 }, { 0, -71, 0 }, { 0, -69, 0 }, { 0, -64, 0 },
+	{ 0, -63, 0 }, { 0, -62, -30 }, { 0, -59, -58 }, { 0, -57, -25 }, { 0, -54, -22 },
+	{ 0, -48, 0 }, { 0, -47, -15 }, { 0, -40, 0 }, { 0, -39, 0 }, { 0, -38, 0 },
+	{ 0, -37, 0 }, { 0, -34, 0 }, { 0, -32, 0 }, { 0, -31, 1 }, { 0, -28, 0 },
+	{ 0, -26, 0 }, { 0, -16, 0 }, { 0, -15, 0 }, { 0, -8, -8 }, { 0, -8, 0 },
+	{ 0, -2, 0 }, { 0, -1, 0 }, { 0, 7, 0 }, { 0, 8, 0 }, { 0, 9, 0 },
+	{ 0, 48, 0 }, { 0, 56, 0 }, { 0, 74, 0 }, { 0, 84, 116 }, { 0, 86, 0 },
+	{ 0, 97, 0 }, { 0, 100, 0 }, { 0, 112, 0 }, { 0, 121, 0 }, { 0, 126, 0 },
+	{ 0, 128, 0 }, { 0, 130, 0 }, { 0, 163, 0 }, { 0, 195, 0 }, { 0, 743, 775 },
+	{ 0, 3008, 0 }, { 0, 3814, 0 }, { 0, 10727, 0 }, { 0, 10743, 0 }, { 0, 10749, 0 },
+	{ 0, 10780, 0 }, { 0, 10782, 0 }, { 0, 10783, 0 }, { 0, 10815, 0 }, { 0, 35266, 35267 },
+	{ 0, 35332, 0 }, { 0, 35384, 0 }, { 0, 42258, 0 }, { 0, 42261, 0 }, { 0, 42280, 0 },
+	{ 0, 42282, 0 }, { 0, 42305, 0 }, { 0, 42307, 0 }, { 0, 42308, 0 }, { 0, 42315, 0 },
+	{ 0, 42319, 0 }, { 1, -1, 1 }, { 1, 0, 1 }, { 2, 0, 2 }, { 8, 0, 0 },
+	{ 8, 0, 8 }, { 15, 0, 15 }, { 16, 0, 16 }, { 26, 0, 26 }, { 28, 0, 28 },
+	{ 32, 0, 32 }, { 34, 0, 34 }, { 37, 0, 37 }, { 38, 0, 38 }, { 39, 0, 39 },
+	{ 40, 0, 40 }, { 48, 0, 48 }, { 63, 0, 63 }, { 64, 0, 64 }, { 69, 0, 69 },
+	{ 71, 0, 71 }, { 79, 0, 79 }, { 80, 0, 80 }, { 116, 0, 116 }, { 202, 0, 202 },
+	{ 203, 0, 203 }, { 205, 0, 205 }, { 206, 0, 206 }, { 207, 0, 207 }, { 209, 0, 209 },
+	{ 210, 0, 210 }, { 211, 0, 211 }, { 213, 0, 213 }, { 214, 0, 214 }, { 217, 0, 217 },
+	{ 218, 0, 218 }, { 219, 0, 219 }, { 928, 0, 928 }, { 7264, 0, 7264 }, { 10792, 0, 10792 },
+	{ 10795, 0, 10795 }, { 38864, 0, 0 }
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline const CaseRecord& GetCaseRecord(char32_t c) noexcept
+{
+	if (c >= MAX_CASED_CHAR)
+		return CASE_RECORDS[0];
+
+	constexpr char32_t BLOCK_MASK = (1 << CASE_BLOCK_SHIFT) - 1;
+	return CASE_RECORDS[CASE_BLOCKS[CASE_INDEX[c >> CASE_BLOCK_SHIFT]][c & BLOCK_MASK]];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Чтение символов строк
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Байты некорректных последовательностей UTF-8 читаются по одному и обозначаются значениями
+// INVALID_BYTE + байт, которые не совпадают ни с одним символом Unicode и не имеют регистра
+constexpr char32_t INVALID_BYTE = 0x110000;
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline char32_t NextChar(const uint8_t*& str, const uint8_t* end) noexcept
+{
+	const unsigned c = *str++;
+	if (c < 0x80)
+		return c;
+
+	char32_t codePoint, minValue;
+	size_t count;
+	if (c >= 0xc2 && c < 0xe0)
+		codePoint = c & 0x1f, minValue = 0x80, count = 1;
+	else if (c >= 0xe0 && c < 0xf0)
+		codePoint = c & 0x0f, minValue = 0x800, count = 2;
+	else if (c >= 0xf0 && c < 0xf5)
+		codePoint = c & 0x07, minValue = 0x10000, count = 3;
+	else
+		return INVALID_BYTE + c;
+
+	if (static_cast<size_t>(end - str) < count)
+		return INVALID_BYTE + c;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		if ((str[i] & 0xc0) != 0x80)
+			return INVALID_BYTE + c;
+		codePoint = (codePoint << 6) | (str[i] & 0x3f);
+	}
+
+	// Избыточные последовательности, суррогаты и символы больше 0x10ffff некорректны
+	if (codePoint < minValue || codePoint > 0x10ffff || (codePoint >= 0xd800 && codePoint < 0xe000))
+		return INVALID_BYTE + c;
+
+	str += count;
+	return codePoint;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline char32_t NextChar(const wchar_t*& str, const wchar_t* end) noexcept
+{
+	// На некоторых платформах тип wchar_t знаковый
+	const char32_t c = static_cast<std::make_unsigned_t<wchar_t>>(*str++);
+
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		if (c >= 0xd800 && c < 0xdc00 && str != end)
+		{
+			const char32_t next = static_cast<std::make_unsigned_t<wchar_t>>(*str);
+			if (next >= 0xdc00 && next < 0xe000)
+			{
+				++str;
+				return 0x10000 + ((c - 0xd800) << 10) + (next - 0xdc00);
+			}
+		}
+	}
+
+	return c;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline wchar_t* PutChar(wchar_t* out, char32_t c) noexcept
+{
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		if (c >= 0x10000)
+		{
+			c -= 0x10000;
+			*out++ = static_cast<wchar_t>(0xd800 + (c >> 10));
+			*out++ = static_cast<wchar_t>(0xdc00 + (c & 0x3ff));
+			return out;
+		}
+	}
+
+	*out++ = static_cast<wchar_t>(c);
+	return out;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Реализация функций
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<int32_t CaseRecord::*delta>
+void ChangeCase(wchar_t* str, size_t size) noexcept
+{
+	// Символ и результат его преобразования всегда занимают одинаковое
+	// количество элементов wchar_t (суррогатная пара остаётся парой)
+	const wchar_t* p = str;
+	const wchar_t* const end = str + size;
+	while (p != end)
+	{
+		const char32_t c = NextChar(p, end);
+		str = PutChar(str, c + GetCaseRecord(c).*delta);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+int FoldCompare(const T* strA, const T* endA, const T* strB, const T* endB) noexcept
+{
+	while (strA != endA && strB != endB)
+	{
+		const char32_t a = NextChar(strA, endA);
+		const char32_t b = NextChar(strB, endB);
+		if (a != b)
+		{
+			const char32_t foldedA = a + GetCaseRecord(a).fold;
+			const char32_t foldedB = b + GetCaseRecord(b).fold;
+			if (foldedA != foldedB)
+				return (foldedA < foldedB) ? -1 : 1;
+		}
+	}
+
+	return (strA != endA) ? 1 : (strB != endB) ? -1 : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class T>
+unsigned FoldHash(const T* str, const T* end) noexcept
+{
+	// Хешируются байты UTF-8 символов после свёртки регистра. Байты некорректных последовательностей UTF-8 (а также
+	// значения wchar_t больше 0x10ffff) хешируются как один байт. Байты накапливаются в буфере, чтобы хешировать их блоками
+	uint8_t buffer[128];
+	unsigned hash = hash::GetFastHash();
+	size_t size = 0;
+
+	while (str != end)
+	{
+		if (size > sizeof(buffer) - 4)
+		{
+			hash = hash::GetFastHash(buffer, size, hash);
+			size = 0;
+		}
+
+		char32_t c = NextChar(str, end);
+		c += GetCaseRecord(c).fold;
+
+		if (c < 0x80)
+		{
+			buffer[size++] = static_cast<uint8_t>(c);
+		}
+		else if (c < 0x800)
+		{
+			buffer[size++] = static_cast<uint8_t>(0xc0 | (c >> 6));
+			buffer[size++] = static_cast<uint8_t>(0x80 | (c & 0x3f));
+		}
+		else if (c < 0x10000)
+		{
+			buffer[size++] = static_cast<uint8_t>(0xe0 | (c >> 12));
+			buffer[size++] = static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3f));
+			buffer[size++] = static_cast<uint8_t>(0x80 | (c & 0x3f));
+		}
+		else if (c < INVALID_BYTE)
+		{
+			buffer[size++] = static_cast<uint8_t>(0xf0 | (c >> 18));
+			buffer[size++] = static_cast<uint8_t>(0x80 | ((c >> 12) & 0x3f));
+			buffer[size++] = static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3f));
+			buffer[size++] = static_cast<uint8_t>(0x80 | (c & 0x3f));
+		} else
+			buffer[size++] = static_cast<uint8_t>(c);
+	}
+
+	return hash::GetFastHash(buffer, size, hash);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Регистр символов Unicode
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+char32_t util::ToLowerChar(char32_t c) noexcept
+{
+	return c + GetCaseRecord(c).lower;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+char32_t util::ToUpperChar(char32_t c) noexcept
+{
+	return c + GetCaseRecord(c).upper;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+char32_t util::FoldCaseChar(char32_t c) noexcept
+{
+	return c + GetCaseRecord(c).fold;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void util::ToLowerInplace(wchar_t* str, size_t size) noexcept
+{
+	ChangeCase<&CaseRecord::lower>(str, size);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void util::ToUpperInplace(wchar_t* str, size_t size) noexcept
+{
+	ChangeCase<&CaseRecord::upper>(str, size);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Сравнение и хеширование строк без учёта регистра
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+int util::StrFoldCmp(std::string_view strA, std::string_view strB) noexcept
+{
+	auto a = reinterpret_cast<const uint8_t*>(strA.data());
+	auto b = reinterpret_cast<const uint8_t*>(strB.data());
+	return FoldCompare(a, a + strA.size(), b, b + strB.size());
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+int util::StrFoldCmp(std::wstring_view strA, std::wstring_view strB) noexcept
+{
+	return FoldCompare(strA.data(), strA.data() + strA.size(), strB.data(), strB.data() + strB.size());
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+unsigned util::GetFoldHash(std::string_view str) noexcept
+{
+	auto p = reinterpret_cast<const uint8_t*>(str.data());
+	return FoldHash(p, p + str.size());
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+unsigned util::GetFoldHash(std::wstring_view str) noexcept
+{
+	return FoldHash(str.data(), str.data() + str.size());
+}
@@ -0,0 +1,58 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "platform.h"
+
+#include <stddef.h>
+#include <string_view>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Регистр символов Unicode
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функции этого раздела выполняют простое (1:1) преобразование регистра и свёртку регистра (case folding) символов Unicode по
+// таблицам, построенным из файлов UnicodeData.txt и CaseFolding.txt (Unicode 14.0). В отличие от функций towlower/towupper,
+// результат не зависит от локали и платформы. Преобразования, при которых меняется количество символов (например, из ß
+// в SS), не выполняются. Символы, для которых нет преобразования, а также некорректные значения остаются без изменений
+
+// Возвращает символ c, переведённый в нижний (ToLowerChar) или верхний (ToUpperChar) регистр
+char32_t ToLowerChar(char32_t c) noexcept;
+char32_t ToUpperChar(char32_t c) noexcept;
+
+// Возвращает символ c после свёртки регистра. Символы, отличающиеся только регистром, дают одинаковый результат (обычно
+// это символ нижнего регистра). Для сравнения строк без учёта регистра следует использовать свёртку, а не ToLowerChar
+char32_t FoldCaseChar(char32_t c) noexcept;
+
+// Переводят size символов строки str в нижний (ToLowerInplace) или верхний (ToUpperInplace) регистр. Если размер
+// типа wchar_t равен 2 байтам, то строка считается строкой UTF-16. Длина строки при этом никогда не меняется
+void ToLowerInplace(wchar_t* str, size_t size) noexcept;
+void ToUpperInplace(wchar_t* str, size_t size) noexcept;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Сравнение и хеширование строк без учёта регистра
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функция StrFoldCmp сравнивает строки strA и strB после свёртки регистра их символов и возвращает -1, 0 или 1 (порядок
+// определяется кодами символов). Строки char считаются строками UTF-8, строки Wide - строками UTF-16 или UTF-32 (в
+// зависимости от размера типа wchar_t). Байты некорректных последовательностей UTF-8 и непарные суррогаты сравниваются
+// как отдельные значения (строки с разными некорректными последовательностями не равны друг другу)
+int StrFoldCmp(std::string_view strA, std::string_view strB) noexcept;
+int StrFoldCmp(std::wstring_view strA, std::wstring_view strB) noexcept;
+
+// Функция GetFoldHash вычисляет 32-битный хеш (FNV-1a) строки str после свёртки регистра её символов. Строки, равные
+// с точки зрения функции StrFoldCmp, дают одинаковый хеш. Хеш строки Wide равен хешу той же строки в UTF-8. Только для
+// строки UTF-8 из символов ASCII хеш совпадает со значением hash::GetFastHash(str, true): функция GetFastHash хеширует
+// строки Wide по символам wchar_t, а не по байтам UTF-8, поэтому для них значения различаются
+unsigned GetFoldHash(std::string_view str) noexcept;
+unsigned GetFoldHash(std::wstring_view str) noexcept;
+
+} // namespace util
@@ -0,0 +1,821 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#include "pch.h"
+#include "utf.h"
+
+#include "util.h"
+
+#include <array>
+#include <type_traits>
+
+#if AML_SSE2
+	#include <emmintrin.h>
+#endif
+#if AML_AVX2
+	#include <immintrin.h>
+#endif
+
+using namespace util;
+
+namespace {
+
+// Символ, которым заменяются некорректные последовательности
+constexpr char32_t REPLACEMENT_CHAR = 0xfffd;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Обработка отдельных символов
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline char32_t ToCodePoint(wchar_t c) noexcept
+{
+	// На некоторых платформах тип wchar_t знаковый
+	return static_cast<std::make_unsigned_t<wchar_t>>(c);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline char32_t DecodeUtf8(const uint8_t*& str, const uint8_t* end) noexcept
+{
+	const unsigned c = *str++;
+	if (c < 0x80)
+		return c;
+
+	// Допустимые значения второго байта последовательности зависят от первого байта: они исключают
+	// избыточные (overlong) последовательности, суррогаты и символы со значениями больше 0x10ffff
+	unsigned lo = 0x80, hi = 0xbf;
+	unsigned codePoint, count;
+	if (c < 0xc2)
+	{
+		return REPLACEMENT_CHAR;
+	}
+	else if (c < 0xe0)
+	{
+		if (str == end || (*str & 0xc0) != 0x80)
+			return REPLACEMENT_CHAR;
+
+		return ((c & 0x1f) << 6) | (*str++ & 0x3f);
+	}
+	else if (c < 0xf0)
+	{
+		codePoint = c & 0x0f;
+		count = 2;
+		if (c == 0xe0)
+			lo = 0xa0;
+		else if (c == 0xed)
+			hi = 0x9f;
+	}
+	else if (c < 0xf5)
+	{
+		codePoint = c & 0x07;
+		count = 3;
+		if (c == 0xf0)
+			lo = 0x90;
+		else if (c == 0xf4)
+			hi = 0x8f;
+	} else
+		return REPLACEMENT_CHAR;
+
+	for (; count; --count)
+	{
+		if (str == end || *str < lo || *str > hi)
+			return REPLACEMENT_CHAR;
+
+		codePoint = (codePoint << 6) | (*str++ & 0x3f);
+		lo = 0x80, hi = 0xbf;
+	}
+
+	return codePoint;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline wchar_t* EncodeWide(wchar_t* out, char32_t codePoint) noexcept
+{
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		if (codePoint > 0xffff)
+		{
+			codePoint -= 0x10000;
+			*out++ = static_cast<wchar_t>(0xd800 + (codePoint >> 10));
+			*out++ = static_cast<wchar_t>(0xdc00 + (codePoint & 0x3ff));
+			return out;
+		}
+	}
+
+	*out++ = static_cast<wchar_t>(codePoint);
+	return out;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline char32_t DecodeWide(const wchar_t*& str, const wchar_t* end) noexcept
+{
+	const char32_t c = ToCodePoint(*str++);
+	if (c - 0xd800 < 0x800)
+	{
+		if constexpr (sizeof(wchar_t) == 2)
+		{
+			if (c < 0xdc00 && str != end)
+			{
+				if (const char32_t c2 = ToCodePoint(*str); c2 - 0xdc00 < 0x400)
+				{
+					++str;
+					return 0x10000 + ((c - 0xd800) << 10) + (c2 - 0xdc00);
+				}
+			}
+		}
+
+		return REPLACEMENT_CHAR;
+	}
+
+	return (c <= 0x10ffff) ? c : REPLACEMENT_CHAR;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline char* EncodeUtf8(char* out, char32_t codePoint) noexcept
+{
+	if (codePoint < 0x80)
+	{
+		*out++ = static_cast<char>(codePoint);
+	}
+	else if (codePoint < 0x800)
+	{
+		*out++ = static_cast<char>(0xc0 | (codePoint >> 6));
+		*out++ = static_cast<char>(0x80 | (codePoint & 0x3f));
+	}
+	else if (codePoint < 0x10000)
+	{
+		*out++ = static_cast<char>(0xe0 | (codePoint >> 12));
+		*out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+		*out++ = static_cast<char>(0x80 | (codePoint & 0x3f));
+	} else
+	{
+		*out++ = static_cast<char>(0xf0 | (codePoint >> 18));
+		*out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+		*out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+		*out++ = static_cast<char>(0x80 | (codePoint & 0x3f));
+	}
+
+	return out;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline size_t GetUtf8Size(char32_t codePoint) noexcept
+{
+	return (codePoint < 0x80) ? 1 : (codePoint < 0x800) ? 2 : (codePoint < 0x10000) ? 3 : 4;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline size_t GetWideSize(char32_t codePoint) noexcept
+{
+	return (sizeof(wchar_t) == 2 && codePoint > 0xffff) ? 2 : 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Обработка блоков символов (SSE2/AVX2)
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функции этого раздела перекодируют блок, только если все его символы подходят для этой функции, иначе они возвращают
+// false (или 0) и ничего не делают. Функции записывают в выходной буфер весь регистр, что может выходить за пределы
+// перекодированных символов. Поэтому блоки обрабатываются, только пока до конца строки есть не менее 16 байт (UTF-8)
+// или 8 символов (Wide), а в выходном буфере остаётся место как минимум для 16 символов (Wide) или байт (UTF-8)
+
+#if AML_SSE2
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline __m128i Load(const void* p) noexcept
+{
+	return _mm_loadu_si128(static_cast<const __m128i*>(p));
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline void Store(void* p, __m128i v) noexcept
+{
+	_mm_storeu_si128(static_cast<__m128i*>(p), v);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline void StoreWide8(wchar_t* out, __m128i v) noexcept
+{
+	// Записывает в out 8 символов из 16-битных элементов регистра v
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		Store(out, v);
+	} else
+	{
+		const __m128i zero = _mm_setzero_si128();
+		Store(out, _mm_unpacklo_epi16(v, zero));
+		Store(out + 4, _mm_unpackhi_epi16(v, zero));
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline void StoreAscii16(wchar_t* out, __m128i v) noexcept
+{
+	const __m128i zero = _mm_setzero_si128();
+	StoreWide8(out, _mm_unpacklo_epi8(v, zero));
+	StoreWide8(out + 8, _mm_unpackhi_epi8(v, zero));
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline __m128i LoadWide8(const wchar_t* str, __m128i& small) noexcept
+{
+	// Загружает 8 символов в 16-битные элементы регистра. В маске small отмечаются элементы,
+	// значения которых умещаются в 16 бит (для 16-битного типа wchar_t это все элементы)
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		small = _mm_set1_epi32(-1);
+		return Load(str);
+	} else
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i a = Load(str), b = Load(str + 4);
+		small = _mm_packs_epi32(_mm_cmpeq_epi32(_mm_srli_epi32(a, 16), zero), _mm_cmpeq_epi32(_mm_srli_epi32(b, 16), zero));
+		// Инструкция packs_epi32 упаковывает с насыщением, поэтому младшие 16 бит предварительно расширяем знаком
+		return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline bool Utf8ToWide2(wchar_t* out, __m128i v) noexcept
+{
+	// 8 последовательностей 2-байтовых символов: каждая пара байт блока - 16-битное слово b0 | b1 << 8,
+	// где b0 = 110xxxxx, b1 = 10xxxxxx, а значение символа должно быть не меньше 0x80
+	const __m128i codes = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x1f)), 6),
+		_mm_and_si128(_mm_srli_epi16(v, 8), _mm_set1_epi16(0x3f)));
+	const __m128i valid = _mm_andnot_si128(_mm_cmplt_epi16(codes, _mm_set1_epi16(0x80)),
+		_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xc0e0))), _mm_set1_epi16(static_cast<short>(0x80c0))));
+
+	if (_mm_movemask_epi8(valid) != 0xffff)
+		return false;
+
+	StoreWide8(out, codes);
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline bool WideToUtf8x2(char* out, __m128i v, __m128i small) noexcept
+{
+	// 8 символов 0x80..0x7ff: каждый символ c становится 16-битным словом (0xc0 | c >> 6) | (0x80 | c & 0x3f) << 8
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i valid = _mm_and_si128(small, _mm_andnot_si128(
+		_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xff80))), zero),
+		_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xf800))), zero)));
+
+	if (_mm_movemask_epi8(valid) != 0xffff)
+		return false;
+
+	const __m128i lo = _mm_or_si128(_mm_srli_epi16(v, 6), _mm_set1_epi16(0xc0));
+	const __m128i hi = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x3f)), 8), _mm_set1_epi16(-0x8000));
+	Store(out, _mm_or_si128(lo, hi));
+	return true;
+}
+
+#endif // AML_SSE2
+
+#if AML_AVX2
+
+// Для смешанных блоков из 1- и 2-байтовых символов используются таблицы перестановок байт (pshufb). Элемент
+// таблицы задаёт перестановку shuffle и количество count символов (для Utf8ToWide12) или байт (для WideToUtf8x12)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+struct ShuffleEntry final
+{
+	int8_t shuffle[16];
+	uint8_t count;
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+constexpr std::array<ShuffleEntry, 128> MakeUtf8ToWideTable() noexcept
+{
+	// Индекс таблицы - маска первых байт 2-байтовых символов среди первых 7 байт блока. Для каждого
+	// символа в 16-битный элемент помещаются байты b1 | b0 << 8 (2-байтовый символ) или b0 (ASCII)
+	std::array<ShuffleEntry, 128> table = {};
+	for (unsigned mask = 0; mask < 128; ++mask)
+	{
+		auto& entry = table[mask];
+		unsigned count = 0;
+		for (unsigned i = 0; i < 8; ++count)
+		{
+			const bool isLead = (mask >> i) & 1;
+			entry.shuffle[2 * count] = static_cast<int8_t>(isLead ? i + 1 : i);
+			entry.shuffle[2 * count + 1] = static_cast<int8_t>(isLead ? i : -1);
+			i += isLead ? 2 : 1;
+		}
+		for (unsigned i = 2 * count; i < 16; ++i)
+			entry.shuffle[i] = -1;
+		entry.count = static_cast<uint8_t>(count);
+	}
+
+	return table;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+constexpr std::array<ShuffleEntry, 256> MakeWideToUtf8Table() noexcept
+{
+	// Индекс таблицы - маска символов ASCII в блоке из 8 символов. Каждый символ блока
+	// занимает 2 байта, но от символа ASCII в результат попадает только первый из них
+	std::array<ShuffleEntry, 256> table = {};
+	for (unsigned mask = 0; mask < 256; ++mask)
+	{
+		auto& entry = table[mask];
+		unsigned count = 0;
+		for (unsigned i = 0; i < 8; ++i)
+		{
+			entry.shuffle[count++] = static_cast<int8_t>(2 * i);
+			if (!((mask >> i) & 1))
+				entry.shuffle[count++] = static_cast<int8_t>(2 * i + 1);
+		}
+		for (unsigned i = count; i < 16; ++i)
+			entry.shuffle[i] = -1;
+		entry.count = static_cast<uint8_t>(count);
+	}
+
+	return table;
+}
+
+constexpr auto UTF8_TO_WIDE_TABLE = MakeUtf8ToWideTable();
+constexpr auto WIDE_TO_UTF8_TABLE = MakeWideToUtf8Table();
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline size_t Utf8ToWide12(wchar_t*& out, __m128i v) noexcept
+{
+	// Перекодирует первые 8 байт блока, если они содержат только символы ASCII и 2-байтовые последовательности. Если
+	// последний из них - первый байт 2-байтового символа, то перекодируются только 7 байт. Возвращает количество байт
+	const __m128i ascii = _mm_cmpgt_epi8(v, _mm_set1_epi8(-1));
+	const __m128i cont = _mm_cmplt_epi8(v, _mm_set1_epi8(-0x40));
+	const __m128i lead = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(-0x3f)), _mm_cmplt_epi8(v, _mm_set1_epi8(-0x20)));
+	const unsigned leadMask = _mm_movemask_epi8(lead) & 0xff;
+	const unsigned contMask = _mm_movemask_epi8(cont) & 0xff;
+
+	// Кроме символов ASCII и 2-байтовых последовательностей (первый байт 0xc2..0xdf) других байт в блоке быть не
+	// может, а за каждым первым байтом 2-байтового символа (кроме последнего байта блока) следует байт продолжения
+	if (((_mm_movemask_epi8(ascii) | leadMask | contMask) & 0xff) != 0xff || contMask != ((leadMask & 0x7f) << 1))
+		return 0;
+
+	const auto& entry = UTF8_TO_WIDE_TABLE[leadMask & 0x7f];
+	const __m128i t = _mm_shuffle_epi8(v, Load(entry.shuffle));
+	StoreWide8(out, _mm_or_si128(_mm_and_si128(t, _mm_set1_epi16(0x7f)),
+		_mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(t, 8), _mm_set1_epi16(0x1f)), 6)));
+
+	out += entry.count - (leadMask >> 7);
+	return 8 - (leadMask >> 7);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline bool Utf8ToWide3(wchar_t* out, __m128i v) noexcept
+{
+	// Первые 12 байт блока - 4 последовательности 3-байтовых символов. Каждую из них переставляем
+	// в 32-битный элемент как b2 | b1 << 8 | b0 << 16, где b0 = 1110xxxx, b1 и b2 = 10xxxxxx
+	const __m128i t = _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1));
+	const __m128i codes = _mm_or_si128(_mm_or_si128(_mm_and_si128(t, _mm_set1_epi32(0x3f)),
+		_mm_and_si128(_mm_srli_epi32(t, 2), _mm_set1_epi32(0xfc0))), _mm_and_si128(_mm_srli_epi32(t, 4), _mm_set1_epi32(0xf000)));
+
+	// Значение символа должно быть не меньше 0x800 и не должно быть суррогатом
+	__m128i valid = _mm_cmpeq_epi32(_mm_and_si128(t, _mm_set1_epi32(0xf0c0c0)), _mm_set1_epi32(0xe08080));
+	valid = _mm_andnot_si128(_mm_cmplt_epi32(codes, _mm_set1_epi32(0x800)), valid);
+	valid = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(codes, _mm_set1_epi32(0xf800)), _mm_set1_epi32(0xd800)), valid);
+
+	if (_mm_movemask_epi8(valid) != 0xffff)
+		return false;
+
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		const __m128i packed = _mm_shuffle_epi8(codes, _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out), packed);
+	} else
+		Store(out, codes);
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline size_t WideToUtf8x12(char* out, __m128i v, __m128i small) noexcept
+{
+	// Перекодирует 8 символов, если все они меньше 0x800. Возвращает количество записанных байт (или 0)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i valid = _mm_and_si128(small, _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xf800))), zero));
+	if (_mm_movemask_epi8(valid) != 0xffff)
+		return 0;
+
+	const __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xff80))), zero);
+	const __m128i lo = _mm_or_si128(_mm_srli_epi16(v, 6), _mm_set1_epi16(0xc0));
+	const __m128i hi = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x3f)), 8), _mm_set1_epi16(-0x8000));
+	const __m128i bytes = _mm_blendv_epi8(_mm_or_si128(lo, hi), v, ascii);
+
+	const auto& entry = WIDE_TO_UTF8_TABLE[_mm_movemask_epi8(_mm_packs_epi16(ascii, zero))];
+	Store(out, _mm_shuffle_epi8(bytes, Load(entry.shuffle)));
+	return entry.count;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline bool WideToUtf8x3(char* out, __m128i v, __m128i small) noexcept
+{
+	// 4 символа 0x800..0xffff (кроме суррогатов) из первых 4 элементов блока. Каждый из
+	// них переводим в 32-битный элемент b0 | b1 << 8 | b2 << 16 и убираем старшие байты
+	const __m128i codes = _mm_unpacklo_epi16(v, _mm_setzero_si128());
+	__m128i valid = _mm_unpacklo_epi16(small, small);
+	valid = _mm_andnot_si128(_mm_cmplt_epi32(codes, _mm_set1_epi32(0x800)), valid);
+	valid = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(codes, _mm_set1_epi32(0xf800)), _mm_set1_epi32(0xd800)), valid);
+
+	if (_mm_movemask_epi8(valid) != 0xffff)
+		return false;
+
+	const __m128i b0 = _mm_or_si128(_mm_srli_epi32(codes, 12), _mm_set1_epi32(0xe0));
+	const __m128i b1 = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(codes, 6), _mm_set1_epi32(0x3f)), 8);
+	const __m128i b2 = _mm_slli_epi32(_mm_and_si128(codes, _mm_set1_epi32(0x3f)), 16);
+	const __m128i bytes = _mm_or_si128(_mm_or_si128(b0, b1), _mm_or_si128(b2, _mm_set1_epi32(0x808000)));
+	Store(out, _mm_shuffle_epi8(bytes, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1)));
+	return true;
+}
+
+#endif // AML_AVX2
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Проверка строк UTF-8 (AVX2)
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if AML_AVX2
+
+// Класс Utf8Checker проверяет строку UTF-8 блоками по 32 байта без ветвлений (алгоритм Кейзера-Лемира, "Validating UTF-8
+// in less than one instruction per byte"). Большинство ошибок определяется по 12 старшим битам каждой пары соседних байт
+// с помощью трёх 16-элементных таблиц, в которых каждый бит соответствует одному виду ошибки. Оставшиеся ошибки (лишние
+// или недостающие байты продолжения 3- и 4-байтовых последовательностей) определяются сравнением с байтами на 2 и 3
+// позиции раньше. Ошибки накапливаются в регистре m_Error, который проверяется один раз после всех блоков
+
+//--------------------------------------------------------------------------------------------------------------------------------
+class Utf8Checker final
+{
+public:
+	// Проверяет очередной блок строки
+	void Check(__m256i input) noexcept
+	{
+		if (!_mm256_movemask_epi8(input))
+		{
+			// Блок ASCII корректен, если только предыдущий не закончился незавершённой последовательностью
+			m_Error = _mm256_or_si256(m_Error, m_PrevIncomplete);
+		} else
+		{
+			const __m256i prev1 = GetPrev<1>(input);
+			const __m256i special = _mm256_and_si256(_mm256_and_si256(
+				Lookup(BYTE1_HIGH, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), _mm256_set1_epi8(0x0f))),
+				Lookup(BYTE1_LOW, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)))),
+				Lookup(BYTE2_HIGH, _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0x0f))));
+
+			// Байт, который стоит через 1 или 2 позиции после первого байта 3- или 4-байтовой последовательности,
+			// должен быть байтом продолжения. В таблицах этому случаю соответствует бит TWO_CONTS (0x80)
+			const __m256i isThird = _mm256_subs_epu8(GetPrev<2>(input), _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+			const __m256i isFourth = _mm256_subs_epu8(GetPrev<3>(input), _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+			const __m256i must23 = _mm256_and_si256(_mm256_or_si256(isThird, isFourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+			m_Error = _mm256_or_si256(m_Error, _mm256_xor_si256(must23, special));
+
+			// Последовательность не завершена, если один из 3 последних байт блока - первый байт
+			// последовательности, которая не помещается в блок (значения 0xc0, 0xe0 и 0xf0 и больше)
+			m_PrevIncomplete = _mm256_subs_epu8(input, _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+				-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, static_cast<char>(0xf0 - 1), static_cast<char>(0xe0 - 1),
+				static_cast<char>(0xc0 - 1)));
+		}
+
+		m_PrevInput = input;
+	}
+
+	// Возвращает true, если в проверенных блоках была ошибка (вызывается после последнего блока)
+	bool HasError() const noexcept
+	{
+		const __m256i error = _mm256_or_si256(m_Error, m_PrevIncomplete);
+		return !_mm256_testz_si256(error, error);
+	}
+
+private:
+	// Виды ошибок (биты значений в таблицах)
+	static constexpr uint8_t TOO_SHORT = 1 << 0;		// 11______ 0_______ или 11______ 11______
+	static constexpr uint8_t TOO_LONG = 1 << 1;			// 0_______ 10______
+	static constexpr uint8_t OVERLONG_3 = 1 << 2;		// 11100000 100_____
+	static constexpr uint8_t TOO_LARGE = 1 << 3;		// 11110100 1001____ или 11110100 101_____ или 11110101.. 10______
+	static constexpr uint8_t SURROGATE = 1 << 4;		// 11101101 101_____
+	static constexpr uint8_t OVERLONG_2 = 1 << 5;		// 1100000_ 10______
+	static constexpr uint8_t TOO_LARGE_1000 = 1 << 6;	// 11110101.. 1000____
+	static constexpr uint8_t OVERLONG_4 = 1 << 6;		// 11110000 1000____
+	static constexpr uint8_t TWO_CONTS = 1 << 7;		// 10______ 10______
+	static constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+	// Таблицы ошибок по старшим 4 битам первого байта пары, младшим 4 битам первого байта и старшим 4 битам второго байта
+	static constexpr uint8_t BYTE1_HIGH[16] = { TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+		TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4 };
+	static constexpr uint8_t BYTE1_LOW[16] = { CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+		CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+		CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 };
+	static constexpr uint8_t BYTE2_HIGH[16] = { TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT };
+
+	// Возвращает блок, сдвинутый на N байт назад (первые N байт берутся из предыдущего блока)
+	template<int N>
+	__m256i GetPrev(__m256i input) const noexcept
+	{
+		return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(m_PrevInput, input, 0x21), 16 - N);
+	}
+
+	static __m256i Lookup(const uint8_t (&table)[16], __m256i index) noexcept
+	{
+		return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(Load(table)), index);
+	}
+
+	__m256i m_Error = _mm256_setzero_si256();			// Накопленные ошибки
+	__m256i m_PrevInput = _mm256_setzero_si256();		// Предыдущий блок
+	__m256i m_PrevIncomplete = _mm256_setzero_si256();	// Признак незавершённой последовательности в конце предыдущего блока
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+template<class F>
+bool CheckUtf8(const uint8_t* str, size_t size, F&& onBlock) noexcept
+{
+	// Проверяет строку блоками по 32 байта (последний блок дополняется нулями) и для каждого
+	// блока вызывает функцию onBlock. Возвращает true, если строка - корректная строка UTF-8
+	Utf8Checker checker;
+	for (; size >= 32; str += 32, size -= 32)
+	{
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str));
+		checker.Check(v);
+		onBlock(v);
+	}
+
+	if (size)
+	{
+		alignas(32) uint8_t tail[32] = {};
+		memcpy(tail, str, size);
+		const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(tail));
+		checker.Check(v);
+		onBlock(v);
+	}
+
+	return !checker.HasError();
+}
+
+#endif // AML_AVX2
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Перекодирование строк UTF-8/Wide
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t util::Utf8ToWide(wchar_t* out, [[maybe_unused]] size_t outSize, const char* str, size_t size) noexcept
+{
+	auto p = reinterpret_cast<const uint8_t*>(str);
+	const auto end = p + size;
+	wchar_t* const start = out;
+	#if AML_SSE2
+		wchar_t* const outEnd = out + outSize;
+	#endif
+
+	while (p != end)
+	{
+		#if AML_SSE2
+			#if AML_AVX2
+				if (end - p >= 32 && outEnd - out >= 32)
+				{
+					const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+					if (!_mm256_movemask_epi8(v))
+					{
+						StoreAscii16(out, _mm256_castsi256_si128(v));
+						StoreAscii16(out + 16, _mm256_extracti128_si256(v, 1));
+						p += 32, out += 32;
+						continue;
+					}
+				}
+			#endif
+
+			if (end - p >= 16 && outEnd - out >= 16)
+			{
+				const __m128i v = Load(p);
+				if (!_mm_movemask_epi8(v))
+				{
+					StoreAscii16(out, v);
+					p += 16, out += 16;
+					continue;
+				}
+				#if AML_AVX2
+					else if (size_t count = Utf8ToWide12(out, v))
+					{
+						// Смешанный текст (например, кириллица с пробелами и знаками препинания)
+						// обычно идёт длинными отрезками, поэтому обрабатываем его в отдельном цикле
+						do {
+							p += count;
+						} while (end - p >= 16 && outEnd - out >= 16 && (count = Utf8ToWide12(out, Load(p))) != 0);
+						continue;
+					}
+					else if (Utf8ToWide3(out, v))
+					{
+						p += 12, out += 4;
+						continue;
+					}
+				#else
+					else if (Utf8ToWide2(out, v))
+					{
+						p += 16, out += 8;
+						continue;
+					}
+				#endif
+			}
+		#endif
+
+		// Блок содержит символы разных видов (или некорректные последовательности),
+		// поэтому перекодируем его посимвольно, а затем снова пробуем обработать блок
+		for (const auto limit = (end - p > 16) ? p + 16 : end; p < limit;)
+			out = EncodeWide(out, DecodeUtf8(p, end));
+	}
+
+	return out - start;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t util::WideToUtf8(char* out, [[maybe_unused]] size_t outSize, const wchar_t* str, size_t size) noexcept
+{
+	const wchar_t* p = str;
+	const wchar_t* const end = str + size;
+	char* const start = out;
+	#if AML_SSE2
+		char* const outEnd = out + outSize;
+	#endif
+
+	while (p != end)
+	{
+		#if AML_SSE2
+			if (end - p >= 8 && outEnd - out >= 16)
+			{
+				__m128i small;
+				const __m128i v = LoadWide8(p, small);
+				const __m128i ascii = _mm_and_si128(small, _mm_cmpeq_epi16(_mm_and_si128(v,
+					_mm_set1_epi16(static_cast<short>(0xff80))), _mm_setzero_si128()));
+
+				if (_mm_movemask_epi8(ascii) == 0xffff)
+				{
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(v, v));
+					p += 8, out += 8;
+					continue;
+				}
+				#if AML_AVX2
+					else if (const size_t count = WideToUtf8x12(out, v, small))
+					{
+						p += 8, out += count;
+						continue;
+					}
+					else if (WideToUtf8x3(out, v, small))
+					{
+						p += 4, out += 12;
+						continue;
+					}
+				#else
+					else if (WideToUtf8x2(out, v, small))
+					{
+						p += 8, out += 16;
+						continue;
+					}
+				#endif
+			}
+		#endif
+
+		// См. комментарий в функции Utf8ToWide
+		for (const auto limit = (end - p > 8) ? p + 8 : end; p < limit;)
+			out = EncodeUtf8(out, DecodeWide(p, end));
+	}
+
+	return out - start;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Проверка строк UTF-8 и длина перекодированных строк
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------------------------------------
+bool util::ValidateUtf8(std::string_view str) noexcept
+{
+	auto p = reinterpret_cast<const uint8_t*>(str.data());
+	const auto end = p + str.size();
+
+	#if AML_AVX2
+		return CheckUtf8(p, end - p, [](__m256i) {});
+	#else
+		while (p != end)
+		{
+			#if AML_SSE2
+				if (end - p >= 16 && !_mm_movemask_epi8(Load(p)))
+				{
+					p += 16;
+					continue;
+				}
+			#endif
+
+			// Функция DecodeUtf8 возвращает U+FFFD и для некорректных последовательностей, и для самого
+			// символа U+FFFD, поэтому в этом случае дополнительно проверяем исходную последовательность
+			for (const auto limit = (end - p > 16) ? p + 16 : end; p < limit;)
+			{
+				const uint8_t* const from = p;
+				if (DecodeUtf8(p, end) == REPLACEMENT_CHAR && (p - from != 3 || from[0] != 0xef || from[1] != 0xbf || from[2] != 0xbd))
+					return false;
+			}
+		}
+
+		return true;
+	#endif
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t util::WideLengthOf(std::string_view str) noexcept
+{
+	auto p = reinterpret_cast<const uint8_t*>(str.data());
+	const auto end = p + str.size();
+	size_t count = 0;
+
+	#if AML_AVX2
+		// В корректной строке каждый символ начинается с байта, который не является байтом продолжения (0x80..0xbf). Для
+		// 16-битного типа wchar_t каждая 4-байтовая последовательность (первый байт 0xf0..0xf4) даёт суррогатную пару
+		const bool isValid = CheckUtf8(p, end - p, [&](__m256i v) {
+			count += PopCount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(-0x41)))));
+			if constexpr (sizeof(wchar_t) == 2)
+			{
+				const __m256i lead4 = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(static_cast<char>(0xf0))), v);
+				count += PopCount(static_cast<uint32_t>(_mm256_movemask_epi8(lead4)));
+			}
+		});
+
+		// Нули, которыми был дополнен последний блок, тоже были посчитаны
+		if (isValid)
+			return count - (0 - str.size()) % 32;
+
+		// Строка содержит некорректные последовательности, поэтому считаем символы обычным способом
+		count = 0;
+	#endif
+
+	while (p != end)
+	{
+		#if AML_SSE2
+			if (end - p >= 16 && !_mm_movemask_epi8(Load(p)))
+			{
+				p += 16, count += 16;
+				continue;
+			}
+		#endif
+
+		// Блок содержит символы не из ASCII, поэтому считаем его посимвольно
+		for (const auto limit = (end - p > 16) ? p + 16 : end; p < limit;)
+			count += GetWideSize(DecodeUtf8(p, end));
+	}
+
+	return count;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+size_t util::Utf8LengthOf(std::wstring_view str) noexcept
+{
+	const wchar_t* p = str.data();
+	const wchar_t* const end = p + str.size();
+	size_t count = 0;
+
+	while (p != end)
+	{
+		#if AML_SSE2
+			if (end - p >= 8)
+			{
+				// Если в блоке нет суррогатов (и символов больше 0xffff для 32-битного типа wchar_t), то длина
+				// каждого символа в UTF-8 равна 1 байту плюс по 1 байту, если символ не меньше 0x80 и 0x800
+				__m128i small;
+				const __m128i v = LoadWide8(p, small);
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i surrogate = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xf800))),
+					_mm_set1_epi16(static_cast<short>(0xd800)));
+
+				if (_mm_movemask_epi8(_mm_andnot_si128(surrogate, small)) == 0xffff)
+				{
+					const unsigned ascii = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xff80))), zero));
+					const unsigned short2 = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xf800))), zero));
+					count += 24 - (PopCount(ascii) + PopCount(short2)) / 2;
+					p += 8;
+					continue;
+				}
+			}
+		#endif
+
+		// Блок содержит суррогаты или символы больше 0xffff, поэтому считаем его посимвольно
+		for (const auto limit = (end - p > 8) ? p + 8 : end; p < limit;)
+			count += GetUtf8Size(DecodeWide(p, end));
+	}
+
+	return count;
+}
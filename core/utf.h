@@ -0,0 +1,62 @@
+﻿//∙AML
+// Copyright (C) 2026 Dmitry Maslov
+// For conditions of distribution and use, see readme.txt
+
+#pragma once
+
+#include "platform.h"
+
+#include <stddef.h>
+#include <string_view>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Перекодирование строк UTF-8/Wide
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функции этого раздела перекодируют строки между UTF-8 и Wide без использования функций ОС. Строки Wide считаются строками
+// UTF-16, если размер типа wchar_t равен 2 байтам (Windows), или строками UTF-32, если он равен 4 байтам. Некорректные
+// последовательности (в том числе непарные суррогаты) заменяются символом U+FFFD: по одному символу на каждую максимальную
+// часть некорректной последовательности (так же поступают функции MultiByteToWideChar и WideCharToMultiByte). Если макросы
+// AML_SSE2/AML_AVX2 равны 1, то отрезки ASCII, а также отрезки 2- и 3-байтовых символов обрабатываются блоками
+
+// Максимальное количество байт UTF-8, которое может получиться из одного символа wchar_t
+constexpr size_t MAX_UTF8_PER_WIDE = (sizeof(wchar_t) == 2) ? 3 : 4;
+
+// Перекодирует строку UTF-8 str длиной size байт в строку Wide и сохраняет её в out. Буфер out размером outSize символов
+// должен вмещать всю результирующую строку: её точную длину возвращает функция WideLengthOf, но size символов достаточно
+// всегда. Чем больше запас в буфере, тем дольше функция может обрабатывать строку блоками. Возвращает количество
+// записанных символов. Терминирующий 0 не добавляется
+size_t Utf8ToWide(wchar_t* out, size_t outSize, const char* str, size_t size) noexcept;
+
+// Перекодирует строку Wide str длиной size символов в строку UTF-8 и сохраняет её в out. Буфер out размером outSize байт
+// должен вмещать всю результирующую строку: её точную длину возвращает функция Utf8LengthOf, но size * MAX_UTF8_PER_WIDE
+// байт достаточно всегда. Возвращает количество записанных байт. Терминирующий 0 не добавляется
+size_t WideToUtf8(char* out, size_t outSize, const wchar_t* str, size_t size) noexcept;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Проверка строк UTF-8 и длина перекодированных строк
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Функции этого раздела позволяют перекодировать строку за 2 прохода, первый из которых (подсчёт длины) намного быстрее
+// второго. Если макрос AML_AVX2 равен 1, то строки UTF-8 проверяются блоками по 32 байта (алгоритм Кейзера-Лемира),
+// а в противном случае блоками обрабатываются только отрезки ASCII
+
+// Возвращает true, если строка str - корректная строка UTF-8 (без избыточных последовательностей,
+// суррогатов, символов больше U+10FFFF и незавершённых последовательностей)
+bool ValidateUtf8(std::string_view str) noexcept;
+
+// Возвращает длину строки Wide (в символах), которая получится при перекодировании
+// строки UTF-8 str функцией Utf8ToWide, с учётом замены некорректных последовательностей
+size_t WideLengthOf(std::string_view str) noexcept;
+
+// Возвращает длину строки UTF-8 (в байтах), которая получится при перекодировании
+// строки Wide str функцией WideToUtf8, с учётом замены непарных суррогатов
+size_t Utf8LengthOf(std::wstring_view str) noexcept;
+
+} // namespace util
@@ -5,7 +5,11 @@
 #include "pch.h"
 #include "util.h"
 
+#include "console.h"
 #include "debug.h"
+#include "log.h"
+#include "singleton.h"
+#include "sysinfo.h"
 
 namespace util {
 
@@ -90,4 +94,13 @@ AML_NOINLINE bool CheckMinimalRequirements(bool terminateIfFailed)
 	return false;
 }
 
+//--------------------------------------------------------------------------------------------------------------------------------
+void InitSystemSingletons(bool withConsole, bool concurrently)
+{
+	if (withConsole)
+		CreateSingletons<SystemInfo, SystemConsole, SystemLog>(concurrently);
+	else
+		CreateSingletons<SystemInfo, SystemLog>(concurrently);
+}
+
 } // namespace util
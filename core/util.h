@@ -6,10 +6,15 @@
 
 #include "platform.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <type_traits>
 
+#if AML_OS_WINDOWS
+	#include <intrin.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //   Макросы
@@ -43,7 +48,7 @@
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-//   Функция CheckMinimalRequirements
+//   Функции CheckMinimalRequirements и InitSystemSingletons
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -54,6 +59,12 @@ namespace util {
 // true, то работа приложения будет аварийно завершена вызовом функции DebugHelper::Abort
 bool CheckMinimalRequirements(bool terminateIfFailed = true);
 
+// Создаёт системные синглтоны SystemInfo, SystemLog и, если параметр withConsole равен true, SystemConsole (а также
+// синглтоны, от которых они зависят). Если параметр concurrently равен true, то независимые синглтоны создаются
+// одновременно в разных потоках. Вызов функции необязателен (синглтоны создаются по требованию), но позволяет
+// ускорить запуск приложения, если сделать его в самом начале работы (сразу после CheckMinimalRequirements)
+void InitSystemSingletons(bool withConsole, bool concurrently = true);
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //   Функции Is*Build для проверки параметров сборки в run-time
@@ -150,6 +161,68 @@ inline uint64_t ByteSwap64(uint64_t value) noexcept
 	#endif
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//   Функции CountTrailingZeros и PopCount
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Возвращает номер младшего установленного бита значения value. Значение value не должно быть равно 0
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline unsigned CountTrailingZeros(uint32_t value) noexcept
+{
+	#if AML_OS_WINDOWS
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return index;
+	#else
+		// Умножение изолированного младшего бита на последовательность де Брёйна даёт уникальные старшие 5 бит
+		static constexpr uint8_t table[32] = { 0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+			31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9 };
+		return table[((value & (0 - value)) * 0x077cb531u) >> 27];
+	#endif
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline unsigned CountTrailingZeros(uint64_t value) noexcept
+{
+	#if AML_OS_WINDOWS && AML_64BIT
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+	#else
+		const uint32_t lo = static_cast<uint32_t>(value);
+		return lo ? CountTrailingZeros(lo) : 32 + CountTrailingZeros(static_cast<uint32_t>(value >> 32));
+	#endif
+}
+
+// Возвращает количество установленных битов значения value
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline unsigned PopCount(uint32_t value) noexcept
+{
+	#if AML_OS_WINDOWS && AML_AVX2
+		// Инструкция popcnt есть на всех процессорах с поддержкой AVX2,
+		// но может отсутствовать на более старых процессорах
+		return __popcnt(value);
+	#else
+		value -= (value >> 1) & 0x55555555;
+		value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+		return (((value + (value >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+	#endif
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+inline unsigned PopCount(uint64_t value) noexcept
+{
+	#if AML_OS_WINDOWS && AML_AVX2 && AML_64BIT
+		return static_cast<unsigned>(__popcnt64(value));
+	#else
+		return PopCount(static_cast<uint32_t>(value)) + PopCount(static_cast<uint32_t>(value >> 32));
+	#endif
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //   Функция CountOf
@@ -50,6 +50,7 @@ using namespace util;
 
 bool WinAPI::s_IsLoaded;
 
+AML_IMPLEMENT_WINAPI_FN(GetLargePageMinimum);
 AML_IMPLEMENT_WINAPI_FN(GetTickCount64);
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -57,6 +58,7 @@ AML_NOINLINE void WinAPI::Load() noexcept
 {
 	if (HMODULE kernel32 = ::GetModuleHandleA("kernel32.dll"))
 	{
+		AML_LOAD_WINAPI_FN(kernel32, GetLargePageMinimum);
 		AML_LOAD_WINAPI_FN(kernel32, GetTickCount64);
 	}
 
@@ -63,6 +63,9 @@ namespace winapi {
 // noexcept(true) никак не поможет компилятору в оптимизации их вызовов (пролог и эпилог всё равно
 // будут добавлены, так как стандарт требует обеспечения гарантии невыброса исключений)
 
+// Windows Server 2003
+using GetLargePageMinimumFn = SIZE_T (WINAPI*)();
+
 // Windows Server 2008 / Windows Vista
 using GetTickCount64Fn = ULONGLONG (WINAPI*)();
 
@@ -86,6 +89,7 @@ using GetTickCount64Fn = ULONGLONG (WINAPI*)();
 //--------------------------------------------------------------------------------------------------------------------------------
 struct WinAPI final
 {
+	AML_DECLARE_WINAPI_FN(GetLargePageMinimum)
 	AML_DECLARE_WINAPI_FN(GetTickCount64)
 
 private:
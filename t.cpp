@@ -0,0 +1,3 @@
+#include "unicase.h"
+#include <cstdio>
+int main(){ for(unsigned c=0;c<0x110000;c++) printf("%x %x %x %x\n", c, (unsigned)util::ToLowerChar(c),(unsigned)util::ToUpperChar(c),(unsigned)util::FoldCaseChar(c)); }
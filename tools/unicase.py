@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# AML
+# Copyright (C) 2026 Dmitry Maslov
+# For conditions of distribution and use, see readme.txt
+
+# Генерирует таблицы преобразования регистра в файле core/unicase.cpp (от строки с константой MAX_CASED_CHAR
+# до конца массива CASE_RECORDS) из файлов UnicodeData.txt и CaseFolding.txt базы символов Unicode (UCD).
+# Использование: python3 tools/unicase.py UnicodeData.txt CaseFolding.txt [core/unicase.cpp]
+
+import re
+import sys
+
+BLOCK_SHIFT = 7
+BLOCK_SIZE = 1 << BLOCK_SHIFT
+
+
+def load_mappings(unicode_data, case_folding):
+	"""Возвращает словарь: код символа -> (нижний регистр, верхний регистр, свёртка регистра)"""
+	lower, upper, fold = {}, {}, {}
+	with open(unicode_data, encoding='utf-8') as f:
+		for line in f:
+			fields = line.rstrip('\n').split(';')
+			if len(fields) < 15:
+				continue
+			cp = int(fields[0], 16)
+			if fields[12]:
+				upper[cp] = int(fields[12], 16)
+			if fields[13]:
+				lower[cp] = int(fields[13], 16)
+
+	# Простая свёртка регистра - статусы C (общая) и S (простая); статусы F и T не используются
+	with open(case_folding, encoding='utf-8') as f:
+		for line in f:
+			line = line.split('#', 1)[0].strip()
+			if not line:
+				continue
+			code, status, mapping = (s.strip() for s in line.split(';')[:3])
+			if status in ('C', 'S'):
+				fold[int(code, 16)] = int(mapping, 16)
+
+	result = {}
+	for cp in set(lower) | set(upper) | set(fold):
+		result[cp] = (lower.get(cp, cp), upper.get(cp, cp), fold.get(cp, cp))
+	return result
+
+
+def rows(values, per_row, fmt, indent='\t'):
+	lines = [indent + ', '.join(fmt(v) for v in values[i:i + per_row]) + ','
+		for i in range(0, len(values), per_row)]
+	lines[-1] = lines[-1][:-1]
+	return lines
+
+
+def make_tables(mappings):
+	# Записи хранят разности между кодами, поэтому символы с одинаковым сдвигом (например, все латинские
+	# заглавные буквы) используют одну запись. Запись с индексом 0 означает отсутствие преобразования
+	records = {cp: (lo - cp, up - cp, fo - cp) for cp, (lo, up, fo) in mappings.items()}
+	records = {cp: r for cp, r in records.items() if r != (0, 0, 0)}
+	max_char = max(records) + 1
+
+	triples = [(0, 0, 0)] + sorted(set(records.values()))
+	triple_index = {t: i for i, t in enumerate(triples)}
+	if len(triples) > 256:
+		sys.exit('too many case records for uint8_t indices')
+
+	blocks, block_index, index = [], {}, []
+	for b in range((max_char + BLOCK_SIZE - 1) // BLOCK_SIZE):
+		block = tuple(triple_index[records.get(b * BLOCK_SIZE + i, (0, 0, 0))] for i in range(BLOCK_SIZE))
+		if block not in block_index:
+			block_index[block] = len(blocks)
+			blocks.append(block)
+		index.append(block_index[block])
+	if len(blocks) > 256:
+		sys.exit('too many case blocks for uint8_t indices')
+
+	out = [
+		f'constexpr char32_t MAX_CASED_CHAR = 0x{max_char:x};',
+		f'constexpr unsigned CASE_BLOCK_SHIFT = {BLOCK_SHIFT};',
+		'',
+		f'const uint8_t CASE_INDEX[{len(index)}] = {{',
+	]
+	out += rows(index, 28, str)
+	out += ['};', '', f'const uint8_t CASE_BLOCKS[{len(blocks)}][{BLOCK_SIZE}] = {{']
+	for i, block in enumerate(blocks):
+		out.append('\t{')
+		out += rows(list(block), 24, str, '\t\t')
+		out.append('\t}' + (',' if i + 1 < len(blocks) else ''))
+	out += ['};', '', f'const CaseRecord CASE_RECORDS[{len(triples)}] = {{']
+	out += rows(triples, 5, lambda t: '{ %d, %d, %d }' % t)
+	out.append('};')
+	return out
+
+
+def main():
+	if len(sys.argv) not in (3, 4):
+		sys.exit('usage: unicase.py UnicodeData.txt CaseFolding.txt [unicase.cpp]')
+	target = sys.argv[3] if len(sys.argv) == 4 else 'core/unicase.cpp'
+	tables = make_tables(load_mappings(sys.argv[1], sys.argv[2]))
+
+	with open(target, encoding='utf-8', newline='') as f:
+		text = f.read()
+	eol = '\r\n' if '\r\n' in text else '\n'
+	pattern = re.compile(r'^constexpr char32_t MAX_CASED_CHAR = .*?^const CaseRecord CASE_RECORDS\[\d+\] = \{.*?^\};',
+		re.M | re.S)
+	text, count = pattern.subn(lambda _: eol.join(tables), text)
+	if count != 1:
+		sys.exit(f'case tables not found in {target}')
+
+	with open(target, 'w', encoding='utf-8', newline='') as f:
+		f.write(text)
+
+
+if __name__ == '__main__':
+	main()